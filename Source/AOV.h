@@ -0,0 +1,61 @@
+#pragma once
+
+#include <string>
+#include <format>
+#include <unordered_map>
+
+//Auxiliary outputs of the first surface a camera path hits, accumulated next to the image when enabled. Color is the
+//image itself. Normals are in world space and depth is along the view axis, the ids are -1 where the path missed
+enum class AOV
+{
+	Color, Albedo, Normal, Depth, MaterialID, ObjectID
+};
+
+template<>
+struct std::formatter<AOV> : std::formatter<std::string>
+{
+	auto format(const AOV& aov, format_context& ctx) const
+	{
+		if (aov == AOV::Color)
+			return std::formatter<std::string>::format(std::format("{}", "Color"), ctx);
+
+		if (aov == AOV::Albedo)
+			return std::formatter<std::string>::format(std::format("{}", "Albedo"), ctx);
+
+		if (aov == AOV::Normal)
+			return std::formatter<std::string>::format(std::format("{}", "Normal"), ctx);
+
+		if (aov == AOV::Depth)
+			return std::formatter<std::string>::format(std::format("{}", "Depth"), ctx);
+
+		if (aov == AOV::MaterialID)
+			return std::formatter<std::string>::format(std::format("{}", "MaterialID"), ctx);
+
+		if (aov == AOV::ObjectID)
+			return std::formatter<std::string>::format(std::format("{}", "ObjectID"), ctx);
+
+		else
+			return std::formatter<std::string>::format(std::format("{}", "<Invalid AOV>"), ctx);
+	}
+};
+
+const std::unordered_map<std::string, AOV> AOVMap =
+{
+	std::pair("Color", AOV::Color),
+	std::pair("Albedo", AOV::Albedo),
+	std::pair("Normal", AOV::Normal),
+	std::pair("Depth", AOV::Depth),
+	std::pair("MaterialID", AOV::MaterialID),
+	std::pair("ObjectID", AOV::ObjectID)
+};
+
+//Floats per pixel GetAOV returns
+const std::unordered_map<AOV, int> AOVChannelMap =
+{
+	std::pair(AOV::Color, 3),
+	std::pair(AOV::Albedo, 3),
+	std::pair(AOV::Normal, 3),
+	std::pair(AOV::Depth, 1),
+	std::pair(AOV::MaterialID, 1),
+	std::pair(AOV::ObjectID, 1)
+};
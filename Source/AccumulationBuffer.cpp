@@ -0,0 +1,239 @@
+#include "AccumulationBuffer.h"
+
+#include <print>
+#include <algorithm>
+
+#include "LightTree.h"
+
+void AccumulationBuffer::Resize(const int& Width, const int& Height)
+{
+	m_Width = Width;
+	m_Height = Height;
+
+	const size_t count = (size_t)Width * Height;
+	m_Color.assign(count, glm::vec3(0.0f));
+	m_LuminanceSquares.assign(count, 0.0f);
+	m_Samples.assign(count, 0);
+	SetAOVs(m_AOVs);
+}
+
+void AccumulationBuffer::SetAOVs(const bool& enabled)
+{
+	m_AOVs = enabled;
+
+	const size_t count = m_AOVs ? m_Color.size() : 0;
+	m_Albedo.assign(count, glm::vec3(0.0f));
+	m_Normal.assign(count, glm::vec3(0.0f));
+	m_Depth.assign(count, 0.0f);
+	m_MaterialID.assign(count, -1);
+	m_ObjectID.assign(count, -1);
+
+	if (count == 0)
+	{
+		m_Albedo.shrink_to_fit();
+		m_Normal.shrink_to_fit();
+		m_Depth.shrink_to_fit();
+		m_MaterialID.shrink_to_fit();
+		m_ObjectID.shrink_to_fit();
+	}
+}
+
+bool AccumulationBuffer::HasAOVs() const
+{
+	return m_AOVs;
+}
+
+void AccumulationBuffer::Clear()
+{
+	std::fill(m_Color.begin(), m_Color.end(), glm::vec3(0.0f));
+	std::fill(m_LuminanceSquares.begin(), m_LuminanceSquares.end(), 0.0f);
+	std::fill(m_Samples.begin(), m_Samples.end(), 0);
+	std::fill(m_Albedo.begin(), m_Albedo.end(), glm::vec3(0.0f));
+	std::fill(m_Normal.begin(), m_Normal.end(), glm::vec3(0.0f));
+	std::fill(m_Depth.begin(), m_Depth.end(), 0.0f);
+	std::fill(m_MaterialID.begin(), m_MaterialID.end(), -1);
+	std::fill(m_ObjectID.begin(), m_ObjectID.end(), -1);
+}
+
+void AccumulationBuffer::AddSample(const size_t& pixel, const glm::vec3& color)
+{
+	const float luminance = LightTree::Luminance(color);
+	m_Color[pixel] += color;
+	m_LuminanceSquares[pixel] += luminance * luminance;
+	m_Samples[pixel]++;
+}
+
+//Goes with the AddSample of the same path, after it. The ids are those of the first sample, an average wouldn't name anything
+void AccumulationBuffer::AddAOVs(const size_t& pixel, const glm::vec3& albedo, const glm::vec3& normal, const float& depth, const int& MaterialID, const int& ObjectID)
+{
+	m_Albedo[pixel] += albedo;
+	m_Normal[pixel] += normal;
+	m_Depth[pixel] += depth;
+	if (m_Samples[pixel] > 1)
+		return;
+
+	m_MaterialID[pixel] = MaterialID;
+	m_ObjectID[pixel] = ObjectID;
+}
+
+//Adds the samples of other to these. Its AOVs are dropped if these have none, but without them the AOVs here would
+//no longer cover every sample, so that merge is refused
+bool AccumulationBuffer::Merge(const AccumulationBuffer& other)
+{
+	if (other.m_Width != m_Width || other.m_Height != m_Height)
+	{
+		std::println("Cannot merge a {}x{} accumulation buffer into a {}x{} one", other.m_Width, other.m_Height, m_Width, m_Height);
+		return false;
+	}
+
+	if (m_AOVs && !other.m_AOVs)
+	{
+		std::println("Cannot merge an accumulation buffer without AOVs into one with them");
+		return false;
+	}
+
+	for (size_t i = 0; i < m_Color.size(); i++)
+	{
+		if (m_AOVs)
+		{
+			m_Albedo[i] += other.m_Albedo[i];
+			m_Normal[i] += other.m_Normal[i];
+			m_Depth[i] += other.m_Depth[i];
+			if (m_Samples[i] == 0)
+			{
+				m_MaterialID[i] = other.m_MaterialID[i];
+				m_ObjectID[i] = other.m_ObjectID[i];
+			}
+		}
+
+		m_Color[i] += other.m_Color[i];
+		m_LuminanceSquares[i] += other.m_LuminanceSquares[i];
+		m_Samples[i] += other.m_Samples[i];
+	}
+
+	return true;
+}
+
+void AccumulationBuffer::SetSums(const size_t& pixel, const glm::vec3& ColorSum, const float& LuminanceSquareSum, const uint32_t& samples)
+{
+	m_Color[pixel] = ColorSum;
+	m_LuminanceSquares[pixel] = LuminanceSquareSum;
+	m_Samples[pixel] = samples;
+}
+
+void AccumulationBuffer::SetAOVSums(const size_t& pixel, const glm::vec3& AlbedoSum, const glm::vec3& NormalSum, const float& DepthSum, const int& MaterialID, const int& ObjectID)
+{
+	m_Albedo[pixel] = AlbedoSum;
+	m_Normal[pixel] = NormalSum;
+	m_Depth[pixel] = DepthSum;
+	m_MaterialID[pixel] = MaterialID;
+	m_ObjectID[pixel] = ObjectID;
+}
+
+int AccumulationBuffer::GetWidth() const
+{
+	return m_Width;
+}
+
+int AccumulationBuffer::GetHeight() const
+{
+	return m_Height;
+}
+
+size_t AccumulationBuffer::Size() const
+{
+	return m_Color.size();
+}
+
+uint32_t AccumulationBuffer::Samples(const size_t& pixel) const
+{
+	return m_Samples[pixel];
+}
+
+glm::vec3 AccumulationBuffer::ColorSum(const size_t& pixel) const
+{
+	return m_Color[pixel];
+}
+
+float AccumulationBuffer::LuminanceSquareSum(const size_t& pixel) const
+{
+	return m_LuminanceSquares[pixel];
+}
+
+glm::vec3 AccumulationBuffer::Mean(const size_t& pixel) const
+{
+	return m_Samples[pixel] > 0 ? m_Color[pixel] / (float)m_Samples[pixel] : glm::vec3(0.0f);
+}
+
+//Of the mean luminance, from the unbiased variance of the samples. A single sample says nothing about it, so it gets
+//its own squared luminance
+float AccumulationBuffer::Variance(const size_t& pixel) const
+{
+	const float n = (float)m_Samples[pixel];
+	if (n <= 1.0f)
+		return m_LuminanceSquares[pixel];
+
+	const float mean = LightTree::Luminance(m_Color[pixel]) / n;
+	return std::max(m_LuminanceSquares[pixel] / n - mean * mean, 0.0f) / (n - 1.0f);
+}
+
+//Squared relative error of the mean as Accumulator.glsl estimates it, 1 until there are two samples
+float AccumulationBuffer::SquaredError(const size_t& pixel) const
+{
+	const float n = (float)m_Samples[pixel];
+	if (n <= 1.0f)
+		return 1.0f;
+
+	const float mean = LightTree::Luminance(m_Color[pixel]) / n;
+	return Variance(pixel) / ((mean + 0.1f) * (mean + 0.1f));
+}
+
+std::vector<glm::vec3> AccumulationBuffer::MeanImage() const
+{
+	std::vector<glm::vec3> image(m_Color.size());
+	for (size_t i = 0; i < image.size(); i++)
+		image[i] = Mean(i);
+
+	return image;
+}
+
+glm::vec3 AccumulationBuffer::AlbedoSum(const size_t& pixel) const
+{
+	return m_Albedo[pixel];
+}
+
+glm::vec3 AccumulationBuffer::NormalSum(const size_t& pixel) const
+{
+	return m_Normal[pixel];
+}
+
+float AccumulationBuffer::DepthSum(const size_t& pixel) const
+{
+	return m_Depth[pixel];
+}
+
+glm::vec3 AccumulationBuffer::Albedo(const size_t& pixel) const
+{
+	return m_Samples[pixel] > 0 ? m_Albedo[pixel] / (float)m_Samples[pixel] : glm::vec3(0.0f);
+}
+
+//Averaged like the rest, so shorter than 1 where the samples disagree
+glm::vec3 AccumulationBuffer::Normal(const size_t& pixel) const
+{
+	return m_Samples[pixel] > 0 ? m_Normal[pixel] / (float)m_Samples[pixel] : glm::vec3(0.0f);
+}
+
+float AccumulationBuffer::Depth(const size_t& pixel) const
+{
+	return m_Samples[pixel] > 0 ? m_Depth[pixel] / (float)m_Samples[pixel] : 0.0f;
+}
+
+int AccumulationBuffer::MaterialID(const size_t& pixel) const
+{
+	return m_MaterialID[pixel];
+}
+
+int AccumulationBuffer::ObjectID(const size_t& pixel) const
+{
+	return m_ObjectID[pixel];
+}
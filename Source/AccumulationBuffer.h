@@ -0,0 +1,62 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+
+#include <glm.hpp>
+
+//Per pixel sums of everything a render accumulates, color, squared luminance and the AOVs when they're on, next to the
+//number of samples behind them. Sums rather than running means, so buffers rendered apart, by either backend, in
+//several passes or on other machines, merge by adding them up as long as they drew different samples. Rows are in the
+//order both tracers keep them, bottom up for RayTracer's textures
+class AccumulationBuffer
+{
+public:
+	void Resize(const int& Width, const int& Height);
+	void SetAOVs(const bool& enabled);
+	bool HasAOVs() const;
+	void Clear();
+
+	void AddSample(const size_t& pixel, const glm::vec3& color);
+	void AddAOVs(const size_t& pixel, const glm::vec3& albedo, const glm::vec3& normal, const float& depth, const int& MaterialID, const int& ObjectID);
+	bool Merge(const AccumulationBuffer& other);
+
+	void SetSums(const size_t& pixel, const glm::vec3& ColorSum, const float& LuminanceSquareSum, const uint32_t& samples);
+	void SetAOVSums(const size_t& pixel, const glm::vec3& AlbedoSum, const glm::vec3& NormalSum, const float& DepthSum, const int& MaterialID, const int& ObjectID);
+
+	int GetWidth() const;
+	int GetHeight() const;
+	size_t Size() const;
+
+	uint32_t Samples(const size_t& pixel) const;
+	glm::vec3 ColorSum(const size_t& pixel) const;
+	float LuminanceSquareSum(const size_t& pixel) const;
+	glm::vec3 Mean(const size_t& pixel) const;
+	float Variance(const size_t& pixel) const;
+	float SquaredError(const size_t& pixel) const;
+	std::vector<glm::vec3> MeanImage() const;
+
+	glm::vec3 AlbedoSum(const size_t& pixel) const;
+	glm::vec3 NormalSum(const size_t& pixel) const;
+	float DepthSum(const size_t& pixel) const;
+	glm::vec3 Albedo(const size_t& pixel) const;
+	glm::vec3 Normal(const size_t& pixel) const;
+	float Depth(const size_t& pixel) const;
+	int MaterialID(const size_t& pixel) const;
+	int ObjectID(const size_t& pixel) const;
+
+private:
+	int m_Width = 0;
+	int m_Height = 0;
+	bool m_AOVs = false;
+
+	std::vector<glm::vec3> m_Color;
+	std::vector<float> m_LuminanceSquares;
+	std::vector<uint32_t> m_Samples;
+
+	std::vector<glm::vec3> m_Albedo;											//AOV planes, empty while they're off
+	std::vector<glm::vec3> m_Normal;
+	std::vector<float> m_Depth;
+	std::vector<int> m_MaterialID;												//Of the first sample, -1 where it missed
+	std::vector<int> m_ObjectID;
+};
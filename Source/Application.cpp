@@ -24,6 +24,9 @@
 #include "Scene.h"
 #include "HalogenUI.h"
 #include "Renderer.h"
+#include "Benchmark.h"
+#include "FrameScheduler.h"
+#include "Navigation.h"
 
 #include <iostream>
 #include <print>
@@ -222,6 +225,9 @@ ImGuiIO& SetupImGui(GLFWwindow* window)
 
 int main(int argc, char** argv)
 {
+	if (argc > 1 && std::string(argv[1]) == "--benchmark")
+		return Benchmark::Run(argc, argv);
+
 	glfwInit();
 	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
 	glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
@@ -259,7 +265,7 @@ int main(int argc, char** argv)
 	glfwSetCursorPosCallback(window, mouse_callback);
 	glfwSetScrollCallback(window, scroll_callback);
 
-	glfwSwapInterval(1);
+	glfwSwapInterval(0);																//FrameScheduler paces the frames, see below
 
 	ImGuiIO& io = SetupImGui(window);
 
@@ -285,10 +291,21 @@ int main(int argc, char** argv)
 	RayTracer.StartAccumulation(RenderedImage, AccumulatedImage);
 	renderer.SetDisplayImage(RenderedImage);
 
+	FrameScheduler scheduler;
+	Navigation navigation(RenderResolutionX, RenderResolutionY);
+	const double IdleWait = 0.1;														//Seconds between frames with nothing to trace
+
 	float SinceLastSceneSave = 0.0;
 	float SinceLastRender = 0.0;
 	while (!glfwWindowShouldClose(window))
 	{
+		if (glfwGetWindowAttrib(window, GLFW_ICONIFIED))
+		{
+			glfwWaitEvents();
+			continue;
+		}
+
+		scheduler.BeginFrame();
 		ProcessInput(window);
 		glfwPollEvents();
 
@@ -323,6 +340,8 @@ int main(int argc, char** argv)
 			renderer.SetShift(Shift);
 		}
 
+		navigation.Update(RayTracer, scene, scheduler, MoveEnable && (Turn || Move), deltaTime);
+
 		if (SaveImage)
 		{
 			SaveRender("render.jpg", RayTracer);
@@ -346,15 +365,24 @@ int main(int argc, char** argv)
 		ImGui::NewFrame();
 		ImGui::DockSpaceOverViewport(0, ImGui::GetMainViewport(), ImGuiDockNodeFlags_PassthruCentralNode);
 
-		HalogenUI::RenderSettings(renderer, RayTracer, scene, io, SinceLastSceneSave, SinceLastRender);
+		HalogenUI::RenderSettings(renderer, RayTracer, scene, scheduler, navigation, io, SinceLastSceneSave, SinceLastRender);
 		HalogenUI::SceneSettings(RayTracer, scene);
 		HalogenUI::MaterialSettings(RayTracer, scene);
 
-		RayTracer.Accumulate();
-		RayTracer.Accumulate();
-		RayTracer.Accumulate();
-		RayTracer.Accumulate();
-		RayTracer.Accumulate();
+		//As many samples as the frame budget leaves room for, in passes of the size RayTracer tunes, or the one sample of
+		//a navigation frame. Finished shares the moments the UI read back this frame, see RayTracer::Average
+		const int FrameSamples = RayTracer.Finished() ? 0 : navigation.Active() ? 1 : scheduler.FrameSamples(RayTracer.SampleTime());
+		int traced = 0;
+		while (traced < FrameSamples)
+		{
+			const unsigned int before = RayTracer.RenderedSamples();
+			RayTracer.Accumulate(FrameSamples - traced);
+			if (RayTracer.RenderedSamples() == before)
+				break;
+
+			traced += RayTracer.RenderedSamples() - before;
+		}
+		scheduler.AddSamples(traced, RayTracer.SampleTime());
 
 		RayTracer.PostProcess();
 
@@ -371,6 +399,10 @@ int main(int argc, char** argv)
 		}
 
 		glfwSwapBuffers(window);
+		scheduler.EndFrame();
+
+		if (traced == 0)
+			glfwWaitEventsTimeout(IdleWait);
 	}
 
 	ImGui_ImplOpenGL3_Shutdown();
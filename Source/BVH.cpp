@@ -0,0 +1,438 @@
+#include "BVH.h"
+
+#include <algorithm>
+#include <cfloat>
+
+#include "SphereIntersect.h"
+
+static float SurfaceArea(const glm::vec3& Min, const glm::vec3& Max)
+{
+	const glm::vec3 extent = glm::max(Max - Min, glm::vec3(0.0f));
+	return 2.0f * (extent.x * extent.y + extent.y * extent.z + extent.z * extent.x);
+}
+
+void SphereBVH::Build(const SphereStore& spheres, const int& MaxLeafSize)
+{
+	Clear();
+	m_MaxLeafSize = std::max(MaxLeafSize, 1);
+
+	const uint32_t count = (uint32_t)spheres.Size();
+	if (count == 0)
+		return;
+
+	std::vector<BuildPrimitive> primitives(count);
+	for (uint32_t i = 0; i < count; i++)
+	{
+		const glm::vec3 center = spheres.Position(i);
+		const glm::vec3 radius = glm::vec3(std::abs(spheres.Radius(i)));
+
+		primitives[i].Min = center - radius;
+		primitives[i].Max = center + radius;
+		primitives[i].Centroid = center;
+		primitives[i].Slot = i;
+	}
+
+	m_Nodes.reserve(2 * count / m_MaxLeafSize + 1);
+	BuildNode(primitives, 0, count, 0);
+
+	m_Primitives.resize(count);
+	m_LeafSpheres.resize(count);
+	m_SlotEntry.resize(count);
+	for (uint32_t i = 0; i < count; i++)
+	{
+		const uint32_t slot = primitives[i].Slot;
+		m_Primitives[i] = slot;
+		m_SlotEntry[slot] = i;
+		m_LeafSpheres[i] = glm::vec4(spheres.Position(slot), spheres.Radius(slot));
+	}
+
+	m_Parents.assign(m_Nodes.size(), UINT32_MAX);
+	m_EntryLeaf.resize(count);
+	m_CostSum = 0.0;
+	for (uint32_t index = 0; index < m_Nodes.size(); index++)
+	{
+		const BVHNode& node = m_Nodes[index];
+		m_CostSum += NodeCost(node);
+
+		if (node.Count > 0)
+		{
+			for (uint32_t i = node.Offset; i < node.Offset + node.Count; i++)
+				m_EntryLeaf[i] = index;
+		}
+
+		else
+		{
+			m_Parents[index + 1] = index;
+			m_Parents[node.Offset] = index;
+		}
+	}
+
+	m_BuildCost = SAHCost();
+}
+
+//Moves one sphere and grows or shrinks the boxes above it, stopping once a box comes out unchanged
+void SphereBVH::Refit(const SphereStore& spheres, const size_t& slot, std::vector<uint32_t>& ChangedNodes)
+{
+	const uint32_t entry = m_SlotEntry[slot];
+	m_LeafSpheres[entry] = glm::vec4(spheres.Position(slot), spheres.Radius(slot));
+
+	uint32_t index = m_EntryLeaf[entry];
+	while (index != UINT32_MAX)
+	{
+		BVHNode& node = m_Nodes[index];
+		glm::vec3 Min, Max;
+
+		if (node.Count > 0)
+		{
+			Min = glm::vec3(FLT_MAX);
+			Max = glm::vec3(-FLT_MAX);
+			for (uint32_t i = node.Offset; i < node.Offset + node.Count; i++)
+			{
+				const glm::vec3 center = glm::vec3(m_LeafSpheres[i].x, m_LeafSpheres[i].y, m_LeafSpheres[i].z);
+				const glm::vec3 radius = glm::vec3(std::abs(m_LeafSpheres[i].w));
+				Min = glm::min(Min, center - radius);
+				Max = glm::max(Max, center + radius);
+			}
+		}
+
+		else
+		{
+			const BVHNode& left = m_Nodes[index + 1];
+			const BVHNode& right = m_Nodes[node.Offset];
+			Min = glm::min(left.Min, right.Min);
+			Max = glm::max(left.Max, right.Max);
+		}
+
+		if (Min == node.Min && Max == node.Max)
+			break;
+
+		m_CostSum -= NodeCost(node);
+		node.Min = Min;
+		node.Max = Max;
+		m_CostSum += NodeCost(node);
+
+		ChangedNodes.push_back(index);
+		index = m_Parents[index];
+	}
+}
+
+bool SphereBVH::Degraded(const float& threshold) const
+{
+	return !m_Nodes.empty() && SAHCost() > m_BuildCost * threshold;
+}
+
+uint32_t SphereBVH::BuildNode(std::vector<BuildPrimitive>& primitives, const uint32_t& begin, const uint32_t& end, const int& depth)
+{
+	const uint32_t index = (uint32_t)m_Nodes.size();
+	m_Nodes.emplace_back();
+
+	glm::vec3 Min = primitives[begin].Min;
+	glm::vec3 Max = primitives[begin].Max;
+	glm::vec3 CentroidMin = primitives[begin].Centroid;
+	glm::vec3 CentroidMax = primitives[begin].Centroid;
+	for (uint32_t i = begin + 1; i < end; i++)
+	{
+		Min = glm::min(Min, primitives[i].Min);
+		Max = glm::max(Max, primitives[i].Max);
+		CentroidMin = glm::min(CentroidMin, primitives[i].Centroid);
+		CentroidMax = glm::max(CentroidMax, primitives[i].Centroid);
+	}
+
+	m_Nodes[index].Min = Min;
+	m_Nodes[index].Max = Max;
+
+	//Past the traversal stack depth the subtree becomes one big leaf, slow but never missing a sphere
+	const uint32_t count = end - begin;
+	if (count <= (uint32_t)m_MaxLeafSize || depth >= StackSize - 1)
+	{
+		m_Nodes[index].Offset = begin;
+		m_Nodes[index].Count = count;
+		return index;
+	}
+
+	struct Bin
+	{
+		glm::vec3 Min = glm::vec3(FLT_MAX);
+		glm::vec3 Max = glm::vec3(-FLT_MAX);
+		uint32_t Count = 0;
+	};
+
+	float BestCost = FLT_MAX;
+	int BestAxis = -1;
+	int BestSplit = 0;
+
+	for (int axis = 0; axis < 3; axis++)
+	{
+		const float extent = CentroidMax[axis] - CentroidMin[axis];
+		if (extent <= 0.0f)
+			continue;
+
+		Bin bins[BinCount];
+		const float scale = BinCount / extent;
+		for (uint32_t i = begin; i < end; i++)
+		{
+			const int b = std::min((int)((primitives[i].Centroid[axis] - CentroidMin[axis]) * scale), BinCount - 1);
+			bins[b].Min = glm::min(bins[b].Min, primitives[i].Min);
+			bins[b].Max = glm::max(bins[b].Max, primitives[i].Max);
+			bins[b].Count++;
+		}
+
+		//Sweep from the right first so every split plane gets its right side area in one pass
+		float RightArea[BinCount];
+		uint32_t RightCount[BinCount];
+		Bin right;
+		for (int b = BinCount - 1; b > 0; b--)
+		{
+			right.Min = glm::min(right.Min, bins[b].Min);
+			right.Max = glm::max(right.Max, bins[b].Max);
+			right.Count += bins[b].Count;
+			RightArea[b] = SurfaceArea(right.Min, right.Max);
+			RightCount[b] = right.Count;
+		}
+
+		Bin left;
+		for (int b = 0; b < BinCount - 1; b++)
+		{
+			left.Min = glm::min(left.Min, bins[b].Min);
+			left.Max = glm::max(left.Max, bins[b].Max);
+			left.Count += bins[b].Count;
+
+			if (left.Count == 0 || RightCount[b + 1] == 0)
+				continue;
+
+			const float cost = SurfaceArea(left.Min, left.Max) * left.Count + RightArea[b + 1] * RightCount[b + 1];
+			if (cost < BestCost)
+			{
+				BestCost = cost;
+				BestAxis = axis;
+				BestSplit = b;
+			}
+		}
+	}
+
+	uint32_t mid = begin + count / 2;
+	if (BestAxis >= 0)
+	{
+		//Traversing a node costs about one sphere test, so keep small nodes as leaves when no split pays for itself
+		const float area = SurfaceArea(Min, Max);
+		const float SplitCost = 1.0f + BestCost / area;
+		if (SplitCost >= (float)count && count <= 4 * (uint32_t)m_MaxLeafSize)
+		{
+			m_Nodes[index].Offset = begin;
+			m_Nodes[index].Count = count;
+			return index;
+		}
+
+		const float scale = BinCount / (CentroidMax[BestAxis] - CentroidMin[BestAxis]);
+		const auto split = std::partition(primitives.begin() + begin, primitives.begin() + end, [&](const BuildPrimitive& primitive)
+		{
+			return std::min((int)((primitive.Centroid[BestAxis] - CentroidMin[BestAxis]) * scale), BinCount - 1) <= BestSplit;
+		});
+
+		mid = (uint32_t)(split - primitives.begin());
+	}
+
+	//All centroids in one spot, fall back to an even split
+	if (BestAxis < 0 || mid == begin || mid == end)
+	{
+		mid = begin + count / 2;
+		const glm::vec3 extent = CentroidMax - CentroidMin;
+		const int axis = extent.x > extent.y ? (extent.x > extent.z ? 0 : 2) : (extent.y > extent.z ? 1 : 2);
+		std::nth_element(primitives.begin() + begin, primitives.begin() + mid, primitives.begin() + end, [&](const BuildPrimitive& a, const BuildPrimitive& b)
+		{
+			return a.Centroid[axis] < b.Centroid[axis];
+		});
+	}
+
+	BuildNode(primitives, begin, mid, depth + 1);
+	const uint32_t right = BuildNode(primitives, mid, end, depth + 1);
+
+	m_Nodes[index].Offset = right;
+	m_Nodes[index].Count = 0;
+	return index;
+}
+
+void SphereBVH::Clear()
+{
+	m_Nodes.clear();
+	m_Primitives.clear();
+	m_LeafSpheres.clear();
+	m_Parents.clear();
+	m_EntryLeaf.clear();
+	m_SlotEntry.clear();
+	m_CostSum = 0.0;
+	m_BuildCost = 0.0f;
+}
+
+bool SphereBVH::HitBox(const BVHNode& node, const glm::vec3& origin, const glm::vec3& InvDir, const float& t, float& entry) const
+{
+	float tNear = 0.0f;
+	float tFar = t;
+
+	for (int axis = 0; axis < 3; axis++)
+	{
+		const float t0 = (node.Min[axis] - origin[axis]) * InvDir[axis];
+		const float t1 = (node.Max[axis] - origin[axis]) * InvDir[axis];
+		tNear = std::max(tNear, std::min(t0, t1));
+		tFar = std::min(tFar, std::max(t0, t1));
+	}
+
+	entry = tNear;
+	return tNear <= tFar * 1.00000024f;							//Conservative so rounding never culls a sphere the brute force loop would hit
+}
+
+int SphereBVH::ClosestHit(const glm::vec3& origin, const glm::vec3& dir, float& t) const
+{
+	int index = -1;
+	t = SphereIntersect::NoHit;
+
+	if (m_Nodes.empty())
+		return index;
+
+	const glm::vec3 InvDir = glm::vec3(1.0f / dir.x, 1.0f / dir.y, 1.0f / dir.z);
+
+	float entry;
+	if (!HitBox(m_Nodes[0], origin, InvDir, t, entry))
+		return index;
+
+	uint32_t stack[StackSize];
+	int StackPointer = 0;
+	uint32_t current = 0;
+
+	while (true)
+	{
+		const BVHNode& node = m_Nodes[current];
+
+		if (node.Count > 0)
+		{
+			for (uint32_t i = node.Offset; i < node.Offset + node.Count; i++)
+			{
+				const glm::vec4& sphere = m_LeafSpheres[i];
+				const float hit = SphereIntersect::HitDistance(origin, dir, glm::vec3(sphere.x, sphere.y, sphere.z), sphere.w);
+				if (hit <= 0.0f || hit > t)
+					continue;
+
+				//Equal distances go to the lower slot, the same sphere the brute force loop picks
+				const int slot = (int)m_Primitives[i];
+				if (hit < t || slot < index)
+				{
+					t = hit;
+					index = slot;
+				}
+			}
+		}
+
+		else
+		{
+			uint32_t first = current + 1;
+			uint32_t second = node.Offset;
+
+			float FirstEntry, SecondEntry;
+			const bool HitFirst = HitBox(m_Nodes[first], origin, InvDir, t, FirstEntry);
+			const bool HitSecond = HitBox(m_Nodes[second], origin, InvDir, t, SecondEntry);
+
+			if (HitFirst && HitSecond)
+			{
+				if (SecondEntry < FirstEntry)						//Closer child first so t shrinks before the other one is visited
+					std::swap(first, second);
+
+				stack[StackPointer++] = second;
+				current = first;
+				continue;
+			}
+
+			if (HitFirst || HitSecond)
+			{
+				current = HitFirst ? first : second;
+				continue;
+			}
+		}
+
+		if (StackPointer == 0)
+			break;
+
+		current = stack[--StackPointer];
+	}
+
+	return index;
+}
+
+//Same walk without the ordering, the first sphere hit closer than MaxT ends it
+bool SphereBVH::AnyHit(const glm::vec3& origin, const glm::vec3& dir, const float& MaxT) const
+{
+	if (m_Nodes.empty())
+		return false;
+
+	const glm::vec3 InvDir = glm::vec3(1.0f / dir.x, 1.0f / dir.y, 1.0f / dir.z);
+	const float t = MaxT;
+
+	uint32_t stack[StackSize];
+	int StackPointer = 0;
+	stack[StackPointer++] = 0;
+
+	while (StackPointer > 0)
+	{
+		const uint32_t current = stack[--StackPointer];
+		const BVHNode& node = m_Nodes[current];
+
+		float entry;
+		if (!HitBox(node, origin, InvDir, t, entry))
+			continue;
+
+		if (node.Count > 0)
+		{
+			for (uint32_t i = node.Offset; i < node.Offset + node.Count; i++)
+			{
+				const glm::vec4& sphere = m_LeafSpheres[i];
+				const float hit = SphereIntersect::HitDistance(origin, dir, glm::vec3(sphere.x, sphere.y, sphere.z), sphere.w);
+				if (0.0f < hit && hit < t)
+					return true;
+			}
+
+			continue;
+		}
+
+		stack[StackPointer++] = node.Offset;
+		stack[StackPointer++] = current + 1;
+	}
+
+	return false;
+}
+
+bool SphereBVH::Empty() const
+{
+	return m_Nodes.empty();
+}
+
+float SphereBVH::NodeCost(const BVHNode& node) const
+{
+	return SurfaceArea(node.Min, node.Max) * (node.Count > 0 ? (float)node.Count : 1.0f);
+}
+
+float SphereBVH::SAHCost() const
+{
+	if (m_Nodes.empty())
+		return 0.0f;
+
+	return (float)(m_CostSum / SurfaceArea(m_Nodes[0].Min, m_Nodes[0].Max));
+}
+
+float SphereBVH::BuildSAHCost() const
+{
+	return m_BuildCost;
+}
+
+uint32_t SphereBVH::EntryOf(const size_t& slot) const
+{
+	return m_SlotEntry[slot];
+}
+
+const std::vector<BVHNode>& SphereBVH::GetNodes() const
+{
+	return m_Nodes;
+}
+
+const std::vector<uint32_t>& SphereBVH::GetPrimitives() const
+{
+	return m_Primitives;
+}
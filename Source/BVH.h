@@ -0,0 +1,74 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+
+#include <glm.hpp>
+
+#include "SphereStore.h"
+
+//Interior nodes keep their left child right after them and store the index of the right child in Offset,
+//leaves store the first entry of the primitive list in Offset and how many follow in Count
+struct BVHNode
+{
+	glm::vec3 Min = glm::vec3(0.0f);
+	uint32_t Offset = 0;
+	glm::vec3 Max = glm::vec3(0.0f);
+	uint32_t Count = 0;
+};
+
+static_assert(sizeof(BVHNode) == 32, "BVHNode should fill exactly half a cache line");
+
+//Below this many spheres a flat loop over all of them is faster than walking a tree
+const size_t BVHMinSpheres = 32;
+
+//Binned SAH hierarchy over the spheres of a SphereStore, flattened in depth first order
+class SphereBVH
+{
+public:
+	void Build(const SphereStore& spheres, const int& MaxLeafSize = 4);
+	void Clear();
+
+	void Refit(const SphereStore& spheres, const size_t& slot, std::vector<uint32_t>& ChangedNodes);
+	bool Degraded(const float& threshold = 1.3f) const;
+
+	int ClosestHit(const glm::vec3& origin, const glm::vec3& dir, float& t) const;
+	bool AnyHit(const glm::vec3& origin, const glm::vec3& dir, const float& MaxT) const;
+
+	bool Empty() const;
+	float SAHCost() const;
+	float BuildSAHCost() const;
+	uint32_t EntryOf(const size_t& slot) const;
+	const std::vector<BVHNode>& GetNodes() const;
+	const std::vector<uint32_t>& GetPrimitives() const;
+
+private:
+	struct BuildPrimitive
+	{
+		glm::vec3 Min;
+		glm::vec3 Max;
+		glm::vec3 Centroid;
+		uint32_t Slot;
+	};
+
+	uint32_t BuildNode(std::vector<BuildPrimitive>& primitives, const uint32_t& begin, const uint32_t& end, const int& depth);
+	bool HitBox(const BVHNode& node, const glm::vec3& origin, const glm::vec3& InvDir, const float& t, float& entry) const;
+	float NodeCost(const BVHNode& node) const;
+
+private:
+	static const int BinCount = 12;
+	static const int StackSize = 64;
+
+	int m_MaxLeafSize = 4;
+	std::vector<BVHNode> m_Nodes;
+	std::vector<uint32_t> m_Primitives;						//Store slot of each leaf entry
+	std::vector<glm::vec4> m_LeafSpheres;					//Center and radius in leaf order so leaves read contiguous memory
+
+	//Refit bookkeeping, lets an edited sphere walk straight up from its leaf to the root
+	std::vector<uint32_t> m_Parents;
+	std::vector<uint32_t> m_EntryLeaf;
+	std::vector<uint32_t> m_SlotEntry;
+
+	double m_CostSum = 0.0;									//Unnormalized SAH cost, kept up to date by Refit
+	float m_BuildCost = 0.0f;
+};
@@ -0,0 +1,1076 @@
+#include "Benchmark.h"
+
+#include <chrono>
+#include <cmath>
+#include <thread>
+#include <print>
+#include <random>
+#include <cfloat>
+#include <functional>
+
+#include "CPU Ray Tracer.h"
+#include "SphereIntersect.h"
+#include "BVH.h"
+
+namespace Benchmark
+{
+	static double Seconds(const std::chrono::steady_clock::time_point& start)
+	{
+		return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	}
+
+	int Run(const int& argc, char** argv)
+	{
+		if (argc < 3)
+		{
+			std::println("Usage: {} --benchmark <scaling|intersect|bvh|refit|wavefront|blackhole|sky|sun|lights|lighttree|roulette|sampler|adaptive|denoise> [scene.hgns]", argv[0]);
+			return 1;
+		}
+
+		const std::string name = argv[2];
+		Scene scene;
+		if (!scene.Load(argc > 3 ? argv[3] : "res/Scene.hgns"))
+			return 1;
+
+		scene.m_NoiseThreshold = 0.0f;												//Every pixel gets every sample, the adaptive benchmark sets its own
+
+		if (name == "scaling")
+			ThreadScaling(scene, 640, 360, 4);
+
+		else if (name == "intersect")
+			Intersection(scene, 1 << 18);
+
+		else if (name == "bvh")
+			BVHThroughput(1 << 18);
+
+		else if (name == "refit")
+			BVHRefit(100000, 20000);
+
+		else if (name == "wavefront")
+			WavefrontThroughput(scene, 320, 180, 4);
+
+		else if (name == "blackhole")
+			GeodesicAccuracy(argc > 4 ? std::stoi(argv[4]) : 2048);
+
+		else if (name == "sky")
+			SkyLookup(scene, 1 << 20);
+
+		else if (name == "sun")
+			SunNoise(scene, 160, 90, argc > 4 ? std::stoi(argv[4]) : 1024);
+
+		else if (name == "lights")
+			LightNoise(scene, 160, 90, argc > 4 ? std::stoi(argv[4]) : 1024);
+
+		else if (name == "lighttree")
+			LightTreeNoise(scene, 160, 90, argc > 4 ? std::stoi(argv[4]) : 10000, 256);
+
+		else if (name == "roulette")
+			RouletteNoise(scene, 160, 90, argc > 4 ? std::stoi(argv[4]) : 1000, 512);
+
+		else if (name == "sampler")
+			SamplerConvergence(scene, 160, 90, argc > 4 ? std::stoi(argv[4]) : 1024);
+
+		else if (name == "adaptive")
+			AdaptiveConvergence(scene, 160, 90, argc > 4 ? std::stof(argv[4]) : 0.1f, 1024);
+
+		else if (name == "denoise")
+			DenoiseQuality(scene, 160, 90, argc > 4 ? std::stoi(argv[4]) : 64, 2048);
+
+		else
+		{
+			std::println("Unknown benchmark: {}", name);
+			return 1;
+		}
+
+		return 0;
+	}
+
+	void ThreadScaling(const Scene& scene, const int& Width, const int& Height, const int& Samples)
+	{
+		const unsigned int MaxThreads = std::max(std::thread::hardware_concurrency(), 1u);
+
+		std::vector<unsigned int> ThreadCounts;
+		for (unsigned int threads = 1; threads < MaxThreads; threads *= 2)
+			ThreadCounts.push_back(threads);
+		ThreadCounts.push_back(MaxThreads);
+
+		std::println("Thread scaling: {}x{}, {} samples per run, {} hardware threads", Width, Height, Samples, MaxThreads);
+		std::println("{:>8} {:>14} {:>10} {:>11} {:>8}", "Threads", "MSamples/s", "Speedup", "Efficiency", "Steals");
+
+		CpuRayTracer tracer(Width, Height, 1);
+		tracer.LoadScene(scene);
+
+		double BaseRate = 0.0;
+		for (const unsigned int& threads : ThreadCounts)
+		{
+			tracer.SetThreadCount(threads);
+			tracer.ResetAccumulation();
+			tracer.Accumulate();													//Warm up caches and the pool
+
+			const size_t StealsBefore = tracer.GetScheduler().StolenTiles();
+			auto start = std::chrono::steady_clock::now();
+			for (int i = 0; i < Samples; i++)
+				tracer.Accumulate();
+
+			const double elapsed = Seconds(start);
+			const double rate = (double)Width * Height * Samples / elapsed / 1.0e6;
+			if (threads == 1)
+				BaseRate = rate;
+
+			const double speedup = rate / BaseRate;
+			std::println("{:>8} {:>14.3f} {:>9.2f}x {:>10.1f}% {:>8}", threads, rate, speedup, 100.0 * speedup / threads, tracer.GetScheduler().StolenTiles() - StealsBefore);
+		}
+	}
+
+	void Intersection(const Scene& scene, const int& RayCount)
+	{
+		std::mt19937 rng(1234);
+		std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+
+		std::vector<glm::vec3> origins(RayCount);
+		std::vector<glm::vec3> directions(RayCount);
+		for (int i = 0; i < RayCount; i++)
+		{
+			origins[i] = glm::vec3(unit(rng), unit(rng), unit(rng)) * 2.0f;
+			directions[i] = glm::normalize(glm::vec3(unit(rng), unit(rng), unit(rng)) + glm::vec3(0.0f, 0.0f, 1e-4f));
+		}
+
+		std::vector<std::pair<std::string, SphereStore>> SphereSets;
+
+		SphereStore SceneSpheres;
+		for (auto& [name, sphere] : scene.m_SphereMap)
+			SceneSpheres.Add(glm::vec3(sphere.Position.x, sphere.Position.y, sphere.Position.z), sphere.Radius, 0);
+		SphereSets.push_back({ "scene", SceneSpheres });
+
+		for (const int& count : { 64, 1024 })
+		{
+			SphereStore spheres;
+			for (int i = 0; i < count; i++)
+				spheres.Add(glm::vec3(unit(rng), unit(rng), unit(rng)) * 20.0f, 0.2f + 0.8f * std::abs(unit(rng)), 0);
+			SphereSets.push_back({ std::format("random {}", count), spheres });
+		}
+
+		std::println("Ray vs sphere intersection: {} rays, best level on this CPU is {}", RayCount, SphereIntersect::BestLevel());
+		std::println("{:>12} {:>8} {:>9} {:>12} {:>9} {:>11}", "Spheres", "Count", "Level", "MRays/s", "Speedup", "Mismatches");
+
+		const SIMDLevel levels[] = { SIMDLevel::Scalar, SIMDLevel::SSE, SIMDLevel::AVX2, SIMDLevel::AVX512 };
+		for (const auto& [name, spheres] : SphereSets)
+		{
+			std::vector<int> reference(RayCount);
+			double BaseRate = 0.0;
+
+			for (const SIMDLevel& level : levels)
+			{
+				if (!SphereIntersect::Supported(level))
+				{
+					std::println("{:>12} {:>8} {:>9} {:>12}", name, spheres.Size(), level, "unsupported");
+					continue;
+				}
+
+				std::vector<int> result(RayCount);
+				const int passes = std::max(1, (int)((1 << 24) / ((size_t)RayCount * std::max<size_t>(spheres.Size(), 1))));		//Roughly the same number of sphere tests per set
+
+				auto start = std::chrono::steady_clock::now();
+				for (int pass = 0; pass < passes; pass++)
+				{
+					for (int i = 0; i < RayCount; i++)
+					{
+						float t;
+						result[i] = SphereIntersect::ClosestHit(spheres, origins[i], directions[i], t, level);
+					}
+				}
+
+				const double rate = (double)RayCount * passes / Seconds(start) / 1.0e6;
+				if (level == SIMDLevel::Scalar)
+				{
+					BaseRate = rate;
+					reference = result;
+				}
+
+				size_t mismatches = 0;
+				for (int i = 0; i < RayCount; i++)
+					mismatches += result[i] != reference[i];
+
+				std::println("{:>12} {:>8} {:>9} {:>12.2f} {:>8.2f}x {:>11}", name, spheres.Size(), level, rate, rate / BaseRate, mismatches);
+			}
+		}
+	}
+
+	void BVHThroughput(const int& RayCount)
+	{
+		const float SceneSize = 100.0f;
+
+		std::println("BVH vs brute force ({}): {} rays", SphereIntersect::GetLevel(), RayCount);
+		std::println("{:>9} {:>10} {:>8} {:>11} {:>13} {:>13} {:>10} {:>11}", "Spheres", "Build ms", "Nodes", "SAH cost", "BVH MRays/s", "Loop MRays/s", "Speedup", "Mismatches");
+
+		for (const int& count : { 1000, 100000, 1000000 })
+		{
+			std::mt19937 rng(count);
+			std::uniform_real_distribution<float> unit(-0.5f, 0.5f);
+
+			const float spacing = SceneSize / std::cbrt((float)count);
+			SphereStore spheres;
+			spheres.Reserve(count);
+			for (int i = 0; i < count; i++)
+				spheres.Add(glm::vec3(unit(rng), unit(rng), unit(rng)) * SceneSize, spacing * (0.1f + 0.3f * (unit(rng) + 0.5f)), 0);
+
+			std::vector<glm::vec3> origins(RayCount);
+			std::vector<glm::vec3> directions(RayCount);
+			for (int i = 0; i < RayCount; i++)
+			{
+				origins[i] = glm::vec3(unit(rng), unit(rng), unit(rng)) * SceneSize;
+				directions[i] = glm::normalize(glm::vec3(unit(rng), unit(rng), unit(rng)) + glm::vec3(0.0f, 0.0f, 1e-4f));
+			}
+
+			auto start = std::chrono::steady_clock::now();
+			SphereBVH bvh;
+			bvh.Build(spheres);
+			const double BuildTime = Seconds(start) * 1000.0;
+
+			std::vector<int> result(RayCount);
+			start = std::chrono::steady_clock::now();
+			for (int i = 0; i < RayCount; i++)
+			{
+				float t;
+				result[i] = bvh.ClosestHit(origins[i], directions[i], t);
+			}
+			const double BVHRate = RayCount / Seconds(start) / 1.0e6;
+
+			//The loop is far too slow for every ray on the big scenes, it gets a subset with about the same total work
+			const int LoopRays = std::clamp((int)((1ll << 28) / count), 256, RayCount);
+			size_t mismatches = 0;
+			start = std::chrono::steady_clock::now();
+			for (int i = 0; i < LoopRays; i++)
+			{
+				float t;
+				mismatches += SphereIntersect::ClosestHit(spheres, origins[i], directions[i], t) != result[i];
+			}
+			const double LoopRate = LoopRays / Seconds(start) / 1.0e6;
+
+			std::println("{:>9} {:>10.1f} {:>8} {:>11.2f} {:>13.3f} {:>13.3f} {:>9.1f}x {:>5}/{:<5}", count, BuildTime, bvh.GetNodes().size(), bvh.SAHCost(), BVHRate, LoopRate, BVHRate / LoopRate, mismatches, LoopRays);
+		}
+	}
+
+	//Drags random spheres around the way an editor would and compares refitting against rebuilding,
+	//rebuilding once the refitted tree passes the same SAH threshold the renderer uses
+	void BVHRefit(const int& count, const int& edits)
+	{
+		const float SceneSize = 100.0f;
+		const int RayCount = 1 << 16;
+
+		std::mt19937 rng(count);
+		std::uniform_real_distribution<float> unit(-0.5f, 0.5f);
+
+		const float spacing = SceneSize / std::cbrt((float)count);
+		SphereStore spheres;
+		spheres.Reserve(count);
+		for (int i = 0; i < count; i++)
+			spheres.Add(glm::vec3(unit(rng), unit(rng), unit(rng)) * SceneSize, spacing * (0.1f + 0.3f * (unit(rng) + 0.5f)), 0);
+
+		auto start = std::chrono::steady_clock::now();
+		SphereBVH bvh;
+		bvh.Build(spheres);
+		const double BuildTime = Seconds(start) * 1000.0;
+
+		std::println("BVH refit: {} spheres, {} edits, full build {:.1f} ms, build SAH cost {:.2f}", count, edits, BuildTime, bvh.BuildSAHCost());
+		std::println("{:>8} {:>14} {:>13} {:>11} {:>9}", "Edits", "Refit us/edit", "Nodes/edit", "SAH cost", "Rebuilds");
+
+		std::uniform_int_distribution<int> pick(0, count - 1);
+		std::vector<uint32_t> ChangedNodes;
+		double RefitTime = 0.0;
+		size_t NodesTouched = 0;
+		int rebuilds = 0;
+
+		for (int edit = 1; edit <= edits; edit++)
+		{
+			const SphereHandle handle = spheres.Handle(pick(rng));
+			const size_t slot = spheres.Slot(handle);
+			const glm::vec3 offset = glm::vec3(unit(rng), unit(rng), unit(rng)) * (SceneSize * 0.2f);
+			spheres.Set(handle, glm::clamp(spheres.Position(slot) + offset, -0.5f * SceneSize, 0.5f * SceneSize), spheres.Radius(slot), 0);
+
+			ChangedNodes.clear();
+			start = std::chrono::steady_clock::now();
+			bvh.Refit(spheres, slot, ChangedNodes);
+			RefitTime += Seconds(start);
+			NodesTouched += ChangedNodes.size();
+
+			if (bvh.Degraded())
+			{
+				bvh.Build(spheres);
+				rebuilds++;
+			}
+
+			if (edit % (edits / 10) == 0)
+				std::println("{:>8} {:>14.3f} {:>13.1f} {:>11.2f} {:>9}", edit, RefitTime / edit * 1.0e6, (double)NodesTouched / edit, bvh.SAHCost(), rebuilds);
+		}
+
+		//A refitted tree has to find exactly what a fresh one does
+		SphereBVH fresh;
+		fresh.Build(spheres);
+
+		size_t mismatches = 0;
+		for (int i = 0; i < RayCount; i++)
+		{
+			const glm::vec3 origin = glm::vec3(unit(rng), unit(rng), unit(rng)) * SceneSize;
+			const glm::vec3 dir = glm::normalize(glm::vec3(unit(rng), unit(rng), unit(rng)) + glm::vec3(0.0f, 0.0f, 1e-4f));
+
+			float t, FreshT;
+			const int hit = bvh.ClosestHit(origin, dir, t);
+			const int FreshHit = fresh.ClosestHit(origin, dir, FreshT);
+			mismatches += hit != FreshHit || (hit >= 0 && t != FreshT);
+		}
+
+		std::println("Refit is {:.0f}x faster than a rebuild per edit, {}/{} rays differ from a fresh build", BuildTime / (RefitTime / edits * 1000.0), mismatches, RayCount);
+	}
+
+	//Both modes trace exactly the same paths, so the wavefront ray count is used for the megakernel rate as well
+	void WavefrontThroughput(const Scene& scene, const int& Width, const int& Height, const int& Samples)
+	{
+		std::mt19937 rng(42);
+		std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+
+		//Same scene buried in small spheres, so extend goes through the BVH and the shading queues get long
+		Scene crowded = scene;
+		std::vector<std::string> materials;
+		for (auto& [name, material] : scene.m_MaterialMap)
+			materials.push_back(name);
+
+		for (int i = 0; i < 2000 && !materials.empty(); i++)
+		{
+			Sphere sphere;
+			sphere.Position = Vec3(unit(rng) * 10.0f, unit(rng) * 3.0f, unit(rng) * 10.0f);
+			sphere.Radius = 0.05f + 0.1f * std::abs(unit(rng));
+			sphere.MaterialName = materials[i % materials.size()];
+			crowded.m_SphereMap[std::format("Crowd{}", i)] = sphere;
+		}
+
+		std::println("Megakernel vs wavefront: {}x{}, {} samples per run, {} threads", Width, Height, Samples, std::max(std::thread::hardware_concurrency(), 1u));
+		std::println("{:>10} {:>8} {:>12} {:>12} {:>10} {:>9} {:>12}", "Scene", "Spheres", "Mode", "MSamples/s", "MRays/s", "Speedup", "Max diff");
+
+		const Scene* scenes[] = { &scene, &crowded };
+		for (const Scene* current : scenes)
+		{
+			CpuRayTracer tracer(Width, Height);
+			tracer.LoadScene(*current);
+
+			double elapsed[2];
+			std::vector<glm::vec3> images[2];
+			uint64_t rays = 0;
+
+			const TraceMode modes[] = { TraceMode::Megakernel, TraceMode::Wavefront };
+			for (int mode = 0; mode < 2; mode++)
+			{
+				tracer.SetTraceMode(modes[mode]);
+				tracer.ResetAccumulation();
+				tracer.Accumulate();												//Warm up caches and the per thread queues
+				tracer.ResetAccumulation();
+
+				const uint64_t RaysBefore = tracer.ExtendedRays();
+				auto start = std::chrono::steady_clock::now();
+				for (int i = 0; i < Samples; i++)
+					tracer.Accumulate();
+
+				elapsed[mode] = Seconds(start);
+				images[mode] = tracer.GetAccumulationBuffer();
+				rays += tracer.ExtendedRays() - RaysBefore;
+			}
+
+			float MaxDiff = 0.0f;
+			for (size_t i = 0; i < images[0].size(); i++)
+			{
+				const glm::vec3 diff = glm::abs(images[0][i] - images[1][i]);
+				MaxDiff = std::max({ MaxDiff, diff.x, diff.y, diff.z });
+			}
+
+			const char* SceneName = current == &scene ? "scene" : "crowded";
+			const char* ModeNames[] = { "megakernel", "wavefront" };
+			for (int mode = 0; mode < 2; mode++)
+			{
+				const double SampleRate = (double)Width * Height * Samples / elapsed[mode] / 1.0e6;
+				std::println("{:>10} {:>8} {:>12} {:>12.3f} {:>10.3f} {:>8.2f}x {:>12}", SceneName, current->m_SphereMap.size(), ModeNames[mode], SampleRate, rays / elapsed[mode] / 1.0e6, elapsed[0] / elapsed[mode], MaxDiff);
+			}
+		}
+	}
+
+	struct GeodesicResult
+	{
+		bool Captured = false;
+		glm::vec3 Direction = glm::vec3(0.0f);
+		int Steps = 0;
+	};
+
+	//The fixed step Euler march the tracers used before the adaptive integrator, kept as the baseline
+	static GeodesicResult EulerGeodesic(glm::vec3 Radial, glm::vec3 dir, const float& SchwarzschildRadius, const float& InfluenceRadius, const float& dt)
+	{
+		const float PSphereRadius = 1.5f * SchwarzschildRadius;
+
+		float r = glm::length(Radial);
+		glm::vec3 UnitRadial = Radial / r;
+		const glm::vec3 Omega = glm::cross(Radial, dir);
+		float rVel = glm::dot(dir, UnitRadial);
+		const float k = r * glm::length(dir - rVel * UnitRadial);
+		float PhiVel = k / (r * r);
+		float rAcc = (r - PSphereRadius) * PhiVel;
+
+		GeodesicResult result;
+		for (result.Steps = 1; result.Steps < 1000000; result.Steps++)
+		{
+			const glm::vec3 UnitAngular = glm::normalize(glm::cross(Omega, Radial));
+			Radial += dir * dt;
+			r = glm::length(Radial);
+			UnitRadial = Radial / r;
+
+			rVel = rAcc * dt + rVel;
+			PhiVel = k / (r * r);
+			dir = glm::normalize(rVel * UnitRadial + r * PhiVel * UnitAngular);
+			rAcc = (r - PSphereRadius) * PhiVel * PhiVel;
+
+			if (r < PSphereRadius && rVel < 0.0f)
+			{
+				result.Captured = true;
+				break;
+			}
+
+			if (rVel > 0.0f && r > InfluenceRadius)
+				break;
+		}
+
+		result.Direction = dir;
+		return result;
+	}
+
+	static GeodesicResult AdaptiveGeodesic(const glm::vec3& Radial, const glm::vec3& dir, const float& SchwarzschildRadius, const float& InfluenceRadius, const float& dt)
+	{
+		CPU::Uniforms uniforms;
+		uniforms.BlackHolePosition = glm::vec3(0.0f);
+		uniforms.SchwarzsRadius = SchwarzschildRadius;
+		uniforms.MaxInfluenceRadius = InfluenceRadius;
+		uniforms.StepSize = dt;
+		uniforms.BlackHoleClearRadius = FLT_MAX;
+
+		CPU::Ray ray;
+		ray.RayOrigin = Radial;
+		ray.RayDir = dir;
+		ray.RayColor = glm::vec3(1.0f);
+
+		CPU::BlackHoleInfo BHInfo;
+		CPU::StartBlackHole(ray, uniforms, BHInfo);
+
+		GeodesicResult result;
+		while (!BHInfo.Captured && !BHInfo.Escaped && result.Steps < 1000000)
+		{
+			CPU::UpdateRay(ray, BHInfo, FLT_MAX);
+			result.Steps++;
+		}
+
+		result.Captured = BHInfo.Captured;
+		result.Direction = ray.RayDir;
+		return result;
+	}
+
+	//Started a unit back along the ray so it enters the influence sphere where the others start
+	static GeodesicResult TableGeodesic(const glm::vec3& Radial, const glm::vec3& dir, const CPU::Uniforms& uniforms)
+	{
+		CPU::Ray ray;
+		ray.RayOrigin = Radial - dir;
+		ray.RayDir = dir;
+		ray.RayColor = glm::vec3(1.0f);
+
+		CPU::BlackHoleInfo BHInfo;
+		CPU::StartBlackHole(ray, uniforms, BHInfo);
+
+		GeodesicResult result;
+		result.Steps = 1;
+		result.Captured = CPU::DeflectRay(ray, BHInfo, uniforms.Deflection, FLT_MAX);
+		result.Direction = ray.RayDir;
+		return result;
+	}
+
+	//Double precision RK4 on the same equation with a step of a thousandth of r, only stopping at the influence radius
+	static GeodesicResult ReferenceGeodesic(const glm::vec3& Radial, const glm::vec3& dir, const float& SchwarzschildRadius, const float& InfluenceRadius)
+	{
+		const double rs = SchwarzschildRadius;
+
+		double x[3] = { Radial.x, Radial.y, Radial.z };
+		double v[3] = { dir.x, dir.y, dir.z };
+
+		const double cx = x[1] * v[2] - x[2] * v[1];
+		const double cy = x[2] * v[0] - x[0] * v[2];
+		const double cz = x[0] * v[1] - x[1] * v[0];
+		const double h2 = cx * cx + cy * cy + cz * cz;
+
+		auto acceleration = [&](const double* p, double* a)
+		{
+			const double r2 = p[0] * p[0] + p[1] * p[1] + p[2] * p[2];
+			const double scale = -1.5 * rs * h2 / (r2 * r2 * std::sqrt(r2));
+			for (int i = 0; i < 3; i++)
+				a[i] = scale * p[i];
+		};
+
+		GeodesicResult result;
+		double r = std::sqrt(x[0] * x[0] + x[1] * x[1] + x[2] * x[2]);
+		for (result.Steps = 1; result.Steps < 10000000; result.Steps++)
+		{
+			const double dt = 1e-3 * std::min(r, 10.0 * rs);
+			double k1x[3], k1v[3], k2x[3], k2v[3], k3x[3], k3v[3], k4x[3], k4v[3], p[3];
+
+			for (int i = 0; i < 3; i++) k1x[i] = v[i];
+			acceleration(x, k1v);
+			for (int i = 0; i < 3; i++) { p[i] = x[i] + 0.5 * dt * k1x[i]; k2x[i] = v[i] + 0.5 * dt * k1v[i]; }
+			acceleration(p, k2v);
+			for (int i = 0; i < 3; i++) { p[i] = x[i] + 0.5 * dt * k2x[i]; k3x[i] = v[i] + 0.5 * dt * k2v[i]; }
+			acceleration(p, k3v);
+			for (int i = 0; i < 3; i++) { p[i] = x[i] + dt * k3x[i]; k4x[i] = v[i] + dt * k3v[i]; }
+			acceleration(p, k4v);
+
+			for (int i = 0; i < 3; i++)
+			{
+				x[i] += dt / 6.0 * (k1x[i] + 2.0 * k2x[i] + 2.0 * k3x[i] + k4x[i]);
+				v[i] += dt / 6.0 * (k1v[i] + 2.0 * k2v[i] + 2.0 * k3v[i] + k4v[i]);
+			}
+
+			r = std::sqrt(x[0] * x[0] + x[1] * x[1] + x[2] * x[2]);
+			const double rVel = x[0] * v[0] + x[1] * v[1] + x[2] * v[2];
+
+			if (r < 1.5 * rs && rVel < 0.0)
+			{
+				result.Captured = true;
+				break;
+			}
+
+			if (rVel > 0.0 && r > InfluenceRadius)
+				break;
+		}
+
+		result.Direction = glm::normalize(glm::vec3((float)v[0], (float)v[1], (float)v[2]));
+		return result;
+	}
+
+	//Photons enter the influence sphere aimed past the hole with impact parameters up to twice the critical one, or the influence radius
+	void GeodesicAccuracy(const int& RayCount)
+	{
+		const float SchwarzschildRadius = 0.5f;
+		const float CriticalImpact = 1.5f * std::sqrt(3.0f) * SchwarzschildRadius;
+
+		std::println("Black hole geodesics: Rs = {}, {} photons per run, errors against a double precision RK4 reference", SchwarzschildRadius, RayCount);
+		std::println("{:>10} {:>10} {:>10} {:>11} {:>11} {:>13} {:>13} {:>14}", "Influence", "StepSize", "Method", "Steps/ray", "ns/ray", "Mean err rad", "Max err rad", "Wrong capture");
+
+		for (const float& InfluenceRadius : { 1.5f, 10.0f })
+		{
+			std::mt19937 rng(7);
+			std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+
+			std::vector<glm::vec3> origins(RayCount);
+			std::vector<glm::vec3> directions(RayCount);
+			std::vector<GeodesicResult> reference(RayCount);
+			for (int i = 0; i < RayCount; i++)
+			{
+				const glm::vec3 normal = glm::normalize(glm::vec3(unit(rng) - 0.5f, unit(rng) - 0.5f, unit(rng) - 0.5f));
+				const glm::vec3 side = glm::normalize(glm::cross(normal, glm::vec3(0.3f, 1.0f, 0.1f)));
+				const float b = std::min(2.0f * CriticalImpact, 0.99f * InfluenceRadius) * unit(rng);
+
+				origins[i] = normal * InfluenceRadius;
+				directions[i] = glm::normalize(side * b - normal * std::sqrt(InfluenceRadius * InfluenceRadius - b * b));
+				reference[i] = ReferenceGeodesic(origins[i], directions[i], SchwarzschildRadius, InfluenceRadius);
+			}
+
+			CPU::Uniforms uniforms;
+			uniforms.SchwarzsRadius = SchwarzschildRadius;
+			uniforms.MaxInfluenceRadius = InfluenceRadius;
+			uniforms.BlackHoleClearRadius = FLT_MAX;
+
+			auto BuildStart = std::chrono::steady_clock::now();
+			uniforms.Deflection.Build(SchwarzschildRadius, InfluenceRadius);
+			std::println("{:>10} deflection table: {} entries built in {:.1f} ms", InfluenceRadius, uniforms.Deflection.GetAngles().size(), Seconds(BuildStart) * 1000.0);
+
+			//The table does not depend on the step size, it only gets the last row
+			const float StepSizes[] = { 0.1f, 0.05f, 0.025f, 0.0125f };
+			for (const float& StepSize : StepSizes)
+			{
+				for (int method = 0; method < (StepSize == StepSizes[3] ? 3 : 2); method++)
+				{
+					std::vector<GeodesicResult> results(RayCount);
+					auto start = std::chrono::steady_clock::now();
+					for (int i = 0; i < RayCount; i++)
+					{
+						if (method == 0)
+							results[i] = EulerGeodesic(origins[i], directions[i], SchwarzschildRadius, InfluenceRadius, StepSize);
+
+						else if (method == 1)
+							results[i] = AdaptiveGeodesic(origins[i], directions[i], SchwarzschildRadius, InfluenceRadius, StepSize);
+
+						else
+							results[i] = TableGeodesic(origins[i], directions[i], uniforms);
+					}
+					const double elapsed = Seconds(start);
+
+					double steps = 0.0;
+					double ErrorSum = 0.0;
+					double MaxError = 0.0;
+					int escaped = 0;
+					int WrongCapture = 0;
+					for (int i = 0; i < RayCount; i++)
+					{
+						steps += results[i].Steps;
+						if (results[i].Captured != reference[i].Captured)
+						{
+							WrongCapture++;
+							continue;
+						}
+
+						if (results[i].Captured)
+							continue;
+
+						const double error = std::acos(std::clamp((double)glm::dot(results[i].Direction, reference[i].Direction), -1.0, 1.0));
+						ErrorSum += error;
+						MaxError = std::max(MaxError, error);
+						escaped++;
+					}
+
+					const char* MethodNames[] = { "euler", "adaptive", "table" };
+					std::println("{:>10} {:>10} {:>10} {:>11.1f} {:>11.1f} {:>13.5f} {:>13.5f} {:>14}", InfluenceRadius, method == 2 ? "-" : std::format("{}", StepSize), MethodNames[method], steps / RayCount, elapsed / RayCount * 1.0e9, ErrorSum / std::max(escaped, 1), MaxError, WrongCapture);
+				}
+			}
+		}
+	}
+
+	//WorldColor as it was before the sky was baked, every miss paid for the sun direction, three exp and two sin
+	static glm::vec3 AnalyticWorldColor(glm::vec3 direction, const CPU::Uniforms& uniforms)
+	{
+		direction = glm::normalize(direction);
+
+		const float CosAltitude = std::cos(uniforms.SunAltitude);
+		const glm::vec3 SunPos = glm::normalize(glm::vec3(CosAltitude * std::sin(uniforms.SunAzimuthal), std::sin(uniforms.SunAltitude), CosAltitude * std::cos(uniforms.SunAzimuthal)));
+		const float SunCosine = glm::dot(direction, SunPos);
+
+		const float t = std::exp(-1.0f * (SunCosine - 1.0f) * (SunCosine - 1.0f) / (uniforms.SunRadius * uniforms.SunRadius));
+		return SkyTable::Evaluate(direction.y, SunCosine, uniforms.SkyVariation) + glm::vec3(1.0f, 1.0f, 0.6f) * uniforms.SunIntensity * std::sin(1.57f * t);
+	}
+
+	//Half the directions are spread over the sphere, half aimed within a few sun radii of the sun where the disk is evaluated
+	void SkyLookup(const Scene& scene, const int& RayCount)
+	{
+		CPU::Uniforms uniforms;
+		uniforms.SunRadius = scene.m_SunRadius / 200.0f;
+		uniforms.SunIntensity = scene.m_SunIntensity;
+		uniforms.SunAltitude = glm::radians(scene.m_SunAltitude);
+		uniforms.SunAzimuthal = glm::radians(scene.m_SunAzimuthal);
+		uniforms.SkyVariation = scene.m_SkyVariation;
+
+		auto BuildStart = std::chrono::steady_clock::now();
+		uniforms.Sky.Build(uniforms.SunAltitude, uniforms.SunAzimuthal, uniforms.SkyVariation);
+		const double BuildTime = Seconds(BuildStart);
+
+		std::mt19937 rng(11);
+		std::normal_distribution<float> normal(0.0f, 1.0f);
+		const glm::vec3 SunDirection = uniforms.Sky.SunDirection();
+
+		std::vector<glm::vec3> directions(RayCount);
+		for (int i = 0; i < RayCount; i++)
+		{
+			const glm::vec3 random = glm::normalize(glm::vec3(normal(rng), normal(rng), normal(rng)));
+			directions[i] = i % 2 == 0 ? random : glm::normalize(SunDirection + 3.0f * std::sqrt(uniforms.SunRadius) * random);
+		}
+
+		std::println("Miss shading: {} directions, {}x{} sky table baked in {:.2f} ms", RayCount, uniforms.Sky.GetSize(), uniforms.Sky.GetSize(), BuildTime * 1000.0);
+
+		std::vector<glm::vec3> reference(RayCount);
+		std::vector<glm::vec3> baked(RayCount);
+		for (int run = 0; run < 2; run++)
+		{
+			std::vector<glm::vec3>& colors = run == 0 ? reference : baked;
+			auto start = std::chrono::steady_clock::now();
+			for (int i = 0; i < RayCount; i++)
+				colors[i] = run == 0 ? AnalyticWorldColor(directions[i], uniforms) : CPU::WorldColor(directions[i], uniforms);
+
+			std::println("{:>10}: {:.1f} ns per miss", run == 0 ? "analytic" : "baked", Seconds(start) / RayCount * 1.0e9);
+		}
+
+		double ErrorSum = 0.0;
+		double MaxError = 0.0;
+		for (int i = 0; i < RayCount; i++)
+		{
+			const glm::vec3 difference = glm::abs(baked[i] - reference[i]);
+			const double error = std::max(difference.x, std::max(difference.y, difference.z)) / std::max(reference[i].x, std::max(reference[i].y, reference[i].z));
+			ErrorSum += error;
+			MaxError = std::max(MaxError, error);
+		}
+
+		std::println("relative error: mean {:.2e}, max {:.2e}", ErrorSum / RayCount, MaxError);
+	}
+
+	//Relative MSE against a long render with the technique on, after each doubling of the sample count, so directly visible
+	//lights don't drown out the rest of the image. Time to reach the noise of the run without it at its last row is
+	//extrapolated from the run with it, assuming error falls off as 1 / samples
+	static void SamplingNoise(CpuRayTracer& tracer, const int& ReferenceSamples, const std::function<void(const bool&)>& enable, const std::string& OffName = "bsdf", const std::string& OnName = "nee+mis")
+	{
+		enable(true);
+		for (int i = 0; i < ReferenceSamples; i++)
+			tracer.Accumulate();
+
+		const std::vector<glm::vec3> reference = tracer.GetAccumulationBuffer();
+		std::println("{:>8} {:>8} {:>10} {:>12} {:>12}", "Mode", "Samples", "Time (s)", "relMSE", "Path length");
+
+		const int MaxSamples = std::max(ReferenceSamples / 16, 1);
+		double FinalTime[2] = {};
+		double FinalError[2] = {};
+		for (int mode = 0; mode < 2; mode++)
+		{
+			enable(mode == 1);
+
+			double elapsed = 0.0;
+			for (int samples = 1; samples <= MaxSamples; samples *= 2)
+			{
+				auto start = std::chrono::steady_clock::now();
+				while ((int)tracer.RenderedSamples() < samples)
+					tracer.Accumulate();
+
+				elapsed += Seconds(start);
+
+				double ErrorSum = 0.0;
+				const std::vector<glm::vec3> image = tracer.GetAccumulationBuffer();
+				for (size_t i = 0; i < image.size(); i++)
+				{
+					const glm::vec3 difference = image[i] - reference[i];
+					ErrorSum += glm::dot(difference / (reference[i] + 0.1f), difference / (reference[i] + 0.1f)) / 3.0f;
+				}
+
+				FinalTime[mode] = elapsed;
+				FinalError[mode] = ErrorSum / image.size();
+				std::println("{:>8} {:>8} {:>10.3f} {:>12.5f} {:>12.2f}", mode == 0 ? OffName : OnName, samples, elapsed, FinalError[mode], tracer.AveragePathLength());
+			}
+		}
+
+		const double TimeToTarget = FinalTime[1] * FinalError[1] / FinalError[0];
+		std::println("time to relMSE {:.5f}: {} {:.3f} s, {} {:.3f} s ({:.1f}x)", FinalError[0], OffName, FinalTime[0], OnName, TimeToTarget, FinalTime[0] / TimeToTarget);
+	}
+
+	//Lamps stay sampled, so only the sun changes between the runs
+	void SunNoise(const Scene& scene, const int& Width, const int& Height, const int& ReferenceSamples)
+	{
+		CpuRayTracer tracer(Width, Height);
+		tracer.LoadScene(scene);
+
+		std::println("Sun sampling: {}x{}, reference of {} samples", Width, Height, ReferenceSamples);
+		SamplingNoise(tracer, ReferenceSamples, [&](const bool& enabled) { tracer.SetSunSampling(enabled); });
+	}
+
+	void LightNoise(const Scene& scene, const int& Width, const int& Height, const int& ReferenceSamples)
+	{
+		CpuRayTracer tracer(Width, Height);
+		tracer.LoadScene(scene);
+
+		std::println("Emissive sphere sampling: {}x{}, reference of {} samples", Width, Height, ReferenceSamples);
+		SamplingNoise(tracer, ReferenceSamples, [&](const bool& enabled) { tracer.SetLightSampling(enabled); });
+	}
+
+	//Night version of the scene with count small lamps scattered around the camera, a few bright ones among many dim ones.
+	//Both runs sample the lamps, only the way one is picked changes
+	void LightTreeNoise(const Scene& scene, const int& Width, const int& Height, const int& count, const int& ReferenceSamples)
+	{
+		Scene lit = scene;
+		lit.m_SunIntensity = 0.0f;
+
+		std::mt19937 rng(21);
+		std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+		const glm::vec3 center = lit.m_Camera.m_Position;
+		for (int i = 0; i < 8; i++)
+		{
+			Material lamp;
+			lamp.Albedo = Vec3(0.5f + 0.5f * unit(rng), 0.5f + 0.5f * unit(rng), 0.5f + 0.5f * unit(rng));
+			lamp.Roughness = 1.0f;
+			lamp.Emission = 50.0f * std::pow(4.0f, (float)i);
+			lit.m_MaterialMap[std::format("Lamp{}", i)] = lamp;
+		}
+
+		for (int i = 0; i < count; i++)
+		{
+			Sphere lamp;
+			lamp.Position = Vec3(center.x + 40.0f * unit(rng) - 20.0f, -0.95f + 3.0f * unit(rng), center.z + 40.0f * unit(rng) - 20.0f);
+			lamp.Radius = 0.02f + 0.03f * unit(rng);
+			lamp.MaterialName = std::format("Lamp{}", std::min((int)(-std::log2(unit(rng) + 1e-6f)), 7));
+			lit.m_SphereMap[std::format("Lamp{}", i)] = lamp;
+		}
+
+		CpuRayTracer tracer(Width, Height);
+		tracer.LoadScene(lit);
+
+		std::println("Light tree: {} lamps, {}x{}, reference of {} samples", count, Width, Height, ReferenceSamples);
+		SamplingNoise(tracer, ReferenceSamples, [&](const bool& enabled) { tracer.SetLightTreeSampling(enabled); }, "uniform", "tree");
+	}
+
+	//count clear glass spheres in front of the camera, where paths that never hit anything dark only end at max_depth.
+	//Without roulette they all run to the cap, the run with it starts roulette at the depth the scene asks for
+	void RouletteNoise(const Scene& scene, const int& Width, const int& Height, const int& count, const int& ReferenceSamples)
+	{
+		Scene glassy = scene;
+
+		Material glass;
+		glass.Type = BSDFType::Glass;
+		glass.Albedo = Vec3(1.0f, 1.0f, 1.0f);
+		glass.Roughness = 0.0f;
+		glass.IOR = 1.5f;
+		glassy.m_MaterialMap["RouletteGlass"] = glass;
+
+		std::mt19937 rng(31);
+		std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+		const glm::vec3 center = glassy.m_Camera.m_Position;
+		for (int i = 0; i < count; i++)
+		{
+			Sphere bead;
+			bead.Position = Vec3(center.x + 8.0f * unit(rng) - 4.0f, -0.8f + 2.0f * unit(rng), center.z + 8.0f * unit(rng) - 4.0f);
+			bead.Radius = 0.1f + 0.2f * unit(rng);
+			bead.MaterialName = "RouletteGlass";
+			glassy.m_SphereMap[std::format("Bead{}", i)] = bead;
+		}
+
+		CpuRayTracer tracer(Width, Height);
+		tracer.LoadScene(glassy);
+
+		std::println("Russian roulette: {} glass spheres, {}x{}, max depth {}, roulette from depth {}, reference of {} samples", count, Width, Height, glassy.m_MaxDepth, glassy.m_RouletteDepth, ReferenceSamples);
+		SamplingNoise(tracer, ReferenceSamples, [&](const bool& enabled) { tracer.SetRouletteDepth(enabled ? glassy.m_RouletteDepth : glassy.m_MaxDepth); }, "max", "roulette");
+	}
+
+	//Relative RMSE of each sampler against a long Sobol render, after each doubling of the sample count, and the samples
+	//each one needs to match the error of Random at the last row, interpolated on the log log curve. The blurred column
+	//is the error after a 3 x 3 box filter, what is left of it once the eye averages neighbouring pixels, which is where
+	//blue noise pays off
+	void SamplerConvergence(const Scene& scene, const int& Width, const int& Height, const int& ReferenceSamples)
+	{
+		CpuRayTracer tracer(Width, Height);
+		tracer.LoadScene(scene);
+
+		tracer.SetSampler(SamplerType::Sobol);
+		for (int i = 0; i < ReferenceSamples; i++)
+			tracer.Accumulate();
+
+		const std::vector<glm::vec3> reference = tracer.GetAccumulationBuffer();
+		std::println("Sampler convergence: {}x{}, reference of {} samples", Width, Height, ReferenceSamples);
+		std::println("{:>10} {:>8} {:>10} {:>12} {:>12}", "Sampler", "Samples", "Time (s)", "relRMSE", "Blurred");
+
+		const SamplerType types[] = { SamplerType::Random, SamplerType::Sobol, SamplerType::BlueNoise };
+		const int MaxSamples = std::max(ReferenceSamples / 16, 1);
+		std::vector<double> errors[3];
+		for (int type = 0; type < 3; type++)
+		{
+			tracer.SetSampler(types[type]);
+
+			double elapsed = 0.0;
+			for (int samples = 1; samples <= MaxSamples; samples *= 2)
+			{
+				auto start = std::chrono::steady_clock::now();
+				while ((int)tracer.RenderedSamples() < samples)
+					tracer.Accumulate();
+
+				elapsed += Seconds(start);
+
+				const std::vector<glm::vec3> image = tracer.GetAccumulationBuffer();
+				std::vector<glm::vec3> error(image.size());
+				for (size_t i = 0; i < image.size(); i++)
+					error[i] = (image[i] - reference[i]) / (reference[i] + 0.1f);
+
+				double ErrorSum = 0.0;
+				double BlurredSum = 0.0;
+				for (int y = 0; y < Height; y++)
+				{
+					for (int x = 0; x < Width; x++)
+					{
+						const glm::vec3& e = error[(size_t)y * Width + x];
+						ErrorSum += glm::dot(e, e) / 3.0f;
+
+						glm::vec3 blurred = glm::vec3(0.0f);
+						for (int dy = -1; dy <= 1; dy++)
+						{
+							for (int dx = -1; dx <= 1; dx++)
+								blurred += error[(size_t)std::clamp(y + dy, 0, Height - 1) * Width + std::clamp(x + dx, 0, Width - 1)];
+						}
+
+						blurred /= 9.0f;
+						BlurredSum += glm::dot(blurred, blurred) / 3.0f;
+					}
+				}
+
+				errors[type].push_back(std::sqrt(ErrorSum / image.size()));
+				std::println("{:>10} {:>8} {:>10.3f} {:>12.5f} {:>12.5f}", std::format("{}", types[type]), samples, elapsed, errors[type].back(), std::sqrt(BlurredSum / image.size()));
+			}
+		}
+
+		const double target = errors[0].back();
+		std::print("samples to relRMSE {:.5f}:", target);
+		for (int type = 0; type < 3; type++)
+		{
+			double samples = (double)MaxSamples;
+			for (size_t i = 1; i < errors[type].size(); i++)
+			{
+				if (errors[type][i] > target)
+					continue;
+
+				const double t = std::log(errors[type][i - 1] / target) / std::log(errors[type][i - 1] / errors[type][i]);
+				samples = std::exp2((double)(i - 1) + std::clamp(t, 0.0, 1.0));
+				break;
+			}
+
+			std::print(" {} {:.1f}", types[type], samples);
+		}
+
+		std::print("\n");
+	}
+
+	//Every tile sampled each pass against tiles left out once their own error estimate is below the noise threshold, 16 x 16
+	//like on the GPU. Both run until the relative RMSE against a long render is down to what every tile sampled reaches with
+	//a sixteenth of the reference samples. Estimated is the error the tracer reports for itself, what the quality target
+	//stops on
+	void AdaptiveConvergence(const Scene& scene, const int& Width, const int& Height, const float& NoiseThreshold, const int& ReferenceSamples)
+	{
+		CpuRayTracer tracer(Width, Height);
+		tracer.LoadScene(scene);
+		tracer.SetTileSize(16);
+		tracer.ResetAccumulation();
+
+		for (int i = 0; i < ReferenceSamples; i++)
+			tracer.Accumulate();
+
+		const std::vector<glm::vec3> reference = tracer.GetAccumulationBuffer();
+		auto Error = [&]()
+		{
+			double ErrorSum = 0.0;
+			const std::vector<glm::vec3> image = tracer.GetAccumulationBuffer();
+			for (size_t i = 0; i < image.size(); i++)
+			{
+				const glm::vec3 difference = (image[i] - reference[i]) / (reference[i] + 0.1f);
+				ErrorSum += glm::dot(difference, difference) / 3.0f;
+			}
+
+			return std::sqrt(ErrorSum / image.size());
+		};
+
+		auto SamplesPerPixel = [&]()
+		{
+			double samples = 0.0;
+			for (const Tile& tile : tracer.GetScheduler().GetTiles())
+				samples += (double)tile.Samples * tile.Width * tile.Height;
+
+			return samples / ((double)Width * Height);
+		};
+
+		std::println("Adaptive sampling: {}x{}, noise threshold {}, reference of {} samples", Width, Height, NoiseThreshold, ReferenceSamples);
+		std::println("{:>10} {:>8} {:>12} {:>10} {:>12} {:>12} {:>8}", "Mode", "Passes", "Samples/px", "Time (s)", "relRMSE", "Estimated", "Active");
+
+		const int UniformPasses = std::max(ReferenceSamples / 16, 1);
+		double target = 0.0;
+		double FinalTime[2] = {};
+		double FinalSamples[2] = {};
+		for (int mode = 0; mode < 2; mode++)
+		{
+			tracer.SetNoiseThreshold(mode == 1 ? NoiseThreshold : 0.0f);
+			tracer.ResetAccumulation();
+
+			double elapsed = 0.0;
+			double error = 1.0;
+			int NextRow = 1;
+			while (true)
+			{
+				auto start = std::chrono::steady_clock::now();
+				tracer.Accumulate();
+				elapsed += Seconds(start);
+
+				const int passes = (int)tracer.RenderedSamples();
+				error = Error();
+
+				const bool done = mode == 0 ? passes >= UniformPasses : error <= target || tracer.ActivePixels() == 0.0f || passes >= ReferenceSamples;
+				if (passes == NextRow || done)
+				{
+					std::println("{:>10} {:>8} {:>12.2f} {:>10.3f} {:>12.5f} {:>12.5f} {:>7.1f}%", mode == 0 ? "uniform" : "adaptive", passes, SamplesPerPixel(), elapsed, error, tracer.RelativeError(), 100.0f * tracer.ActivePixels());
+					NextRow *= 2;
+				}
+
+				if (done)
+					break;
+			}
+
+			if (mode == 0)
+				target = error;
+
+			FinalTime[mode] = elapsed;
+			FinalSamples[mode] = SamplesPerPixel();
+		}
+
+		std::println("to relRMSE {:.5f}: uniform {:.3f} s {:.1f} samples/px, adaptive {:.3f} s {:.1f} samples/px ({:.2f}x)", target, FinalTime[0], FinalSamples[0], FinalTime[1], FinalSamples[1], FinalTime[0] / FinalTime[1]);
+	}
+
+	//Relative RMSE against a long render of the raw and the denoised image after each doubling of the sample count up to
+	//Samples. The raw sample count with the error of the last denoised row is extrapolated assuming error falls off as
+	//1 / sqrt(samples). Then the filter alone is timed at a larger size with and without AVX2
+	void DenoiseQuality(const Scene& scene, const int& Width, const int& Height, const int& Samples, const int& ReferenceSamples)
+	{
+		CpuRayTracer tracer(Width, Height);
+		tracer.LoadScene(scene);
+		tracer.SetDenoise(true);
+
+		for (int i = 0; i < ReferenceSamples; i++)
+			tracer.Accumulate();
+
+		const std::vector<glm::vec3> reference = tracer.GetAccumulationBuffer();
+		auto Error = [&](const std::vector<glm::vec3>& image)
+		{
+			double ErrorSum = 0.0;
+			for (size_t i = 0; i < image.size(); i++)
+			{
+				const glm::vec3 difference = (image[i] - reference[i]) / (reference[i] + 0.1f);
+				ErrorSum += glm::dot(difference, difference) / 3.0f;
+			}
+
+			return std::sqrt(ErrorSum / image.size());
+		};
+
+		std::println("Denoiser: {}x{}, reference of {} samples", Width, Height, ReferenceSamples);
+		std::println("{:>8} {:>12} {:>12} {:>12}", "Samples", "Raw relRMSE", "Denoised", "Filter (ms)");
+
+		tracer.ResetAccumulation();
+		double RawError = 0.0;
+		double DenoisedError = 0.0;
+		for (int samples = 1; samples <= Samples; samples *= 2)
+		{
+			while ((int)tracer.RenderedSamples() < samples)
+				tracer.Accumulate();
+
+			auto start = std::chrono::steady_clock::now();
+			const std::vector<glm::vec3>& denoised = tracer.Denoise();
+			const double elapsed = Seconds(start);
+
+			RawError = Error(tracer.GetAccumulationBuffer());
+			DenoisedError = Error(denoised);
+			std::println("{:>8} {:>12.5f} {:>12.5f} {:>12.3f}", samples, RawError, DenoisedError, elapsed * 1000.0);
+		}
+
+		const double equivalent = (double)tracer.RenderedSamples() * (RawError / DenoisedError) * (RawError / DenoisedError);
+		std::println("{} samples denoised have the error of {:.0f} raw samples", tracer.RenderedSamples(), equivalent);
+
+		const int LargeWidth = 1280;
+		const int LargeHeight = 720;
+		CpuRayTracer large(LargeWidth, LargeHeight);
+		large.LoadScene(scene);
+		large.SetDenoise(true);
+		for (int i = 0; i < 4; i++)
+			large.Accumulate();
+
+		const SIMDLevel best = SphereIntersect::BestLevel();
+		const int repeats = 10;
+		for (const SIMDLevel& level : { SIMDLevel::Scalar, best })
+		{
+			SphereIntersect::SetLevel(level);
+
+			auto start = std::chrono::steady_clock::now();
+			for (int i = 0; i < repeats; i++)
+			{
+				large.SetDenoise(true);													//Throws the last result away so it's filtered again
+				large.Denoise();
+			}
+
+			const double elapsed = Seconds(start) / repeats;
+			std::println("{}x{} {}: {:.2f} ms, {:.1f} Mpixels/s", LargeWidth, LargeHeight, level, elapsed * 1000.0, LargeWidth * LargeHeight / elapsed / 1.0e6);
+		}
+
+		SphereIntersect::SetLevel(best);
+	}
+}
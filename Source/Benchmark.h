@@ -0,0 +1,27 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "Scene.h"
+
+//Host side benchmarks, run with: Halogen --benchmark <name> [scene.hgns]
+namespace Benchmark
+{
+	int Run(const int& argc, char** argv);
+
+	void ThreadScaling(const Scene& scene, const int& Width, const int& Height, const int& Samples);
+	void Intersection(const Scene& scene, const int& RayCount);
+	void BVHThroughput(const int& RayCount);
+	void BVHRefit(const int& count, const int& edits);
+	void WavefrontThroughput(const Scene& scene, const int& Width, const int& Height, const int& Samples);
+	void GeodesicAccuracy(const int& RayCount);
+	void SkyLookup(const Scene& scene, const int& RayCount);
+	void SunNoise(const Scene& scene, const int& Width, const int& Height, const int& ReferenceSamples);
+	void LightNoise(const Scene& scene, const int& Width, const int& Height, const int& ReferenceSamples);
+	void LightTreeNoise(const Scene& scene, const int& Width, const int& Height, const int& count, const int& ReferenceSamples);
+	void RouletteNoise(const Scene& scene, const int& Width, const int& Height, const int& count, const int& ReferenceSamples);
+	void SamplerConvergence(const Scene& scene, const int& Width, const int& Height, const int& ReferenceSamples);
+	void AdaptiveConvergence(const Scene& scene, const int& Width, const int& Height, const float& NoiseThreshold, const int& ReferenceSamples);
+	void DenoiseQuality(const Scene& scene, const int& Width, const int& Height, const int& Samples, const int& ReferenceSamples);
+}
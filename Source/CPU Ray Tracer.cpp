@@ -0,0 +1,1205 @@
+#include "CPU Ray Tracer.h"
+#include "Wavefront.h"
+
+#include <bit>
+#include <cmath>
+#include <cstdint>
+
+namespace CPU
+{
+	//Radius linear in random.y, so the points crowd toward the middle rather than covering the disk evenly
+	glm::vec3 PointOnDisk(const glm::vec2& random)
+	{
+		const float pi = 3.1415926535f;
+		float theta = 2.0f * pi * random.x;
+		float r = random.y;
+
+		return glm::vec3(r * std::cos(theta), r * std::sin(theta), 0.0f);
+	}
+
+	glm::vec3 PointOnSphere(const glm::vec2& random)
+	{
+		const float pi = 3.1415926535f;
+		float azimuthal = 2.0f * pi * random.x;
+		float A = 2.0f * random.y - 1.0f;
+
+		float Z = -A;
+
+		A *= A;
+		A = std::sqrt(1.0f - A);
+
+		return glm::vec3(A * std::cos(azimuthal), A * std::sin(azimuthal), Z);
+	}
+
+	//Sun disk at distance = 1 - cos of the angle to the sun
+	glm::vec3 SunRadiance(const float& distance, const Uniforms& uniforms)
+	{
+		const float t = std::exp(-1.0f * distance * distance / (uniforms.SunRadius * uniforms.SunRadius));
+		return glm::vec3(1.0f, 1.0f, 0.6f) * uniforms.SunIntensity * std::sin(1.57f * t);
+	}
+
+	//Solid angle density SampleSun draws directions with, a half normal in distance cut off at SunCone radii
+	float SunPdf(const float& distance, const Uniforms& uniforms)
+	{
+		if (distance >= SunCone * uniforms.SunRadius)
+			return 0.0f;
+
+		const float pi = 3.1415926535f;
+		return std::exp(-1.0f * distance * distance / (uniforms.SunRadius * uniforms.SunRadius)) / (pi * std::sqrt(pi) * uniforms.SunRadius);
+	}
+
+	//DiskWeight scales the disk down for rays that could also have been drawn by SampleSun
+	glm::vec3 WorldColor(glm::vec3 direction, const Uniforms& uniforms, const float& DiskWeight)
+	{
+		direction = glm::normalize(direction);
+		glm::vec3 color = uniforms.Sky.Lookup(direction);
+
+		const float distance = 1.0f - glm::dot(direction, uniforms.Sky.SunDirection());
+		if (distance < SunCone * uniforms.SunRadius)
+			color += DiskWeight * SunRadiance(distance, uniforms);
+
+		return color;
+	}
+
+	HitRecord HitPoint(const Ray& ray, const Sphere& sphere)
+	{
+		HitRecord record;
+		record.Hit = false;
+		record.HitSphere = sphere;
+		record.t = -1.0f;
+
+		glm::vec3 diff = ray.RayOrigin - sphere.Position;
+		float RaySphereDist = glm::dot(diff, diff);
+		float DirDotDiff = glm::dot(ray.RayDir, diff);
+		float discriminant = DirDotDiff * DirDotDiff - (RaySphereDist - sphere.Radius * sphere.Radius);
+
+		if (discriminant < 0.0f)
+			return record;
+
+		float temp = -std::sqrt(discriminant) - DirDotDiff;
+		float temp2 = std::sqrt(discriminant) - DirDotDiff;
+
+		if (std::abs(temp) < 0.001f && std::abs(temp2) < 0.001f)
+			return record;
+
+		record.Hit = true;
+
+		if (std::abs(temp) < 0.001f)
+		{
+			record.t = temp2;
+			return record;
+		}
+
+		if (std::abs(temp2) < 0.001f)
+		{
+			record.t = temp;
+			return record;
+		}
+
+		if (RaySphereDist < sphere.Radius * sphere.Radius)
+		{
+			record.t = temp > 0.0f ? temp : temp2;
+			return record;
+		}
+
+		record.t = temp < temp2 ? temp : temp2;
+		return record;
+	}
+
+	HitRecord HitPoint(const Ray& ray, const Uniforms& uniforms)
+	{
+		HitRecord record;
+		const int index = uniforms.BVH.Empty() ? SphereIntersect::ClosestHit(uniforms.Spheres, ray.RayOrigin, ray.RayDir, record.t) : uniforms.BVH.ClosestHit(ray.RayOrigin, ray.RayDir, record.t);
+
+		record.Hit = index >= 0;
+		if (record.Hit)
+		{
+			record.HitSphere.Position = uniforms.Spheres.Position(index);
+			record.HitSphere.Radius = uniforms.Spheres.Radius(index);
+			record.HitSphere.MatIndex = uniforms.Spheres.MaterialIndex(index);
+			record.Slot = index;
+		}
+
+		return record;
+	}
+
+	void Scatter(const Diffuse& diffuse, Ray& ray, const HitRecord& record, const Sampler& sampler)
+	{
+		ray.RayOrigin = ray.RayOrigin + record.t * ray.RayDir;				//RayOrigin = Intersection
+
+		glm::vec3 normal = glm::normalize(ray.RayOrigin - record.HitSphere.Position);
+
+		if (glm::dot(normal, ray.RayDir) > 0.0f)
+			normal = -normal;
+
+		glm::vec3 randVec = PointOnSphere(sampler.Get2D(ScatterDimension));
+
+		randVec += normal;
+
+		if (std::abs(randVec.x) < 0.001f && std::abs(randVec.y) < 0.001f && std::abs(randVec.z) < 0.001f)		//Catch reflection rays close to 0
+			randVec = normal;
+
+		ray.RayDir = glm::mix(glm::reflect(ray.RayDir, normal), randVec, diffuse.Roughness);
+		ray.RayDir = glm::normalize(ray.RayDir);
+
+		ray.RayColor *= diffuse.Albedo;
+	}
+
+	float reflectance(const float& cosine, const float& IOR)
+	{
+		float r0 = (1.0f - IOR) / (1.0f + IOR);
+		r0 = r0 * r0;
+		return r0 + (1.0f - r0) * std::pow(1.0f - cosine, 5.0f);
+	}
+
+	void Scatter(const Glass& glass, Ray& ray, const HitRecord& record, const Sampler& sampler)
+	{
+		ray.RayOrigin = ray.RayOrigin + record.t * ray.RayDir;				//RayOrigin = Intersection
+
+		glm::vec3 normal = glm::normalize(ray.RayOrigin - record.HitSphere.Position);
+
+		float IOR = 1.0f / glass.IOR;
+
+		if (glm::dot(normal, ray.RayDir) > 0.0f)
+		{
+			normal = -normal;
+			IOR = glass.IOR;
+		}
+
+		float cos_theta = std::min(glm::dot(-ray.RayDir, normal), 1.0f);
+		float sin_theta = std::sqrt(1.0f - cos_theta * cos_theta);
+
+		if (IOR * sin_theta > 1.0f || reflectance(cos_theta, IOR) > sampler.Get1D(ScatterDimension))
+			ray.RayDir = glm::reflect(ray.RayDir, normal);
+
+		else
+			ray.RayDir = glm::refract(ray.RayDir, normal, IOR);
+
+		ray.RayDir = glm::normalize(ray.RayDir);
+		ray.RayColor *= glass.Albedo;
+	}
+
+	//Same test as the Escaped of ComputeBlackHoleInfo, a ray that fails it gets marched and bent instead of going straight.
+	//Light samples are only taken along straight rays, and only straight scattered rays are weighed against them
+	bool StaysStraight(const Ray& ray, const Uniforms& uniforms)
+	{
+		if (!uniforms.RenderBlackHole)
+			return true;
+
+		Sphere influence;
+		influence.Position = uniforms.BlackHolePosition;
+		influence.Radius = uniforms.MaxInfluenceRadius;
+		return glm::length(ray.RayOrigin - influence.Position) > influence.Radius && !HitPoint(ray, influence).Hit;
+	}
+
+	bool Occluded(const Ray& ray, const Uniforms& uniforms, const float& MaxT)
+	{
+		return uniforms.BVH.Empty() ? SphereIntersect::AnyHit(uniforms.Spheres, ray.RayOrigin, ray.RayDir, MaxT) : uniforms.BVH.AnyHit(ray.RayOrigin, ray.RayDir, MaxT);
+	}
+
+	float PowerHeuristic(const float& pdf, const float& OtherPdf)
+	{
+		return pdf * pdf / (pdf * pdf + OtherPdf * OtherPdf);
+	}
+
+	bool SamplesSun(const Uniforms& uniforms)
+	{
+		return uniforms.SunSampling && uniforms.SunIntensity > 0.0f && uniforms.SunRadius > 0.0f;
+	}
+
+	bool SamplesLights(const Uniforms& uniforms)
+	{
+		return uniforms.LightSampling && !uniforms.Lights.Empty();
+	}
+
+	//1 - cos of the half angle a sphere subtends, written so far away lights keep their precision
+	float ConeOneMinusCos(const float& distance2, const float& radius)
+	{
+		const float sin2 = radius * radius / distance2;
+		return sin2 / (1.0f + std::sqrt(std::max(1.0f - sin2, 0.0f)));
+	}
+
+	//Light SampleLights aims at from point, through the light tree unless it is turned off for comparison
+	int PickLight(const glm::vec3& point, const float& u, const Uniforms& uniforms, float& PickPdf)
+	{
+		if (uniforms.LightTreeSampling)
+			return uniforms.LightHierarchy.Sample(point, u, PickPdf);
+
+		PickPdf = 1.0f / (float)uniforms.Lights.Size();
+		return (int)std::min((size_t)(u * (float)uniforms.Lights.Size()), uniforms.Lights.Size() - 1);
+	}
+
+	float PickPdf(const glm::vec3& point, const size_t& light, const Uniforms& uniforms)
+	{
+		return uniforms.LightTreeSampling ? uniforms.LightHierarchy.Pdf(point, light) : 1.0f / (float)uniforms.Lights.Size();
+	}
+
+	//Solid angle density SampleLights draws ray.RayDir with toward light, the pick then a uniform direction in its cone
+	float LightPdf(const Ray& ray, const Sphere& light, const float& PickPdf, const Uniforms& uniforms)
+	{
+		const glm::vec3 axis = light.Position - ray.RayOrigin;
+		const float distance2 = glm::dot(axis, axis);
+		if (distance2 <= light.Radius * light.Radius || !StaysStraight(ray, uniforms))
+			return 0.0f;
+
+		const float pi = 3.1415926535f;
+		return PickPdf / (2.0f * pi * ConeOneMinusCos(distance2, light.Radius));
+	}
+
+	//MIS weight of the sun disk for a ray leaving the sky, ScatterPdf is 0 unless the last bounce could have sampled it
+	float SunWeight(const Ray& ray, const Uniforms& uniforms)
+	{
+		if (ray.ScatterPdf <= 0.0f || !SamplesSun(uniforms))
+			return 1.0f;
+
+		const float LightPdf = SunPdf(1.0f - glm::dot(glm::normalize(ray.RayDir), uniforms.Sky.SunDirection()), uniforms);
+		return LightPdf > 0.0f ? PowerHeuristic(ray.ScatterPdf, LightPdf) : 1.0f;
+	}
+
+	//MIS weight of an emissive sphere the scattered ray ran into, ray.RayOrigin is still the vertex it left from
+	float EmissionWeight(const Ray& ray, const HitRecord& record, const Uniforms& uniforms)
+	{
+		if (ray.ScatterPdf <= 0.0f || !SamplesLights(uniforms))
+			return 1.0f;
+
+		const int light = uniforms.Lights.LightOf(record.Slot);
+		if (light < 0)
+			return 1.0f;
+
+		const float pdf = LightPdf(ray, record.HitSphere, PickPdf(ray.RayOrigin, light, uniforms), uniforms);
+		return pdf > 0.0f ? PowerHeuristic(ray.ScatterPdf, pdf) : 1.0f;
+	}
+
+	//Next event estimation toward the sun, combined with the scattered ray through the power heuristic. Directions come
+	//from a half normal in 1 - cos of the angle to the sun, which follows the exp(-distance^2 / SunRadius^2) of the disk
+	glm::vec3 SampleSun(const Ray& ray, const glm::vec3& normal, const Uniforms& uniforms, const Sampler& sampler)
+	{
+		const float pi = 3.1415926535f;
+		const glm::vec3 SunDirection = uniforms.Sky.SunDirection();
+
+		const glm::vec2 disk = sampler.Get2D(SunDimension);
+		const float distance = uniforms.SunRadius * std::sqrt(-std::log(1.0f - disk.x)) * std::abs(std::cos(2.0f * pi * sampler.Get1D(SunAngleDimension)));
+		if (!(distance < SunCone * uniforms.SunRadius))
+			return glm::vec3(0.0f);
+
+		const glm::vec3 tangent = glm::normalize(glm::cross(std::abs(SunDirection.y) < 0.999f ? glm::vec3(0.0f, 1.0f, 0.0f) : glm::vec3(1.0f, 0.0f, 0.0f), SunDirection));
+		const glm::vec3 bitangent = glm::cross(SunDirection, tangent);
+		const float CosTheta = 1.0f - distance;
+		const float SinTheta = std::sqrt(std::max(1.0f - CosTheta * CosTheta, 0.0f));
+		const float azimuthal = 2.0f * pi * disk.y;
+
+		Ray shadow;
+		shadow.RayOrigin = ray.RayOrigin;
+		shadow.RayDir = CosTheta * SunDirection + SinTheta * (std::cos(azimuthal) * tangent + std::sin(azimuthal) * bitangent);
+
+		const float cosine = glm::dot(normal, shadow.RayDir);
+		if (cosine <= 0.0f || !StaysStraight(shadow, uniforms) || Occluded(shadow, uniforms, SphereIntersect::NoHit))
+			return glm::vec3(0.0f);
+
+		const float LightPdf = SunPdf(distance, uniforms);
+		const float BSDFPdf = cosine / pi;
+		return ray.RayColor * SunRadiance(distance, uniforms) * (BSDFPdf / LightPdf * PowerHeuristic(LightPdf, BSDFPdf));
+	}
+
+	//Next event estimation toward one emissive sphere picked by PickLight, with a direction uniform in the cone it subtends.
+	//The shadow ray stops short of the light
+	glm::vec3 SampleLights(const Ray& ray, const glm::vec3& normal, const Uniforms& uniforms, const Sampler& sampler)
+	{
+		const float pi = 3.1415926535f;
+		float pick;
+		const int index = PickLight(ray.RayOrigin, sampler.Get1D(LightPickDimension), uniforms, pick);
+		if (index < 0 || pick <= 0.0f)
+			return glm::vec3(0.0f);
+
+		const uint32_t slot = uniforms.Lights.Slot(index);
+
+		Sphere light;
+		light.Position = uniforms.Spheres.Position(slot);
+		light.Radius = uniforms.Spheres.Radius(slot);
+		light.MatIndex = uniforms.Spheres.MaterialIndex(slot);
+
+		const glm::vec3 axis = light.Position - ray.RayOrigin;
+		const float distance2 = glm::dot(axis, axis);
+		if (distance2 <= light.Radius * light.Radius)
+			return glm::vec3(0.0f);
+
+		const glm::vec3 direction = axis / std::sqrt(distance2);
+		const glm::vec3 tangent = glm::normalize(glm::cross(std::abs(direction.y) < 0.999f ? glm::vec3(0.0f, 1.0f, 0.0f) : glm::vec3(1.0f, 0.0f, 0.0f), direction));
+		const glm::vec3 bitangent = glm::cross(direction, tangent);
+		const glm::vec2 cone = sampler.Get2D(LightConeDimension);
+		const float OneMinusCos = cone.y * ConeOneMinusCos(distance2, light.Radius);
+		const float CosTheta = 1.0f - OneMinusCos;
+		const float SinTheta = std::sqrt(std::max(OneMinusCos * (2.0f - OneMinusCos), 0.0f));
+		const float azimuthal = 2.0f * pi * cone.x;
+
+		Ray shadow;
+		shadow.RayOrigin = ray.RayOrigin;
+		shadow.RayDir = CosTheta * direction + SinTheta * (std::cos(azimuthal) * tangent + std::sin(azimuthal) * bitangent);
+
+		const float cosine = glm::dot(normal, shadow.RayDir);
+		if (cosine <= 0.0f)
+			return glm::vec3(0.0f);
+
+		const HitRecord record = HitPoint(shadow, light);
+		if (!record.Hit || record.t <= 0.0f || Occluded(shadow, uniforms, record.t - SphereIntersect::Epsilon))
+			return glm::vec3(0.0f);
+
+		const float pdf = LightPdf(shadow, light, pick, uniforms);
+		if (pdf <= 0.0f)
+			return glm::vec3(0.0f);
+
+		const Material& material = uniforms.MaterialList[light.MatIndex];
+		const float BSDFPdf = cosine / pi;
+		return ray.RayColor * material.Albedo * material.Emission * (BSDFPdf / pdf * PowerHeuristic(pdf, BSDFPdf));
+	}
+
+	//Only the fully rough lobe is Lambertian, with a cosine density light samples can be weighed against. Returns the
+	//light gathered at the vertex Scatter has just left and sets the density the scattered ray was drawn with
+	glm::vec3 DirectLight(Ray& ray, const HitRecord& record, const Diffuse& diffuse, const Uniforms& uniforms, const Sampler& sampler)
+	{
+		ray.ScatterPdf = 0.0f;
+		if (diffuse.Roughness != 1.0f)
+			return glm::vec3(0.0f);
+
+		const float pi = 3.1415926535f;
+		glm::vec3 normal = glm::normalize(ray.RayOrigin - record.HitSphere.Position);
+		if (glm::dot(normal, ray.RayDir) < 0.0f)
+			normal = -normal;
+
+		ray.ScatterPdf = std::max(glm::dot(normal, ray.RayDir), 0.0f) / pi;
+
+		glm::vec3 light = glm::vec3(0.0f);
+		if (SamplesSun(uniforms))
+			light += SampleSun(ray, normal, uniforms, sampler);
+
+		if (SamplesLights(uniforms))
+			light += SampleLights(ray, normal, uniforms, sampler);
+
+		return light;
+	}
+
+	//Returns the light gathered by next event estimation at this vertex
+	glm::vec3 UpdateRay(Ray& ray, const HitRecord& record, const Uniforms& uniforms, const Sampler& sampler)
+	{
+		const Material& material = uniforms.MaterialList[record.HitSphere.MatIndex];
+		switch (material.Type)
+		{
+			case DiffuseType:
+			{
+				Diffuse diffuse;
+				diffuse.Albedo = material.Albedo;
+				diffuse.Roughness = material.Roughness;
+				diffuse.Emission = material.Emission;
+				Scatter(diffuse, ray, record, sampler);
+				return DirectLight(ray, record, diffuse, uniforms, sampler);
+			}
+
+			case GlassType:
+			{
+				Glass glass;
+				glass.Albedo = material.Albedo;
+				glass.IOR = material.IOR;
+				Scatter(glass, ray, record, sampler);
+				break;
+			}
+		}
+
+		ray.ScatterPdf = 0.0f;
+		return glm::vec3(0.0f);
+	}
+
+	//Schwarzschild null geodesics written as a central force in flat space, r'' = h^2 (r - 1.5 Rs) / r^4 along the radial direction
+	glm::vec3 GeodesicAcceleration(const glm::vec3& Radial, const float& h2, const float& SchwarzschildRadius)
+	{
+		const float r2 = glm::dot(Radial, Radial);
+		return -1.5f * SchwarzschildRadius * h2 / (r2 * r2 * std::sqrt(r2)) * Radial;
+	}
+
+	//StepSize is the step on the photon sphere, where paths are unstable. It grows with the distance from there
+	//but is capped so the direction turns by at most the angle one StepSize subtends on the photon sphere
+	float GeodesicStep(const BlackHoleInfo& BHInfo, const glm::vec3& acceleration, const float& speed)
+	{
+		const float step = BHInfo.dt * (1.0f + GeodesicGrowth * std::abs(BHInfo.r - BHInfo.PSphereRadius) / BHInfo.PSphereRadius);
+		const float TurnLimit = BHInfo.dt / BHInfo.PSphereRadius * speed * speed / std::max(glm::length(acceleration), 1e-20f);
+		return std::max(std::min(step, TurnLimit), 0.25f * BHInfo.dt) / speed;
+	}
+
+	//Distance of the asymptote from the hole, 0 for photons that never get out to infinity
+	float ImpactParameter(const BlackHoleInfo& BHInfo)
+	{
+		const float VelocityInf2 = glm::dot(BHInfo.Velocity, BHInfo.Velocity) - BHInfo.SchwarzschildRadius * BHInfo.h * BHInfo.h / (BHInfo.r * BHInfo.r * BHInfo.r);
+		return VelocityInf2 > 0.0f ? BHInfo.h / std::sqrt(VelocityInf2) : 0.0f;
+	}
+
+	//Falling in with an impact parameter under the critical one has no turning point, so once no sphere is closer to the hole
+	//than the photon the outcome is known. Going out past the photon sphere r only grows, so the march stops once the weak field
+	//bending still ahead, at most Rs b / r^2, is negligible
+	void ClassifyGeodesic(BlackHoleInfo& BHInfo)
+	{
+		const float rVel = glm::dot(BHInfo.Velocity, BHInfo.Radial);
+		const float b = ImpactParameter(BHInfo);
+
+		if (rVel < 0.0f)
+		{
+			BHInfo.Captured = BHInfo.r < BHInfo.PSphereRadius || (b < BHInfo.CriticalImpact && BHInfo.r <= BHInfo.ClearRadius);
+			return;
+		}
+
+		BHInfo.Escaped = BHInfo.r > BHInfo.Influence.Radius || (BHInfo.r > 2.0f * BHInfo.PSphereRadius && BHInfo.SchwarzschildRadius * b / (BHInfo.r * BHInfo.r) < EscapeBend);
+	}
+
+	//Adaptive velocity Verlet step, exact on h since the force is central. MaxStep keeps it short of the next sphere
+	bool UpdateRay(Ray& ray, BlackHoleInfo& BHInfo, const float& MaxStep)
+	{
+		const float h2 = BHInfo.h * BHInfo.h;
+		const float speed = glm::length(BHInfo.Velocity);
+		const glm::vec3 acceleration = GeodesicAcceleration(BHInfo.Radial, h2, BHInfo.SchwarzschildRadius);
+		const float dt = std::min(GeodesicStep(BHInfo, acceleration, speed), MaxStep / speed);
+
+		BHInfo.Velocity += 0.5f * dt * acceleration;
+		BHInfo.Radial += dt * BHInfo.Velocity;
+		BHInfo.Velocity += 0.5f * dt * GeodesicAcceleration(BHInfo.Radial, h2, BHInfo.SchwarzschildRadius);
+		BHInfo.r = glm::length(BHInfo.Radial);
+
+		ray.RayDir = glm::normalize(BHInfo.Velocity);
+		ray.RayOrigin = BHInfo.Radial + BHInfo.BlackHolePos;
+
+		ClassifyGeodesic(BHInfo);
+		return BHInfo.Captured;
+	}
+
+	//Moves a photon from outside the influence sphere straight to where it leaves it again, turned in its orbital plane by
+	//the tabulated angle. Leaving, it has the speed and angle to the radial it came in with, mirrored. HitT keeps spheres
+	//in front of the influence sphere in the way
+	bool DeflectRay(Ray& ray, BlackHoleInfo& BHInfo, const DeflectionTable& table, const float& HitT)
+	{
+		BHInfo.Escaped = true;
+
+		const float radius = BHInfo.Influence.Radius;
+		const float along = -glm::dot(BHInfo.Radial, ray.RayDir);
+		const float discriminant = along * along - (BHInfo.r * BHInfo.r - radius * radius);
+		if (along <= 0.0f || discriminant <= 0.0f || HitT < along - std::sqrt(discriminant))
+			return false;
+
+		float angle;
+		if (!table.SweptAngle(BHInfo.h, angle))
+		{
+			BHInfo.Captured = true;
+			return true;
+		}
+
+		const glm::vec3 EntryRadial = glm::normalize(BHInfo.Radial + (along - std::sqrt(discriminant)) * ray.RayDir);
+		const glm::vec3 EntryTangent = glm::normalize(ray.RayDir - glm::dot(ray.RayDir, EntryRadial) * EntryRadial);
+		const glm::vec3 ExitRadial = std::cos(angle) * EntryRadial + std::sin(angle) * EntryTangent;
+		const glm::vec3 ExitTangent = std::cos(angle) * EntryTangent - std::sin(angle) * EntryRadial;
+
+		const float SinEntry = std::min(BHInfo.h / radius, 1.0f);
+		ray.RayOrigin = BHInfo.BlackHolePos + radius * ExitRadial;
+		ray.RayDir = std::sqrt(1.0f - SinEntry * SinEntry) * ExitRadial + SinEntry * ExitTangent;
+		return false;
+	}
+
+	//Center of pixel (x, y) of the crop window on the sensor plane
+	glm::vec3 SensorPosition(const int& x, const int& y, const Uniforms& uniforms)
+	{
+		const float ndcX = 2.0f * ((float)(x + uniforms.CropX) + 0.5f) / (float)uniforms.FramebufferWidth - 1.0f;
+		const float ndcY = 2.0f * ((float)(y + uniforms.CropY) + 0.5f) / (float)uniforms.FramebufferHeight - 1.0f;
+		return glm::vec3(ndcX * uniforms.Sensor_Size / 2.0f, ndcY * uniforms.Sensor_Size / (2.0f * uniforms.AspectRatio), 0.0f);
+	}
+
+	Ray GetRay(glm::vec3 PixelPos, const Uniforms& uniforms, const Sampler& sampler)
+	{
+		Ray ray;
+		ray.RayOrigin = PixelPos;
+		ray.RayColor = glm::vec3(1.0f);
+
+		const glm::vec2 jitter = sampler.Get2D(PixelDimension);
+		float OffsetWidth = uniforms.Sensor_Size / (float)uniforms.FramebufferWidth;
+		float OffsetHeight = (uniforms.Sensor_Size / uniforms.AspectRatio) / (float)uniforms.FramebufferHeight;
+		ray.RayOrigin += glm::vec3((2.0f * jitter.x - 1.0f) * OffsetWidth, (2.0f * jitter.y - 1.0f) * OffsetHeight, 0.0f);
+
+		float LensFocalLength = uniforms.Focal_Length * uniforms.Focus_Dist / (uniforms.Focal_Length + uniforms.Focus_Dist);
+		glm::vec3 FocusPoint = ray.RayOrigin * LensFocalLength + glm::vec3(0.0f, 0.0f, uniforms.Focal_Length * uniforms.Focal_Length);
+		FocusPoint /= LensFocalLength - uniforms.Focal_Length;
+
+		float DiskRadius = uniforms.Focal_Length / (2.0f * uniforms.F_Stop);
+		glm::vec3 DiskPoint = DiskRadius * PointOnDisk(sampler.Get2D(LensDimension)) + glm::vec3(0.0f, 0.0f, -uniforms.Focal_Length);
+
+		ray.RayOrigin = DiskPoint;
+		ray.RayDir = glm::normalize(FocusPoint - ray.RayOrigin);
+
+		//The host tracer works in world space, so scene data never has to be re-transformed when the camera moves
+		ray.RayOrigin = uniforms.CameraToWorld * ray.RayOrigin + uniforms.CameraPos;
+		ray.RayDir = uniforms.CameraToWorld * ray.RayDir;
+
+		return ray;
+	}
+
+	//Compute BlackHoleInfo from Initial Ray
+	void ComputeBlackHoleInfo(const Ray& ray, BlackHoleInfo& BHInfo)
+	{
+		BHInfo.Radial = ray.RayOrigin - BHInfo.BlackHolePos;
+		BHInfo.r = glm::length(BHInfo.Radial);
+		BHInfo.Captured = false;
+
+		HitRecord record = HitPoint(ray, BHInfo.Influence);
+		BHInfo.Escaped = !record.Hit && (BHInfo.r > BHInfo.Influence.Radius);
+		if (BHInfo.Escaped)
+			return;
+
+		BHInfo.Velocity = ray.RayDir;
+		BHInfo.h = glm::length(glm::cross(BHInfo.Radial, ray.RayDir));
+		ClassifyGeodesic(BHInfo);
+	}
+
+	void StartBlackHole(const Ray& ray, const Uniforms& uniforms, BlackHoleInfo& BHInfo)
+	{
+		BHInfo = BlackHoleInfo();
+		BHInfo.BlackHolePos = uniforms.BlackHolePosition;
+		BHInfo.SchwarzschildRadius = uniforms.SchwarzsRadius;
+		BHInfo.PSphereRadius = BHInfo.SchwarzschildRadius * 3.0f / 2.0f;
+		BHInfo.CriticalImpact = BHInfo.PSphereRadius * std::sqrt(3.0f);
+		BHInfo.dt = uniforms.StepSize;
+		BHInfo.ClearRadius = uniforms.BlackHoleClearRadius;
+		BHInfo.Deflect = !uniforms.Deflection.Empty() && uniforms.BlackHoleClearRadius >= uniforms.MaxInfluenceRadius;
+
+		BHInfo.Influence.Position = BHInfo.BlackHolePos;
+		BHInfo.Influence.Radius = uniforms.MaxInfluenceRadius;
+
+		ComputeBlackHoleInfo(ray, BHInfo);
+	}
+
+	//Russian roulette on the throughput, survivors are scaled up by the chance they had so the estimate stays unbiased
+	bool Survives(Ray& ray, const Sampler& sampler)
+	{
+		const float chance = std::min(std::max(ray.RayColor.x, std::max(ray.RayColor.y, ray.RayColor.z)), RouletteSurvival);
+		if (sampler.Get1D(RouletteDimension) >= chance)
+			return false;
+
+		ray.RayColor /= chance;
+		return true;
+	}
+
+	void RecordSurface(FirstHit& aov, const Ray& ray, const HitRecord& record, const Uniforms& uniforms)
+	{
+		const glm::vec3 point = ray.RayOrigin + record.t * ray.RayDir;
+		aov.Albedo = uniforms.MaterialList[record.HitSphere.MatIndex].Albedo;
+		aov.Normal = glm::normalize(point - record.HitSphere.Position);
+		aov.Depth = -glm::dot(point - uniforms.CameraPos, uniforms.CameraToWorld[2]);
+		aov.MatIndex = record.HitSphere.MatIndex;
+		aov.Slot = record.Slot;
+	}
+
+	//The sky stands in for the albedo of a miss, clamped so the sun doesn't blow it out
+	void RecordSky(FirstHit& aov, const Ray& ray, const Uniforms& uniforms)
+	{
+		aov.Albedo = glm::min(WorldColor(ray.RayDir, uniforms, SunWeight(ray, uniforms)), glm::vec3(1.0f));
+	}
+
+	//Adds the segments traced, black hole march steps included, to PathLength. aov is only filled in when
+	//uniforms.WriteAOVs is set
+	glm::vec3 TraceRay(Ray ray, const Uniforms& uniforms, Sampler sampler, int& PathLength, FirstHit& aov)
+	{
+		ray = GetRay(ray.RayOrigin, uniforms, sampler);
+
+		BlackHoleInfo BHInfo;
+		if (uniforms.RenderBlackHole)
+			StartBlackHole(ray, uniforms, BHInfo);
+
+		glm::vec3 light = glm::vec3(0.0f);
+		for (int depth = 0; depth < uniforms.max_depth; depth++)
+		{
+			PathLength++;
+			sampler.StartBounce(depth);
+			HitRecord record = HitPoint(ray, uniforms);
+
+			if (uniforms.RenderBlackHole && record.t > 2.0f * BHInfo.dt && !BHInfo.Escaped)
+			{
+				ray.ScatterPdf = 0.0f;
+				if (BHInfo.Deflect && BHInfo.r > BHInfo.Influence.Radius)
+				{
+					if (DeflectRay(ray, BHInfo, uniforms.Deflection, record.t))
+						return light;
+					continue;
+				}
+
+				if (BHInfo.Captured || UpdateRay(ray, BHInfo, 0.5f * record.t))
+					return light;
+				continue;
+			}
+
+			if (!record.Hit)
+			{
+				if (uniforms.WriteAOVs && aov.MatIndex < 0)
+					RecordSky(aov, ray, uniforms);
+
+				return light + WorldColor(ray.RayDir, uniforms, SunWeight(ray, uniforms)) * ray.RayColor;
+			}
+
+			const Material& material = uniforms.MaterialList[record.HitSphere.MatIndex];
+			if (uniforms.WriteAOVs && aov.MatIndex < 0)
+				RecordSurface(aov, ray, record, uniforms);
+
+			if (material.Emission != 0.0f)
+				return light + ray.RayColor * material.Albedo * material.Emission * EmissionWeight(ray, record, uniforms);
+
+			light += UpdateRay(ray, record, uniforms, sampler);
+
+			if (uniforms.RenderBlackHole)
+				ComputeBlackHoleInfo(ray, BHInfo);
+
+			if (depth + 1 >= uniforms.RouletteDepth && !Survives(ray, sampler))
+				return light;
+		}
+
+		return light;
+	}
+}
+
+CpuRayTracer::CpuRayTracer(const int& FramebufferWidth, const int& FramebufferHeight, const unsigned int& ThreadCount)
+	:m_Pool(std::make_unique<ThreadPool>(ThreadCount)), m_FramebufferWidth(FramebufferWidth), m_FramebufferHeight(FramebufferHeight)
+{
+	m_Uniforms.MaterialList.push_back(CPU::Material());
+	m_Uniforms.Sky.Build(m_Uniforms.SunAltitude, m_Uniforms.SunAzimuthal, m_Uniforms.SkyVariation);
+	FramebufferReSize(FramebufferWidth, FramebufferHeight);
+	UpdateCamera();
+}
+
+CpuRayTracer::~CpuRayTracer()
+{
+}
+
+void CpuRayTracer::FramebufferReSize(const int& Width, const int& Height)
+{
+	m_FramebufferWidth = Width;
+	m_FramebufferHeight = Height;
+	m_Uniforms.FramebufferWidth = Width;
+	m_Uniforms.FramebufferHeight = Height;
+	m_Uniforms.CropX = 0;
+	m_Uniforms.CropY = 0;
+	m_Uniforms.AspectRatio = (float)Width / (float)Height;
+
+	m_Accumulation.Resize(Width, Height);
+	m_Scheduler.Resize(Width, Height);
+	ResetAccumulation();
+}
+
+//Renders only the Width x Height window at (x, y) of an ImageWidth x ImageHeight image, with the camera rays and
+//sample patterns its pixels get in the whole image. The buffers and everything read from them cover the window.
+//FramebufferReSize goes back to rendering whole images
+void CpuRayTracer::SetCropWindow(const int& ImageWidth, const int& ImageHeight, const int& x, const int& y, const int& Width, const int& Height)
+{
+	m_FramebufferWidth = Width;
+	m_FramebufferHeight = Height;
+	m_Uniforms.FramebufferWidth = ImageWidth;
+	m_Uniforms.FramebufferHeight = ImageHeight;
+	m_Uniforms.CropX = x;
+	m_Uniforms.CropY = y;
+	m_Uniforms.AspectRatio = (float)ImageWidth / (float)ImageHeight;
+
+	m_Accumulation.Resize(Width, Height);
+	m_Scheduler.Resize(Width, Height);
+	ResetAccumulation();
+}
+
+void CpuRayTracer::SetThreadCount(const unsigned int& ThreadCount)
+{
+	m_Pool = std::make_unique<ThreadPool>(ThreadCount);
+}
+
+unsigned int CpuRayTracer::GetThreadCount() const
+{
+	return m_Pool->GetThreadCount();
+}
+
+void CpuRayTracer::SetTileSize(const int& TileSize)
+{
+	m_Scheduler.SetTileSize(TileSize);
+	ResetAccumulation();
+}
+
+const TileScheduler& CpuRayTracer::GetScheduler() const
+{
+	return m_Scheduler;
+}
+
+void CpuRayTracer::SetTraceMode(const TraceMode& mode)
+{
+	m_TraceMode = mode;
+}
+
+TraceMode CpuRayTracer::GetTraceMode() const
+{
+	return m_TraceMode;
+}
+
+void CpuRayTracer::SetSunSampling(const bool& enabled)
+{
+	m_Uniforms.SunSampling = enabled;
+	ResetAccumulation();
+}
+
+void CpuRayTracer::SetLightSampling(const bool& enabled)
+{
+	m_Uniforms.LightSampling = enabled;
+	ResetAccumulation();
+}
+
+void CpuRayTracer::SetLightTreeSampling(const bool& enabled)
+{
+	m_Uniforms.LightTreeSampling = enabled;
+	ResetAccumulation();
+}
+
+void CpuRayTracer::SetRouletteDepth(const int& depth)
+{
+	m_Uniforms.RouletteDepth = depth;
+	ResetAccumulation();
+}
+
+void CpuRayTracer::SetSampler(const SamplerType& type)
+{
+	m_Uniforms.Sampling = type;
+	ResetAccumulation();
+}
+
+//Same as RayTracer, converged tiles are no longer handed out by the scheduler
+void CpuRayTracer::SetNoiseThreshold(const float& threshold)
+{
+	m_Scheduler.SetNoiseThreshold(std::max(threshold, 0.0f), AdaptiveMinSamples);
+}
+
+void CpuRayTracer::SetQualityTarget(const float& target)
+{
+	m_QualityTarget = std::max(target, 0.0f);
+}
+
+void CpuRayTracer::SetTimeLimit(const float& seconds)
+{
+	m_TimeLimit = std::max(seconds, 0.0f);
+}
+
+//The denoiser is guided by the AOVs, they stay on while it is
+void CpuRayTracer::SetAOVs(const bool& enabled)
+{
+	m_Uniforms.WriteAOVs = enabled || m_Denoise;
+	m_Accumulation.SetAOVs(m_Uniforms.WriteAOVs);
+	ResetAccumulation();
+}
+
+//Samples are drawn from index offset on, so renders merged together can each take their own range of them
+void CpuRayTracer::SetSampleOffset(const uint32_t& offset)
+{
+	m_SampleOffset = offset;
+	ResetAccumulation();
+}
+
+void CpuRayTracer::SetDenoise(const bool& enabled)
+{
+	m_Denoise = enabled;
+	m_DenoisedSample = -1;
+	if (m_Denoise && !m_Uniforms.WriteAOVs)
+		SetAOVs(true);
+}
+
+//Rays sent through the extend stage so far, only counted in wavefront mode
+uint64_t CpuRayTracer::ExtendedRays() const
+{
+	uint64_t count = 0;
+	for (const auto& wavefront : m_Wavefronts)
+		count += wavefront->ExtendedRays();
+
+	return count;
+}
+
+//Segments per camera path since the accumulation was last reset
+double CpuRayTracer::AveragePathLength() const
+{
+	return m_PathCount > 0 ? (double)m_PathSegments / (double)m_PathCount : 0.0;
+}
+
+float CpuRayTracer::RelativeError() const
+{
+	return m_Scheduler.RelativeError();
+}
+
+float CpuRayTracer::ActivePixels() const
+{
+	return m_Scheduler.ActivePixels();
+}
+
+float CpuRayTracer::RenderTime() const
+{
+	return std::chrono::duration<float>(std::chrono::steady_clock::now() - m_AccumulationStart).count();
+}
+
+bool CpuRayTracer::Finished() const
+{
+	if (m_CurrentSample < AdaptiveMinSamples)
+		return false;
+
+	if (m_TimeLimit > 0.0f && RenderTime() >= m_TimeLimit)
+		return true;
+
+	return (m_QualityTarget > 0.0f && RelativeError() < m_QualityTarget) || ActivePixels() == 0.0f;
+}
+
+void CpuRayTracer::LoadScene(const Scene& scene)
+{
+	m_Uniforms.SunRadius = scene.m_SunRadius / 200.0f;
+	m_Uniforms.SunIntensity = scene.m_SunIntensity;
+	m_Uniforms.SunAltitude = glm::radians(scene.m_SunAltitude);
+	m_Uniforms.SunAzimuthal = glm::radians(scene.m_SunAzimuthal);
+	m_Uniforms.SkyVariation = scene.m_SkyVariation;
+	m_Uniforms.Sky.Build(m_Uniforms.SunAltitude, m_Uniforms.SunAzimuthal, m_Uniforms.SkyVariation);
+	m_Uniforms.max_depth = scene.m_MaxDepth;
+	m_Uniforms.RouletteDepth = scene.m_RouletteDepth;
+	m_Uniforms.Sampling = scene.m_Sampler;
+	SetNoiseThreshold(scene.m_NoiseThreshold);
+	SetQualityTarget(scene.m_QualityTarget);
+	SetTimeLimit(scene.m_TimeLimit);
+	SetDenoise(scene.m_Denoise);
+	m_Uniforms.Sensor_Size = scene.m_SensorSize / 1000.0f;
+	m_Uniforms.Focal_Length = scene.m_FocalLength / 1000.0f;
+	m_Uniforms.Focus_Dist = scene.m_FocusDist;
+	m_Uniforms.F_Stop = scene.m_FStop;
+	m_Gamma = scene.m_Gamma;
+	m_Exposure = scene.m_Exposure;
+
+	m_Uniforms.RenderBlackHole = scene.RenderBlackHole;
+	m_Uniforms.BlackHolePosition = glm::vec3(scene.BlackHolePosition.x, scene.BlackHolePosition.y, scene.BlackHolePosition.z);
+	m_Uniforms.SchwarzsRadius = scene.SchwarzschildRadius;
+	m_Uniforms.MaxInfluenceRadius = scene.MaxInfluenceRadius;
+	m_Uniforms.StepSize = scene.LightPathStepSize;
+	m_Uniforms.Deflection.Build(m_Uniforms.SchwarzsRadius, m_Uniforms.MaxInfluenceRadius);
+
+	std::unordered_map<std::string, int> MaterialIndexMap;
+	m_Uniforms.MaterialList.clear();
+	for (auto& [name, material] : scene.m_MaterialMap)
+	{
+		CPU::Material out;
+		out.Type = (int)material.Type;
+		out.Albedo = glm::vec3(material.Albedo.x, material.Albedo.y, material.Albedo.z);
+		out.Roughness = material.Roughness;
+		out.Emission = material.Emission;
+		out.IOR = material.IOR;
+
+		MaterialIndexMap[name] = m_Uniforms.MaterialList.size();
+		m_Uniforms.MaterialList.push_back(out);
+	}
+
+	if (m_Uniforms.MaterialList.empty())
+		m_Uniforms.MaterialList.push_back(CPU::Material());
+
+	m_Uniforms.Spheres.Clear();
+	m_Uniforms.Spheres.Reserve(scene.m_SphereMap.size());
+	for (auto& [name, sphere] : scene.m_SphereMap)
+	{
+		int MatIndex = 0;
+		const auto& found = MaterialIndexMap.find(sphere.MaterialName);
+		if (found == MaterialIndexMap.end())
+			std::println("Sphere {} has material {}, does not exist!", name, sphere.MaterialName);
+
+		else
+			MatIndex = found->second;
+
+		m_Uniforms.Spheres.Add(glm::vec3(sphere.Position.x, sphere.Position.y, sphere.Position.z), sphere.Radius, MatIndex);
+	}
+
+	m_Uniforms.BVH.Clear();
+	if (m_Uniforms.Spheres.Size() >= BVHMinSpheres)
+		m_Uniforms.BVH.Build(m_Uniforms.Spheres);
+
+	m_Uniforms.BlackHoleClearRadius = SphereIntersect::ClearRadius(m_Uniforms.Spheres, m_Uniforms.BlackHolePosition);
+
+	std::vector<bool> EmissiveMaterials;
+	std::vector<float> MaterialRadiance;
+	for (const CPU::Material& material : m_Uniforms.MaterialList)
+	{
+		EmissiveMaterials.push_back(material.Emission != 0.0f);
+		MaterialRadiance.push_back(LightTree::Luminance(material.Albedo) * material.Emission);
+	}
+
+	m_Uniforms.Lights.Build(m_Uniforms.Spheres, EmissiveMaterials);
+	m_Uniforms.LightHierarchy.Build(m_Uniforms.Spheres, m_Uniforms.Lights, MaterialRadiance);
+
+	m_Camera.SetOrientation(scene.m_Camera.m_Yaw, scene.m_Camera.m_Pitch);
+	m_Camera.m_Position = scene.m_Camera.m_Position;
+	UpdateCamera();
+	ResetAccumulation();
+}
+
+void CpuRayTracer::Accumulate()
+{
+	if (m_TraceMode == TraceMode::Wavefront)
+	{
+		while (m_Wavefronts.size() < m_Pool->GetThreadCount())
+			m_Wavefronts.push_back(std::make_unique<CPU::Wavefront>());
+
+		m_Scheduler.Run(*m_Pool, [&](Tile& tile, const unsigned int& thread)
+		{
+			RenderTileWavefront(tile, tile.Samples + m_SampleOffset, *m_Wavefronts[thread]);
+		});
+	}
+
+	else
+	{
+		m_Scheduler.Run(*m_Pool, [&](Tile& tile, const unsigned int&)
+		{
+			RenderTile(tile, tile.Samples + m_SampleOffset);
+		});
+	}
+
+	m_CurrentSample++;
+}
+
+//sample is the index of the sample being taken in every pixel of the tile, the samplers draw from it
+void CpuRayTracer::RenderTile(Tile& tile, const uint32_t& sample)
+{
+	int PathSegments = 0;
+	float ErrorSum = 0.0f;
+	for (int y = tile.y; y < tile.y + tile.Height; y++)
+	{
+		for (int x = tile.x; x < tile.x + tile.Width; x++)
+		{
+			CPU::Ray TracingRay;
+			TracingRay.RayOrigin = CPU::SensorPosition(x, y, m_Uniforms);
+			TracingRay.RayColor = glm::vec3(1.0f);
+
+			CPU::FirstHit aov;
+			glm::vec3 color = CPU::TraceRay(TracingRay, m_Uniforms, Sampler(m_Uniforms.Sampling, x + m_Uniforms.CropX, y + m_Uniforms.CropY, sample), PathSegments, aov);
+			ErrorSum += AccumulatePixel((size_t)y * m_FramebufferWidth + x, color);
+
+			if (m_Uniforms.WriteAOVs)
+				AccumulateAOVs((size_t)y * m_FramebufferWidth + x, aov);
+		}
+	}
+
+	tile.Error = std::sqrt(ErrorSum / (float)(tile.Width * tile.Height));
+	m_PathSegments += PathSegments;
+	m_PathCount += (uint64_t)tile.Width * tile.Height;
+}
+
+void CpuRayTracer::RenderTileWavefront(Tile& tile, const uint32_t& sample, CPU::Wavefront& wavefront)
+{
+	const uint64_t ExtendedBefore = wavefront.ExtendedRays();
+	const std::vector<glm::vec3>& colors = wavefront.Trace(tile, m_Uniforms, sample);
+	m_PathSegments += wavefront.ExtendedRays() - ExtendedBefore;
+	m_PathCount += (uint64_t)tile.Width * tile.Height;
+
+	float ErrorSum = 0.0f;
+	for (int y = 0; y < tile.Height; y++)
+	{
+		for (int x = 0; x < tile.Width; x++)
+			ErrorSum += AccumulatePixel((size_t)(tile.y + y) * m_FramebufferWidth + tile.x + x, colors[(size_t)y * tile.Width + x]);
+	}
+
+	if (m_Uniforms.WriteAOVs)
+	{
+		const std::vector<CPU::FirstHit>& hits = wavefront.FirstHits();
+		for (int y = 0; y < tile.Height; y++)
+		{
+			for (int x = 0; x < tile.Width; x++)
+				AccumulateAOVs((size_t)(tile.y + y) * m_FramebufferWidth + tile.x + x, hits[(size_t)y * tile.Width + x]);
+		}
+	}
+
+	tile.Error = std::sqrt(ErrorSum / (float)(tile.Width * tile.Height));
+}
+
+//Adds a sample to the sums of the pixel and returns the squared relative error of its mean, as Accumulator.glsl estimates it
+float CpuRayTracer::AccumulatePixel(const size_t& pixel, const glm::vec3& color)
+{
+	m_Accumulation.AddSample(pixel, color);
+	return m_Accumulation.SquaredError(pixel);
+}
+
+void CpuRayTracer::AccumulateAOVs(const size_t& pixel, const CPU::FirstHit& aov)
+{
+	m_Accumulation.AddAOVs(pixel, aov.Albedo, aov.Normal, aov.Depth, aov.MatIndex, aov.Slot);
+}
+
+void CpuRayTracer::ResetAccumulation()
+{
+	m_CurrentSample = 0;
+	m_DenoisedSample = -1;
+	m_PathSegments = 0;
+	m_PathCount = 0;
+	m_AccumulationStart = std::chrono::steady_clock::now();
+	m_Scheduler.ResetSamples();
+	m_Accumulation.Clear();
+}
+
+unsigned int CpuRayTracer::RenderedSamples() const
+{
+	return m_CurrentSample;
+}
+
+//Filters the accumulated image, GetRenderedImage shows the result until the next pass
+const std::vector<glm::vec3>& CpuRayTracer::Denoise()
+{
+	if (!m_Denoise)
+	{
+		std::println("Warning: Call to Denoise without enabling it, try SetDenoise first");
+		m_DenoisedBuffer = m_Accumulation.MeanImage();
+		return m_DenoisedBuffer;
+	}
+
+	if (m_DenoisedSample == m_CurrentSample)
+		return m_DenoisedBuffer;
+
+	const size_t count = m_Accumulation.Size();
+	std::vector<glm::vec3> color(count), albedo(count), normal(count);
+	std::vector<float> depth(count), variance(count);
+	for (size_t i = 0; i < count; i++)
+	{
+		color[i] = m_Accumulation.Mean(i);
+		albedo[i] = m_Accumulation.Albedo(i);
+		normal[i] = m_Accumulation.Normal(i);
+		depth[i] = m_Accumulation.Depth(i);
+		variance[i] = m_Accumulation.Variance(i);
+	}
+
+	DenoiseInput input;
+	input.Width = m_FramebufferWidth;
+	input.Height = m_FramebufferHeight;
+	input.Color = color.data();
+	input.Albedo = albedo.data();
+	input.Normal = normal.data();
+	input.Depth = depth.data();
+	input.Variance = variance.data();
+
+	m_DenoisedBuffer = m_Denoiser.Denoise(*m_Pool, input);
+	m_DenoisedSample = m_CurrentSample;
+	return m_DenoisedBuffer;
+}
+
+//Mean of every pixel
+std::vector<glm::vec3> CpuRayTracer::GetAccumulationBuffer() const
+{
+	return m_Accumulation.MeanImage();
+}
+
+const AccumulationBuffer& CpuRayTracer::GetAccumulation() const
+{
+	return m_Accumulation;
+}
+
+//Adds the samples of a buffer rendered elsewhere to the ones here, see AccumulationBuffer::Merge
+bool CpuRayTracer::Merge(const AccumulationBuffer& other)
+{
+	if (!m_Accumulation.Merge(other))
+		return false;
+
+	m_DenoisedSample = -1;
+	return true;
+}
+
+//Same layout as RayTracer::GetAOV, AOVChannelMap.at(aov) floats per pixel with rows bottom up
+std::vector<float> CpuRayTracer::GetAOV(const AOV& aov) const
+{
+	if (aov != AOV::Color && !m_Uniforms.WriteAOVs)
+	{
+		std::println("Attempting to read AOV {}, AOVs are not being written, try SetAOVs first", aov);
+		return std::vector<float>();
+	}
+
+	const size_t count = (size_t)m_FramebufferWidth * m_FramebufferHeight;
+	std::vector<float> values(count * AOVChannelMap.at(aov));
+	for (size_t i = 0; i < count; i++)
+	{
+		if (aov == AOV::Color || aov == AOV::Albedo || aov == AOV::Normal)
+		{
+			const glm::vec3 value = aov == AOV::Color ? m_Accumulation.Mean(i) : aov == AOV::Albedo ? m_Accumulation.Albedo(i) : m_Accumulation.Normal(i);
+			values[3 * i] = value.x;
+			values[3 * i + 1] = value.y;
+			values[3 * i + 2] = value.z;
+		}
+
+		else if (aov == AOV::Depth)
+			values[i] = m_Accumulation.Depth(i);
+
+		else
+			values[i] = (float)(aov == AOV::MaterialID ? m_Accumulation.MaterialID(i) : m_Accumulation.ObjectID(i));
+	}
+
+	return values;
+}
+
+//Same tone mapping as PostProcess.glsl, rows are bottom up to match RayTracer::GetRenderedImage. Shows the denoised
+//image if Denoise has run since the last pass
+unsigned char* CpuRayTracer::GetRenderedImage() const
+{
+	unsigned char* Image = new unsigned char[3 * m_FramebufferWidth * m_FramebufferHeight];
+	const std::vector<glm::vec3> image = m_Denoise && m_DenoisedSample == m_CurrentSample ? m_DenoisedBuffer : m_Accumulation.MeanImage();
+
+	const float alpha = 5.0f;
+	const float beta = 2.0f;
+
+	for (int y = 0; y < m_FramebufferHeight; y++)
+	{
+		for (int x = 0; x < m_FramebufferWidth; x++)
+		{
+			const int SourceX = m_FramebufferWidth - 1 - x;							//PostProcess.glsl samples at 1.0 - TexCoords
+			const int SourceY = m_FramebufferHeight - 1 - y;
+			const glm::vec3& color = image[(size_t)SourceY * m_FramebufferWidth + SourceX];
+
+			for (int channel = 0; channel < 3; channel++)
+			{
+				float value = color[channel] * m_Exposure / 10.0f;
+				value = std::pow(value, alpha);
+				value = value / (value + beta);
+				value = std::pow(value, 1.0f / m_Gamma);
+				value = std::clamp(value, 0.0f, 1.0f);
+				Image[3 * ((size_t)y * m_FramebufferWidth + x) + channel] = (unsigned char)std::lround(value * 255.0f);
+			}
+		}
+	}
+
+	return Image;
+}
+
+int CpuRayTracer::GetFramebufferWidth() const
+{
+	return m_FramebufferWidth;
+}
+
+int CpuRayTracer::GetFramebufferHeight() const
+{
+	return m_FramebufferHeight;
+}
+
+void CpuRayTracer::SetCameraPosition(const glm::vec3& Position)
+{
+	m_Camera.m_Position = Position;
+	UpdateCamera();
+}
+
+void CpuRayTracer::SetCameraOrientation(const float& yaw, const float& pitch)
+{
+	m_Camera.SetOrientation(yaw, pitch);
+	UpdateCamera();
+}
+
+void CpuRayTracer::MoveCamera(const float& deltaX, const float& deltaY, const float& deltaZ)
+{
+	m_Camera.Move(deltaX, deltaY, deltaZ);
+	UpdateCamera();
+}
+
+void CpuRayTracer::TurnCamera(const float& xoffset, const float& yoffset)
+{
+	m_Camera.Turn(xoffset, yoffset);
+	UpdateCamera();
+}
+
+Camera CpuRayTracer::GetCamera() const
+{
+	return m_Camera;
+}
+
+void CpuRayTracer::UpdateCamera()
+{
+	m_Uniforms.CameraPos = m_Camera.m_Position;
+	m_Uniforms.CameraToWorld = glm::transpose(m_Camera.GetViewMatrix());
+}
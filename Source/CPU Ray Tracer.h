@@ -0,0 +1,296 @@
+#pragma once
+
+#include <vector>
+#include <memory>
+#include <atomic>
+#include <print>
+#include <chrono>
+
+#include <glm.hpp>
+
+#include "Model.h"
+#include "Camera.h"
+#include "Scene.h"
+#include "ThreadPool.h"
+#include "TileScheduler.h"
+#include "SphereIntersect.h"
+#include "BVH.h"
+#include "DeflectionTable.h"
+#include "SkyTable.h"
+#include "LightList.h"
+#include "LightTree.h"
+#include "Sampler.h"
+#include "AOV.h"
+#include "Denoiser.h"
+#include "AccumulationBuffer.h"
+
+//Host side port of res/Ray.glsl, kept function for function so both backends converge to the same image
+namespace CPU
+{
+	struct Diffuse
+	{
+		glm::vec3 Albedo;
+		float Roughness;
+		float Emission;
+	};
+
+	struct Glass
+	{
+		glm::vec3 Albedo;
+		float IOR;
+	};
+
+	const int DiffuseType = 0;
+	const int GlassType = 1;
+
+	struct Material
+	{
+		int Type = DiffuseType;
+		glm::vec3 Albedo = glm::vec3(0.0f);
+		float Roughness = 0.0f;
+		float Emission = 0.0f;
+		float IOR = 1.5f;
+	};
+
+	struct Sphere
+	{
+		glm::vec3 Position = glm::vec3(0.0f);
+		float Radius = 1.0f;
+		int MatIndex = 0;
+	};
+
+	struct Ray
+	{
+		glm::vec3 RayOrigin;
+		glm::vec3 RayDir;
+		glm::vec3 RayColor;
+		float ScatterPdf = 0.0f;												//Density the last bounce drew RayDir with, 0 when light sampling couldn't have
+	};
+
+	struct HitRecord
+	{
+		bool Hit = false;
+		float t = -1.0f;
+		Sphere HitSphere;
+		int Slot = -1;															//Only set by the scene wide HitPoint, lets emissive hits find their light
+	};
+
+	//First surface a camera path meets, or the sky for paths that miss everything. Both ids stay -1 on a miss
+	struct FirstHit
+	{
+		glm::vec3 Albedo = glm::vec3(0.0f);
+		glm::vec3 Normal = glm::vec3(0.0f);										//World space
+		float Depth = 0.0f;														//Along the view axis
+		int MatIndex = -1;
+		int Slot = -1;
+	};
+
+	//Photon state in the orbital plane of the hole, Velocity is d(Radial)/d(lambda) and h = |Radial x Velocity| is conserved
+	struct BlackHoleInfo
+	{
+		glm::vec3 BlackHolePos = glm::vec3(0.0f);
+		float SchwarzschildRadius = 0.0f;
+		float PSphereRadius = 0.0f;
+		float CriticalImpact = 0.0f;
+		glm::vec3 Radial = glm::vec3(0.0f);
+		float r = 0.0f;
+		glm::vec3 Velocity = glm::vec3(0.0f);
+		float h = 0.0f;
+		bool Escaped = true;
+		bool Captured = false;
+		float dt = 0.0f;
+		float ClearRadius = 0.0f;
+		bool Deflect = false;													//No sphere inside the influence sphere, photons entering it use the table
+		Sphere Influence;
+	};
+
+	const float RouletteSurvival = 0.95f;										//Cap on the chance a path survives roulette, so clear glass can't keep it going
+	const float SunCone = 6.0f;													//Sun radii out to which the disk is evaluated and sampled, past it adds < 1e-12
+	const float GeodesicGrowth = 2.0f;											//Extra step length per photon sphere radius of distance from it
+	const float EscapeBend = 1e-3f;												//Bending left below which an outgoing photon is sent straight
+
+	//Mirrors Uniforms.glsl, except that everything is in world space rather than camera space
+	struct Uniforms
+	{
+		float Sensor_Size = 0.1f;
+		float Focal_Length = 0.035f;
+		float Focus_Dist = 1.0f;
+		float F_Stop = 1.4f;
+		glm::vec3 CameraPos = glm::vec3(0.0f);
+		glm::mat3 CameraToWorld = glm::mat3(1.0f);
+
+		int max_depth = 60;
+		int RouletteDepth = 3;														//Bounces before Russian roulette starts, max_depth stays a hard cap
+		int FramebufferWidth = 1;													//Of the whole image, the buffers only hold the crop window
+		int FramebufferHeight = 1;
+		int CropX = 0;																//Image pixel of the buffers' first one
+		int CropY = 0;
+		float AspectRatio = 1.0f;
+		SamplerType Sampling = SamplerType::Sobol;
+		bool WriteAOVs = false;														//Fill in the FirstHit of every camera path
+
+		SphereStore Spheres;
+		SphereBVH BVH;															//Only built once there are enough spheres to beat the SIMD loop
+		std::vector<Material> MaterialList;
+
+		bool RenderBlackHole = false;
+		glm::vec3 BlackHolePosition = glm::vec3(0.0f);
+		float SchwarzsRadius = 1.0f;
+		float MaxInfluenceRadius = 10.0f;
+		float StepSize = 0.03f;
+		float BlackHoleClearRadius = 0.0f;											//Distance from the hole to the nearest sphere surface
+		DeflectionTable Deflection;
+
+		float SunRadius = 0.004f;
+		float SunIntensity = 800.0f;
+		bool SunSampling = true;													//Next event estimation toward the sun at Lambertian vertices
+		float SunAltitude = 0.0f;
+		float SunAzimuthal = 0.0f;
+		float SkyVariation = 0.2f;
+		SkyTable Sky;																//Rebaked whenever the sun altitude, azimuthal or sky variation change
+
+		LightList Lights;
+		LightTree LightHierarchy;
+		bool LightSampling = true;													//Next event estimation toward emissive spheres at Lambertian vertices
+		bool LightTreeSampling = true;												//Pick the light through LightHierarchy rather than uniformly
+	};
+
+	glm::vec3 PointOnDisk(const glm::vec2& random);
+	glm::vec3 PointOnSphere(const glm::vec2& random);
+
+	glm::vec3 SunRadiance(const float& distance, const Uniforms& uniforms);
+	float SunPdf(const float& distance, const Uniforms& uniforms);
+	glm::vec3 WorldColor(glm::vec3 direction, const Uniforms& uniforms, const float& DiskWeight = 1.0f);
+	HitRecord HitPoint(const Ray& ray, const Sphere& sphere);
+	HitRecord HitPoint(const Ray& ray, const Uniforms& uniforms);
+	void Scatter(const Diffuse& diffuse, Ray& ray, const HitRecord& record, const Sampler& sampler);
+	float reflectance(const float& cosine, const float& IOR);
+	void Scatter(const Glass& glass, Ray& ray, const HitRecord& record, const Sampler& sampler);
+	bool StaysStraight(const Ray& ray, const Uniforms& uniforms);
+	bool Occluded(const Ray& ray, const Uniforms& uniforms, const float& MaxT);
+	float PowerHeuristic(const float& pdf, const float& OtherPdf);
+	bool SamplesSun(const Uniforms& uniforms);
+	bool SamplesLights(const Uniforms& uniforms);
+	float ConeOneMinusCos(const float& distance2, const float& radius);
+	int PickLight(const glm::vec3& point, const float& u, const Uniforms& uniforms, float& PickPdf);
+	float PickPdf(const glm::vec3& point, const size_t& light, const Uniforms& uniforms);
+	float LightPdf(const Ray& ray, const Sphere& light, const float& PickPdf, const Uniforms& uniforms);
+	float SunWeight(const Ray& ray, const Uniforms& uniforms);
+	float EmissionWeight(const Ray& ray, const HitRecord& record, const Uniforms& uniforms);
+	glm::vec3 SampleSun(const Ray& ray, const glm::vec3& normal, const Uniforms& uniforms, const Sampler& sampler);
+	glm::vec3 SampleLights(const Ray& ray, const glm::vec3& normal, const Uniforms& uniforms, const Sampler& sampler);
+	glm::vec3 DirectLight(Ray& ray, const HitRecord& record, const Diffuse& diffuse, const Uniforms& uniforms, const Sampler& sampler);
+	glm::vec3 UpdateRay(Ray& ray, const HitRecord& record, const Uniforms& uniforms, const Sampler& sampler);
+	bool Survives(Ray& ray, const Sampler& sampler);
+	glm::vec3 GeodesicAcceleration(const glm::vec3& Radial, const float& h2, const float& SchwarzschildRadius);
+	float GeodesicStep(const BlackHoleInfo& BHInfo, const glm::vec3& acceleration, const float& speed);
+	float ImpactParameter(const BlackHoleInfo& BHInfo);
+	void ClassifyGeodesic(BlackHoleInfo& BHInfo);
+	bool UpdateRay(Ray& ray, BlackHoleInfo& BHInfo, const float& MaxStep);
+	bool DeflectRay(Ray& ray, BlackHoleInfo& BHInfo, const DeflectionTable& table, const float& HitT);
+	glm::vec3 SensorPosition(const int& x, const int& y, const Uniforms& uniforms);
+	Ray GetRay(glm::vec3 PixelPos, const Uniforms& uniforms, const Sampler& sampler);
+	void ComputeBlackHoleInfo(const Ray& ray, BlackHoleInfo& BHInfo);
+	void StartBlackHole(const Ray& ray, const Uniforms& uniforms, BlackHoleInfo& BHInfo);
+	void RecordSurface(FirstHit& aov, const Ray& ray, const HitRecord& record, const Uniforms& uniforms);
+	void RecordSky(FirstHit& aov, const Ray& ray, const Uniforms& uniforms);
+	glm::vec3 TraceRay(Ray ray, const Uniforms& uniforms, Sampler sampler, int& PathLength, FirstHit& aov);
+
+	class Wavefront;
+}
+
+//Megakernel follows every path to the end before starting the next one, like Ray.glsl does,
+//Wavefront advances the whole tile a bounce at a time through per stage queues
+enum class TraceMode
+{
+	Megakernel,
+	Wavefront
+};
+
+class CpuRayTracer
+{
+public:
+	CpuRayTracer(const int& FramebufferWidth, const int& FramebufferHeight, const unsigned int& ThreadCount = 0);
+	~CpuRayTracer();
+
+	void FramebufferReSize(const int& Width, const int& Height);
+	void SetCropWindow(const int& ImageWidth, const int& ImageHeight, const int& x, const int& y, const int& Width, const int& Height);
+	void SetThreadCount(const unsigned int& ThreadCount);
+	unsigned int GetThreadCount() const;
+	void SetTileSize(const int& TileSize);
+	const TileScheduler& GetScheduler() const;
+	void SetTraceMode(const TraceMode& mode);
+	TraceMode GetTraceMode() const;
+	void SetSunSampling(const bool& enabled);
+	void SetLightSampling(const bool& enabled);
+	void SetLightTreeSampling(const bool& enabled);
+	void SetRouletteDepth(const int& depth);
+	void SetSampler(const SamplerType& type);
+	void SetNoiseThreshold(const float& threshold);
+	void SetQualityTarget(const float& target);
+	void SetTimeLimit(const float& seconds);
+	void SetAOVs(const bool& enabled);
+	void SetDenoise(const bool& enabled);
+	void SetSampleOffset(const uint32_t& offset);
+	uint64_t ExtendedRays() const;
+	double AveragePathLength() const;
+	float RelativeError() const;
+	float ActivePixels() const;
+	float RenderTime() const;
+	bool Finished() const;
+
+	void LoadScene(const Scene& scene);
+	void Accumulate();
+	void ResetAccumulation();
+	unsigned int RenderedSamples() const;
+	const std::vector<glm::vec3>& Denoise();
+
+	std::vector<glm::vec3> GetAccumulationBuffer() const;
+	const AccumulationBuffer& GetAccumulation() const;
+	bool Merge(const AccumulationBuffer& other);
+	std::vector<float> GetAOV(const AOV& aov) const;
+	unsigned char* GetRenderedImage() const;
+	int GetFramebufferWidth() const;
+	int GetFramebufferHeight() const;
+
+	void SetCameraPosition(const glm::vec3& Position);
+	void SetCameraOrientation(const float& yaw, const float& pitch);
+	void MoveCamera(const float& deltaX, const float& deltaY, const float& deltaZ);
+	void TurnCamera(const float& xoffset, const float& yoffset);
+	Camera GetCamera() const;
+
+private:
+	void UpdateCamera();
+	void RenderTile(Tile& tile, const uint32_t& sample);
+	void RenderTileWavefront(Tile& tile, const uint32_t& sample, CPU::Wavefront& wavefront);
+	float AccumulatePixel(const size_t& pixel, const glm::vec3& color);
+	void AccumulateAOVs(const size_t& pixel, const CPU::FirstHit& aov);
+
+private:
+	std::unique_ptr<ThreadPool> m_Pool;
+	TileScheduler m_Scheduler;
+	Camera m_Camera;
+	CPU::Uniforms m_Uniforms;
+	TraceMode m_TraceMode = TraceMode::Megakernel;
+	std::vector<std::unique_ptr<CPU::Wavefront>> m_Wavefronts;						//One per pool thread, reused across tiles
+
+	float m_Gamma = 2.2f;
+	float m_Exposure = 1.5f;
+
+	int m_FramebufferWidth;
+	int m_FramebufferHeight;
+	int m_CurrentSample = 0;
+	uint32_t m_SampleOffset = 0;
+
+	float m_QualityTarget = 0.0f;
+	float m_TimeLimit = 0.0f;
+	std::chrono::steady_clock::time_point m_AccumulationStart;
+
+	AccumulationBuffer m_Accumulation;
+	Denoiser m_Denoiser;
+	bool m_Denoise = false;
+	std::vector<glm::vec3> m_DenoisedBuffer;
+	int m_DenoisedSample = -1;														//Pass count m_DenoisedBuffer was filtered at, -1 once it's out of date
+	std::atomic<uint64_t> m_PathSegments = 0;										//Since the last reset, summed over every path traced
+	std::atomic<uint64_t> m_PathCount = 0;
+};
@@ -14,7 +14,7 @@ void Camera::Move(const float& deltaX, const float& deltaY, const float& deltaZ)
     m_Position -= deltaZ * m_Front;
 }
 
-void Camera::Turn(float xoffset, float yoffset, GLboolean constrainPitch)
+void Camera::Turn(float xoffset, float yoffset, bool constrainPitch)
 {
     xoffset *= MouseSensitivity;
     yoffset *= MouseSensitivity;
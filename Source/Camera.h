@@ -1,7 +1,5 @@
 #pragma once
 
-#include <GL/glew.h>
-#include <GLFW/glfw3.h>
 #include <glm.hpp>
 #include <gtc/matrix_transform.hpp>
 
@@ -40,7 +38,7 @@ public:
 
     glm::mat3 GetViewMatrix() const;
     void Move(const float& deltaX, const float& deltaY, const float& deltaZ);
-    void Turn(float xoffset, float yoffset, GLboolean constrainPitch = true);
+    void Turn(float xoffset, float yoffset, bool constrainPitch = true);
     void SetOrientation(const float& yaw, const float& pitch);
     void SetYaw(const float& yaw);
     void SetPitch(const float& pitch);
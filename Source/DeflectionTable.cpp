@@ -0,0 +1,115 @@
+#include "DeflectionTable.h"
+
+#include <algorithm>
+#include <cmath>
+
+void DeflectionTable::Build(const float& SchwarzschildRadius, const float& InfluenceRadius, const int& size)
+{
+	if (SchwarzschildRadius == m_SchwarzschildRadius && InfluenceRadius == m_InfluenceRadius && (int)m_Angles.size() == size)
+		return;
+
+	Clear();
+	if (SchwarzschildRadius <= 0.0f || InfluenceRadius <= 0.0f || size < 2)
+		return;
+
+	m_SchwarzschildRadius = SchwarzschildRadius;
+	m_InfluenceRadius = InfluenceRadius;
+
+	//b^-2 = h^-2 - Rs / R^3 for a photon entering with unit speed, and everything under the critical b falls in
+	const double rs = SchwarzschildRadius;
+	const double R = InfluenceRadius;
+	const double CriticalImpact = 1.5 * std::sqrt(3.0) * rs;
+	m_CriticalH = R <= 1.5 * rs ? InfluenceRadius : (float)(1.0 / std::sqrt(1.0 / (CriticalImpact * CriticalImpact) + rs / (R * R * R)));
+
+	m_Angles.resize(size);
+	for (int i = 0; i < size; i++)
+	{
+		const double t = std::max((double)i, 0.25) / (size - 1);
+		const double h = m_CriticalH + (R - m_CriticalH) * t * t;
+		m_Angles[i] = (float)(2.0 * PeriapsisAngle(h));
+	}
+}
+
+void DeflectionTable::Clear()
+{
+	m_SchwarzschildRadius = 0.0f;
+	m_InfluenceRadius = 0.0f;
+	m_CriticalH = 0.0f;
+	m_Angles.clear();
+}
+
+//Linear in t, returns false for photons that are captured
+bool DeflectionTable::SweptAngle(const float& h, float& angle) const
+{
+	if (h < m_CriticalH || m_CriticalH >= m_InfluenceRadius)
+		return false;
+
+	const float t = std::sqrt(std::clamp((h - m_CriticalH) / (m_InfluenceRadius - m_CriticalH), 0.0f, 1.0f));
+	const float position = t * (float)(m_Angles.size() - 1);
+	const size_t index = std::min((size_t)position, m_Angles.size() - 2);
+	const float fraction = position - (float)index;
+
+	angle = m_Angles[index] + fraction * (m_Angles[index + 1] - m_Angles[index]);
+	return true;
+}
+
+bool DeflectionTable::Empty() const
+{
+	return m_Angles.empty();
+}
+
+float DeflectionTable::CriticalH() const
+{
+	return m_CriticalH;
+}
+
+float DeflectionTable::InfluenceRadius() const
+{
+	return m_InfluenceRadius;
+}
+
+const std::vector<float>& DeflectionTable::GetAngles() const
+{
+	return m_Angles;
+}
+
+//The orbit is symmetric about its periapsis, so the swept angle is twice the angle it takes to get there.
+//RK4 on u = 1 / r over the polar angle, u'' = 1.5 Rs u^2 - u, the orbit equation of the force the march integrates
+double DeflectionTable::PeriapsisAngle(const double& h) const
+{
+	const double rs = m_SchwarzschildRadius;
+	const double R = m_InfluenceRadius;
+
+	auto curvature = [rs](const double& u)
+	{
+		return 1.5 * rs * u * u - u;
+	};
+
+	double u = 1.0 / R;
+	double w = std::sqrt(std::max(1.0 - h * h / (R * R), 0.0)) / h;					//du/dphi, the radial speed is -h du/dphi
+	double phi = 0.0;
+
+	while (phi < 0.5 * MaxAngle)
+	{
+		const double k1u = w;
+		const double k1w = curvature(u);
+		const double k2u = w + 0.5 * AngleStep * k1w;
+		const double k2w = curvature(u + 0.5 * AngleStep * k1u);
+		const double k3u = w + 0.5 * AngleStep * k2w;
+		const double k3w = curvature(u + 0.5 * AngleStep * k2u);
+		const double k4u = w + AngleStep * k3w;
+		const double k4w = curvature(u + AngleStep * k3u);
+
+		const double NextU = u + AngleStep / 6.0 * (k1u + 2.0 * k2u + 2.0 * k3u + k4u);
+		const double NextW = w + AngleStep / 6.0 * (k1w + 2.0 * k2w + 2.0 * k3w + k4w);
+
+		if (NextW <= 0.0)
+			return phi + AngleStep * w / (w - NextW);
+
+		u = NextU;
+		w = NextW;
+		phi += AngleStep;
+	}
+
+	return phi;
+}
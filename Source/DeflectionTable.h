@@ -0,0 +1,32 @@
+#pragma once
+
+#include <vector>
+
+//Photons enter the influence sphere of radius R with unit speed, so their orbit only depends on h = |Radial x Velocity|.
+//The table holds the polar angle swept between entering and leaving it, sampled at t = sqrt((h - hc) / (R - hc)) so the
+//samples crowd around the critical hc, where the angle grows without bound. Photons with h < hc never come back out
+class DeflectionTable
+{
+public:
+	void Build(const float& SchwarzschildRadius, const float& InfluenceRadius, const int& size = 1024);
+	void Clear();
+
+	bool SweptAngle(const float& h, float& angle) const;
+
+	bool Empty() const;
+	float CriticalH() const;
+	float InfluenceRadius() const;
+	const std::vector<float>& GetAngles() const;
+
+private:
+	double PeriapsisAngle(const double& h) const;
+
+private:
+	static constexpr double AngleStep = 1e-3;
+	static constexpr double MaxAngle = 16.0;										//Stops photons winding around the photon sphere
+
+	float m_SchwarzschildRadius = 0.0f;
+	float m_InfluenceRadius = 0.0f;
+	float m_CriticalH = 0.0f;
+	std::vector<float> m_Angles;
+};
@@ -0,0 +1,367 @@
+#include "Denoiser.h"
+
+#include <cmath>
+#include <algorithm>
+
+#include "SphereIntersect.h"
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+	#define HALOGEN_X86
+	#include <immintrin.h>
+#endif
+
+#if defined(_MSC_VER) && !defined(__clang__)
+	#define HALOGEN_TARGET(isa)
+#else
+	#define HALOGEN_TARGET(isa) __attribute__((target(isa)))
+#endif
+
+static const float Kernel[5] = { 1.0f / 16.0f, 1.0f / 4.0f, 3.0f / 8.0f, 1.0f / 4.0f, 1.0f / 16.0f };
+static const float GuideEpsilon = 1e-4f;
+static const float MinAlbedo = 0.01f;											//Keeps black surfaces from dividing the noise up without bound
+static const float MaxExponent = 16.0f;											//Taps weighted below e^-16 are dropped rather than left to go denormal
+
+//Everything one iteration reads and writes
+struct FilterPass
+{
+	int Width = 0;
+	int Height = 0;
+	int Step = 1;
+	float NormalSigma = 0.0f;
+	float DepthSigma = 0.0f;
+	float InvDistance[25] = {};													//Per tap, 0 for the center which has no depth difference to scale
+
+	const float* R = nullptr;
+	const float* G = nullptr;
+	const float* B = nullptr;
+	const float* Variance = nullptr;
+	const float* NX = nullptr;
+	const float* NY = nullptr;
+	const float* NZ = nullptr;
+	const float* Depth = nullptr;
+	const float* DepthSlope = nullptr;
+
+	float* OutR = nullptr;
+	float* OutG = nullptr;
+	float* OutB = nullptr;
+	float* OutVariance = nullptr;
+};
+
+static float Luminance(const float& r, const float& g, const float& b)
+{
+	return 0.2126f * r + 0.7152f * g + 0.0722f * b;
+}
+
+//The normal term exp(-NormalSigma * (1 - cos)) is close to cos^NormalSigma near 1 and shares the exp with the others
+static void FilterPixelScalar(const FilterPass& pass, const int& x, const int& y, const float& InvSigma)
+{
+	const size_t i = (size_t)y * pass.Width + x;
+	const float nx = pass.NX[i];
+	const float ny = pass.NY[i];
+	const float nz = pass.NZ[i];
+	if (nx == 0.0f && ny == 0.0f && nz == 0.0f)
+	{
+		pass.OutR[i] = pass.R[i];
+		pass.OutG[i] = pass.G[i];
+		pass.OutB[i] = pass.B[i];
+		pass.OutVariance[i] = pass.Variance[i];
+		return;
+	}
+
+	const float depth = pass.Depth[i];
+	const float luminance = Luminance(pass.R[i], pass.G[i], pass.B[i]);
+	const float InvDepth = 1.0f / (pass.DepthSigma * pass.DepthSlope[i] * (float)pass.Step + GuideEpsilon);
+
+	float SumR = 0.0f, SumG = 0.0f, SumB = 0.0f, SumWeight = 0.0f, SumVariance = 0.0f;
+	for (int ty = 0; ty < 5; ty++)
+	{
+		const int qy = y + (ty - 2) * pass.Step;
+		if (qy < 0 || qy >= pass.Height)
+			continue;
+
+		for (int tx = 0; tx < 5; tx++)
+		{
+			const int qx = x + (tx - 2) * pass.Step;
+			if (qx < 0 || qx >= pass.Width)
+				continue;
+
+			const size_t j = (size_t)qy * pass.Width + qx;
+			const float cosine = nx * pass.NX[j] + ny * pass.NY[j] + nz * pass.NZ[j];
+			if (cosine <= 0.0f)
+				continue;
+
+			const float exponent = pass.NormalSigma * (1.0f - cosine) + std::abs(depth - pass.Depth[j]) * InvDepth * pass.InvDistance[ty * 5 + tx]
+				+ std::abs(luminance - Luminance(pass.R[j], pass.G[j], pass.B[j])) * InvSigma;
+			if (exponent > MaxExponent)
+				continue;
+
+			const float weight = Kernel[ty] * Kernel[tx] * std::exp(-exponent);
+
+			SumR += weight * pass.R[j];
+			SumG += weight * pass.G[j];
+			SumB += weight * pass.B[j];
+			SumWeight += weight;
+			SumVariance += weight * weight * pass.Variance[j];
+		}
+	}
+
+	pass.OutR[i] = SumR / SumWeight;
+	pass.OutG[i] = SumG / SumWeight;
+	pass.OutB[i] = SumB / SumWeight;
+	pass.OutVariance[i] = SumVariance / (SumWeight * SumWeight);
+}
+
+#ifdef HALOGEN_X86
+	//e^x for -MaxExponent <= x <= 0, split into 2^n e^r with |r| <= ln 2 / 2 and a degree 5 polynomial for e^r, about
+	//3e-6 relative error
+	HALOGEN_TARGET("avx2")
+	static inline __m256 NegativeExp(const __m256& value)
+	{
+		const __m256 x = _mm256_max_ps(value, _mm256_set1_ps(-MaxExponent));
+		const __m256 n = _mm256_round_ps(_mm256_mul_ps(x, _mm256_set1_ps(1.44269504f)), _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+		const __m256 r = _mm256_sub_ps(x, _mm256_mul_ps(n, _mm256_set1_ps(0.693147181f)));
+
+		__m256 p = _mm256_set1_ps(1.0f / 120.0f);
+		p = _mm256_add_ps(_mm256_mul_ps(p, r), _mm256_set1_ps(1.0f / 24.0f));
+		p = _mm256_add_ps(_mm256_mul_ps(p, r), _mm256_set1_ps(1.0f / 6.0f));
+		p = _mm256_add_ps(_mm256_mul_ps(p, r), _mm256_set1_ps(0.5f));
+		p = _mm256_add_ps(_mm256_mul_ps(p, r), _mm256_set1_ps(1.0f));
+		p = _mm256_add_ps(_mm256_mul_ps(p, r), _mm256_set1_ps(1.0f));
+
+		const __m256i scale = _mm256_slli_epi32(_mm256_add_epi32(_mm256_cvtps_epi32(n), _mm256_set1_epi32(127)), 23);
+		return _mm256_mul_ps(p, _mm256_castsi256_ps(scale));
+	}
+
+	HALOGEN_TARGET("avx2")
+	static inline __m256 Luminance8(const __m256& r, const __m256& g, const __m256& b)
+	{
+		return _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(0.2126f), r), _mm256_mul_ps(_mm256_set1_ps(0.7152f), g)), _mm256_mul_ps(_mm256_set1_ps(0.0722f), b));
+	}
+
+	//FilterPixelScalar for the 8 pixels from x on, every tap of which has to be inside the row
+	HALOGEN_TARGET("avx2")
+	static void FilterPixelsAVX2(const FilterPass& pass, const int& x, const int& y, const float* InvSigma)
+	{
+		const size_t i = (size_t)y * pass.Width + x;
+		const __m256 zero = _mm256_setzero_ps();
+		const __m256 one = _mm256_set1_ps(1.0f);
+		const __m256 AbsMask = _mm256_castsi256_ps(_mm256_set1_epi32(0x7FFFFFFF));
+
+		const __m256 nx = _mm256_loadu_ps(pass.NX + i);
+		const __m256 ny = _mm256_loadu_ps(pass.NY + i);
+		const __m256 nz = _mm256_loadu_ps(pass.NZ + i);
+		const __m256 depth = _mm256_loadu_ps(pass.Depth + i);
+		const __m256 luminance = Luminance8(_mm256_loadu_ps(pass.R + i), _mm256_loadu_ps(pass.G + i), _mm256_loadu_ps(pass.B + i));
+		const __m256 InvDepth = _mm256_div_ps(one, _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(pass.DepthSigma * (float)pass.Step), _mm256_loadu_ps(pass.DepthSlope + i)), _mm256_set1_ps(GuideEpsilon)));
+		const __m256 InvSigma8 = _mm256_loadu_ps(InvSigma);
+		const __m256 NormalSigma = _mm256_set1_ps(pass.NormalSigma);
+
+		__m256 SumR = zero, SumG = zero, SumB = zero, SumWeight = zero, SumVariance = zero;
+		for (int ty = 0; ty < 5; ty++)
+		{
+			const int qy = y + (ty - 2) * pass.Step;
+			if (qy < 0 || qy >= pass.Height)
+				continue;
+
+			for (int tx = 0; tx < 5; tx++)
+			{
+				const size_t j = (size_t)qy * pass.Width + x + (tx - 2) * pass.Step;
+				const __m256 r = _mm256_loadu_ps(pass.R + j);
+				const __m256 g = _mm256_loadu_ps(pass.G + j);
+				const __m256 b = _mm256_loadu_ps(pass.B + j);
+
+				const __m256 cosine = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(nx, _mm256_loadu_ps(pass.NX + j)), _mm256_mul_ps(ny, _mm256_loadu_ps(pass.NY + j))), _mm256_mul_ps(nz, _mm256_loadu_ps(pass.NZ + j)));
+				const __m256 DepthTerm = _mm256_mul_ps(_mm256_and_ps(_mm256_sub_ps(depth, _mm256_loadu_ps(pass.Depth + j)), AbsMask), _mm256_mul_ps(InvDepth, _mm256_set1_ps(pass.InvDistance[ty * 5 + tx])));
+				const __m256 LuminanceTerm = _mm256_mul_ps(_mm256_and_ps(_mm256_sub_ps(luminance, Luminance8(r, g, b)), AbsMask), InvSigma8);
+				const __m256 exponent = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(NormalSigma, _mm256_sub_ps(one, cosine)), DepthTerm), LuminanceTerm);
+
+				__m256 weight = _mm256_mul_ps(_mm256_set1_ps(Kernel[ty] * Kernel[tx]), NegativeExp(_mm256_sub_ps(zero, exponent)));
+				weight = _mm256_and_ps(weight, _mm256_and_ps(_mm256_cmp_ps(cosine, zero, _CMP_GT_OQ), _mm256_cmp_ps(exponent, _mm256_set1_ps(MaxExponent), _CMP_LE_OQ)));
+
+				SumR = _mm256_add_ps(SumR, _mm256_mul_ps(weight, r));
+				SumG = _mm256_add_ps(SumG, _mm256_mul_ps(weight, g));
+				SumB = _mm256_add_ps(SumB, _mm256_mul_ps(weight, b));
+				SumWeight = _mm256_add_ps(SumWeight, weight);
+				SumVariance = _mm256_add_ps(SumVariance, _mm256_mul_ps(_mm256_mul_ps(weight, weight), _mm256_loadu_ps(pass.Variance + j)));
+			}
+		}
+
+		//Misses have no normal and no weight anywhere, they keep their own values
+		const __m256 miss = _mm256_cmp_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(nx, nx), _mm256_mul_ps(ny, ny)), _mm256_mul_ps(nz, nz)), zero, _CMP_EQ_OQ);
+		const __m256 InvWeight = _mm256_div_ps(one, SumWeight);
+		_mm256_storeu_ps(pass.OutR + i, _mm256_blendv_ps(_mm256_mul_ps(SumR, InvWeight), _mm256_loadu_ps(pass.R + i), miss));
+		_mm256_storeu_ps(pass.OutG + i, _mm256_blendv_ps(_mm256_mul_ps(SumG, InvWeight), _mm256_loadu_ps(pass.G + i), miss));
+		_mm256_storeu_ps(pass.OutB + i, _mm256_blendv_ps(_mm256_mul_ps(SumB, InvWeight), _mm256_loadu_ps(pass.B + i), miss));
+		_mm256_storeu_ps(pass.OutVariance + i, _mm256_blendv_ps(_mm256_mul_ps(SumVariance, _mm256_mul_ps(InvWeight, InvWeight)), _mm256_loadu_ps(pass.Variance + i), miss));
+	}
+#endif
+
+//Luminance sigma of every pixel in the row first, from a 3 x 3 Gaussian of the variance, then the pixels whose taps all
+//land inside the row go 8 at a time
+static void FilterRow(const FilterPass& pass, const float& ColorSigma, const int& y, std::vector<float>& InvSigma, const bool& wide)
+{
+	static const float Gaussian[3] = { 0.25f, 0.5f, 0.25f };
+
+	InvSigma.resize(pass.Width);
+	for (int x = 0; x < pass.Width; x++)
+	{
+		float variance = 0.0f;
+		for (int dy = -1; dy <= 1; dy++)
+		{
+			const int qy = std::clamp(y + dy, 0, pass.Height - 1);
+			for (int dx = -1; dx <= 1; dx++)
+				variance += Gaussian[dy + 1] * Gaussian[dx + 1] * pass.Variance[(size_t)qy * pass.Width + std::clamp(x + dx, 0, pass.Width - 1)];
+		}
+
+		InvSigma[x] = 1.0f / (ColorSigma * std::sqrt(std::max(variance, 0.0f)) + GuideEpsilon);
+	}
+
+	const int reach = 2 * pass.Step;
+	int x = 0;
+	for (; x < std::min(reach, pass.Width); x++)
+		FilterPixelScalar(pass, x, y, InvSigma[x]);
+
+#ifdef HALOGEN_X86
+	if (wide)
+	{
+		for (; x + 8 + reach <= pass.Width; x += 8)
+			FilterPixelsAVX2(pass, x, y, &InvSigma[x]);
+	}
+#endif
+
+	for (; x < pass.Width; x++)
+		FilterPixelScalar(pass, x, y, InvSigma[x]);
+}
+
+void Denoiser::SetIterations(const int& iterations)
+{
+	m_Iterations = std::max(iterations, 0);
+}
+
+void Denoiser::SetColorSigma(const float& sigma)
+{
+	m_ColorSigma = std::max(sigma, GuideEpsilon);
+}
+
+void Denoiser::SetNormalSigma(const float& sigma)
+{
+	m_NormalSigma = std::max(sigma, 0.0f);
+}
+
+void Denoiser::SetDepthSigma(const float& sigma)
+{
+	m_DepthSigma = std::max(sigma, GuideEpsilon);
+}
+
+int Denoiser::GetIterations() const
+{
+	return m_Iterations;
+}
+
+const std::vector<glm::vec3>& Denoiser::Denoise(ThreadPool& pool, const DenoiseInput& input)
+{
+	m_Width = input.Width;
+	m_Height = input.Height;
+
+	const size_t count = (size_t)m_Width * m_Height;
+	for (int i = 0; i < 2; i++)
+	{
+		m_R[i].resize(count);
+		m_G[i].resize(count);
+		m_B[i].resize(count);
+		m_Variance[i].resize(count);
+	}
+
+	m_NX.resize(count);
+	m_NY.resize(count);
+	m_NZ.resize(count);
+	m_Depth.resize(count);
+	m_DepthSlope.resize(count);
+	m_Albedo.resize(count);
+	m_Output.resize(count);
+	m_Scratch.resize(pool.GetThreadCount());
+
+	pool.Dispatch(m_Height, [&](const size_t& row, const unsigned int&)
+	{
+		Prepare(input, (int)row);
+	});
+
+	const bool wide = (int)SphereIntersect::GetLevel() >= (int)SIMDLevel::AVX2;
+	int source = 0;
+	for (int iteration = 0; iteration < m_Iterations; iteration++)
+	{
+		FilterPass pass;
+		pass.Width = m_Width;
+		pass.Height = m_Height;
+		pass.Step = 1 << iteration;
+		pass.NormalSigma = m_NormalSigma;
+		pass.DepthSigma = m_DepthSigma;
+		for (int t = 0; t < 25; t++)
+		{
+			const float distance = std::sqrt((float)((t / 5 - 2) * (t / 5 - 2) + (t % 5 - 2) * (t % 5 - 2)));
+			pass.InvDistance[t] = distance > 0.0f ? 1.0f / distance : 0.0f;
+		}
+
+		pass.R = m_R[source].data();
+		pass.G = m_G[source].data();
+		pass.B = m_B[source].data();
+		pass.Variance = m_Variance[source].data();
+		pass.NX = m_NX.data();
+		pass.NY = m_NY.data();
+		pass.NZ = m_NZ.data();
+		pass.Depth = m_Depth.data();
+		pass.DepthSlope = m_DepthSlope.data();
+		pass.OutR = m_R[1 - source].data();
+		pass.OutG = m_G[1 - source].data();
+		pass.OutB = m_B[1 - source].data();
+		pass.OutVariance = m_Variance[1 - source].data();
+
+		pool.Dispatch(m_Height, [&](const size_t& row, const unsigned int& thread)
+		{
+			FilterRow(pass, m_ColorSigma, (int)row, m_Scratch[thread], wide);
+		});
+
+		source = 1 - source;
+	}
+
+	pool.Dispatch(m_Height, [&](const size_t& row, const unsigned int&)
+	{
+		for (size_t i = row * m_Width; i < (row + 1) * m_Width; i++)
+			m_Output[i] = glm::vec3(m_R[source][i], m_G[source][i], m_B[source][i]) * m_Albedo[i];
+	});
+
+	return m_Output;
+}
+
+//Divides the albedo out of the color and its variance and fills in the guide planes for one row
+void Denoiser::Prepare(const DenoiseInput& input, const int& y)
+{
+	for (int x = 0; x < m_Width; x++)
+	{
+		const size_t i = (size_t)y * m_Width + x;
+
+		const glm::vec3 albedo = glm::max(input.Albedo[i], glm::vec3(MinAlbedo));
+		const glm::vec3 illumination = input.Color[i] / albedo;
+		const float AlbedoLuminance = Luminance(albedo.x, albedo.y, albedo.z);
+		m_Albedo[i] = albedo;
+		m_R[0][i] = illumination.x;
+		m_G[0][i] = illumination.y;
+		m_B[0][i] = illumination.z;
+		m_Variance[0][i] = input.Variance[i] / (AlbedoLuminance * AlbedoLuminance);
+
+		const glm::vec3 normal = input.Normal[i];
+		const float length = std::sqrt(glm::dot(normal, normal));
+		const glm::vec3 unit = length > 0.0f ? normal / length : glm::vec3(0.0f);
+		m_NX[i] = unit.x;
+		m_NY[i] = unit.y;
+		m_NZ[i] = unit.z;
+
+		const float depth = input.Depth[i];
+		const size_t left = (size_t)y * m_Width + std::max(x - 1, 0);
+		const size_t right = (size_t)y * m_Width + std::min(x + 1, m_Width - 1);
+		const size_t below = (size_t)std::max(y - 1, 0) * m_Width + x;
+		const size_t above = (size_t)std::min(y + 1, m_Height - 1) * m_Width + x;
+		m_Depth[i] = depth;
+		m_DepthSlope[i] = std::max(std::max(std::abs(input.Depth[left] - depth), std::abs(input.Depth[right] - depth)), std::max(std::abs(input.Depth[below] - depth), std::abs(input.Depth[above] - depth)));
+	}
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <vector>
+
+#include <glm.hpp>
+
+#include "ThreadPool.h"
+
+//Noisy image and guides of one frame, row major. Normals needn't be unit length and are 0 where the camera path missed.
+//Variance is that of the mean luminance of each pixel, not of its samples
+struct DenoiseInput
+{
+	int Width = 0;
+	int Height = 0;
+	const glm::vec3* Color = nullptr;
+	const glm::vec3* Albedo = nullptr;
+	const glm::vec3* Normal = nullptr;
+	const float* Depth = nullptr;
+	const float* Variance = nullptr;
+};
+
+//Edge avoiding a-trous wavelet filter (Dammertz et al. 2010) steered by the variance of each pixel like SVGF
+//(Schied et al. 2017). The albedo is divided out first so textures aren't blurred with the noise, then every iteration
+//filters with a 5 x 5 B3 spline kernel spread twice as wide as the last. Taps fall off with the angle between normals,
+//the depth difference against the local depth slope and the luminance difference against the noise the variance
+//predicts, and the variance is filtered along so later iterations trust the smoother image more. Misses are left as
+//they are. Rows are spread over the pool and run 8 pixels at a time with AVX2 where the SphereIntersect level allows
+class Denoiser
+{
+public:
+	void SetIterations(const int& iterations);
+	void SetColorSigma(const float& sigma);
+	void SetNormalSigma(const float& sigma);
+	void SetDepthSigma(const float& sigma);
+	int GetIterations() const;
+
+	const std::vector<glm::vec3>& Denoise(ThreadPool& pool, const DenoiseInput& input);
+
+private:
+	void Prepare(const DenoiseInput& input, const int& y);
+
+private:
+	int m_Iterations = 5;
+	float m_ColorSigma = 4.0f;
+	float m_NormalSigma = 128.0f;
+	float m_DepthSigma = 1.0f;
+
+	int m_Width = 0;
+	int m_Height = 0;
+
+	//Planes, the illumination and its variance ping pong between iterations
+	std::vector<float> m_R[2];
+	std::vector<float> m_G[2];
+	std::vector<float> m_B[2];
+	std::vector<float> m_Variance[2];
+	std::vector<float> m_NX;
+	std::vector<float> m_NY;
+	std::vector<float> m_NZ;
+	std::vector<float> m_Depth;
+	std::vector<float> m_DepthSlope;											//Largest depth change to a neighbouring pixel
+	std::vector<glm::vec3> m_Albedo;
+	std::vector<std::vector<float>> m_Scratch;										//One row of luminance sigmas per pool thread
+
+	std::vector<glm::vec3> m_Output;
+};
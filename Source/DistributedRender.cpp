@@ -0,0 +1,691 @@
+#include "DistributedRender.h"
+
+#include <print>
+#include <bit>
+#include <cstring>
+#include <algorithm>
+
+#include "CPU Ray Tracer.h"
+#include "TileScheduler.h"
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <spawn.h>
+#include <signal.h>
+#include <sys/wait.h>
+
+extern char** environ;
+#endif
+
+//Messages are a Header and Size bytes of payload, with every field in the hosts' byte order
+static_assert(std::endian::native == std::endian::little, "The render protocol expects little endian hosts");
+
+namespace Protocol
+{
+	const uint32_t Magic = 0x4E474C48;
+	const uint32_t Version = 1;
+	const uint64_t MaxPayload = (uint64_t)1 << 32;								//For the job, the coordinator caps what workers send by what it expects
+
+	enum class MessageType : uint32_t
+	{
+		Hello,																	//Worker to coordinator, Hello
+		Job,																	//JobHeader then the scene file text
+		Tile,																	//TileHeader
+		Result																	//ResultHeader then the tile's planes, see WriteResult
+	};
+
+	struct Header
+	{
+		uint32_t Magic;
+		MessageType Type;
+		uint64_t Size;
+	};
+
+	struct Hello
+	{
+		uint32_t Version;
+		uint32_t Threads;
+	};
+
+	struct JobHeader
+	{
+		int32_t Width;
+		int32_t Height;
+		uint32_t Samples;
+		uint32_t AOVs;
+	};
+
+	struct TileHeader
+	{
+		uint32_t Index;
+		int32_t x;
+		int32_t y;
+		int32_t Width;
+		int32_t Height;
+	};
+
+	struct ResultHeader
+	{
+		TileHeader Tile;
+		uint32_t Samples;														//Passes the tile ran, fewer than the job's where it converged
+		double PathLength;
+	};
+
+	template<typename T>
+	void Append(std::vector<char>& payload, const T* data, const size_t& count)
+	{
+		const size_t offset = payload.size();
+		payload.resize(offset + count * sizeof(T));
+		std::memcpy(payload.data() + offset, data, count * sizeof(T));
+	}
+
+	template<typename T>
+	bool Read(const std::vector<char>& payload, size_t& offset, T* data, const size_t& count)
+	{
+		if (payload.size() - offset < count * sizeof(T))
+			return false;
+
+		std::memcpy(data, payload.data() + offset, count * sizeof(T));
+		offset += count * sizeof(T);
+		return true;
+	}
+
+	bool Send(const Socket& socket, const MessageType& type, const std::vector<char>& payload)
+	{
+		const Header header = { Magic, type, payload.size() };
+		return socket.Send(&header, sizeof(header)) && socket.Send(payload.data(), payload.size());
+	}
+
+	bool Receive(const Socket& socket, MessageType& type, std::vector<char>& payload, const uint64_t& MaxSize = MaxPayload)
+	{
+		Header header;
+		if (!socket.Receive(&header, sizeof(header)) || header.Magic != Magic || header.Size > MaxSize)
+			return false;
+
+		type = header.Type;
+		payload.resize(header.Size);
+		return socket.Receive(payload.data(), payload.size());
+	}
+
+	//Planes of the tile's sums one after the other, color, squared luminance and sample counts, then the AOVs if
+	//the job has them
+	void WriteResult(std::vector<char>& payload, const AccumulationBuffer& tile)
+	{
+		const size_t count = tile.Size();
+		std::vector<glm::vec3> vectors(count);
+		std::vector<float> scalars(count);
+		std::vector<uint32_t> samples(count);
+		std::vector<int32_t> ids(count);
+
+		for (size_t i = 0; i < count; i++)
+			vectors[i] = tile.ColorSum(i);
+		Append(payload, vectors.data(), count);
+
+		for (size_t i = 0; i < count; i++)
+			scalars[i] = tile.LuminanceSquareSum(i);
+		Append(payload, scalars.data(), count);
+
+		for (size_t i = 0; i < count; i++)
+			samples[i] = tile.Samples(i);
+		Append(payload, samples.data(), count);
+
+		if (!tile.HasAOVs())
+			return;
+
+		for (size_t i = 0; i < count; i++)
+			vectors[i] = tile.AlbedoSum(i);
+		Append(payload, vectors.data(), count);
+
+		for (size_t i = 0; i < count; i++)
+			vectors[i] = tile.NormalSum(i);
+		Append(payload, vectors.data(), count);
+
+		for (size_t i = 0; i < count; i++)
+			scalars[i] = tile.DepthSum(i);
+		Append(payload, scalars.data(), count);
+
+		for (size_t i = 0; i < count; i++)
+			ids[i] = tile.MaterialID(i);
+		Append(payload, ids.data(), count);
+
+		for (size_t i = 0; i < count; i++)
+			ids[i] = tile.ObjectID(i);
+		Append(payload, ids.data(), count);
+	}
+
+	//Bytes of a Result message for the tile, ResultHeader included
+	uint64_t ResultSize(const int& Width, const int& Height, const bool& AOVs)
+	{
+		const uint64_t count = (uint64_t)Width * Height;
+		const uint64_t sums = sizeof(glm::vec3) + sizeof(float) + sizeof(uint32_t);
+		const uint64_t AOVSums = AOVs ? 2 * sizeof(glm::vec3) + sizeof(float) + 2 * sizeof(int32_t) : 0;
+		return sizeof(ResultHeader) + count * (sums + AOVSums);
+	}
+
+	//Into the tile's rectangle of image, all or nothing
+	bool ReadResult(const std::vector<char>& payload, size_t offset, const TileHeader& tile, AccumulationBuffer& image)
+	{
+		const size_t count = (size_t)tile.Width * tile.Height;
+		std::vector<glm::vec3> color(count), albedo, normal;
+		std::vector<float> squares(count), depth;
+		std::vector<uint32_t> samples(count);
+		std::vector<int32_t> materials, objects;
+
+		bool complete = Read(payload, offset, color.data(), count) && Read(payload, offset, squares.data(), count) && Read(payload, offset, samples.data(), count);
+		if (image.HasAOVs())
+		{
+			albedo.resize(count);
+			normal.resize(count);
+			depth.resize(count);
+			materials.resize(count);
+			objects.resize(count);
+			complete = complete && Read(payload, offset, albedo.data(), count) && Read(payload, offset, normal.data(), count) && Read(payload, offset, depth.data(), count)
+				&& Read(payload, offset, materials.data(), count) && Read(payload, offset, objects.data(), count);
+		}
+
+		if (!complete || offset != payload.size())
+			return false;
+
+		for (int y = 0; y < tile.Height; y++)
+		{
+			for (int x = 0; x < tile.Width; x++)
+			{
+				const size_t source = (size_t)y * tile.Width + x;
+				const size_t pixel = (size_t)(tile.y + y) * image.GetWidth() + tile.x + x;
+				image.SetSums(pixel, color[source], squares[source], samples[source]);
+				if (image.HasAOVs())
+					image.SetAOVSums(pixel, albedo[source], normal[source], depth[source], materials[source], objects[source]);
+			}
+		}
+
+		return true;
+	}
+}
+
+static const int PollInterval = 100;											//Milliseconds between looks at whether the render is over
+static const double SlowTileFactor = 3.0;										//Times the average tile time before a tile gets a second copy
+static const double HelloTimeout = 10.0;										//Seconds a new connection has to introduce itself
+static const int ReceiveTimeout = 10000;										//Milliseconds a message may stall part way through
+
+RenderCoordinator::RenderCoordinator(const Scene& scene, const DistributedJob& job, const int& TileSize)
+	:m_Scene(scene.Serialize()), m_Job(job), m_TileSize(std::max(TileSize, 1))
+{
+}
+
+RenderCoordinator::~RenderCoordinator()
+{
+	StopLocalWorkers();
+}
+
+//Port 0 takes any free one
+bool RenderCoordinator::Listen(const std::string& address, const uint16_t& port)
+{
+	return m_Listener.Listen(address, port);
+}
+
+uint16_t RenderCoordinator::GetPort() const
+{
+	return m_Listener.GetPort();
+}
+
+//Starts count copies of executable in worker mode, pointed at the port on this machine. Call after Listen
+bool RenderCoordinator::StartLocalWorkers(const std::string& executable, const unsigned int& count, const unsigned int& threads)
+{
+	const std::string address = std::format("127.0.0.1:{}", GetPort());
+	for (unsigned int i = 0; i < count; i++)
+	{
+#ifdef _WIN32
+		std::string command = std::format("\"{}\" --worker {} --threads {}", executable, address, threads);
+		STARTUPINFOA startup = {};
+		startup.cb = sizeof(startup);
+		PROCESS_INFORMATION process = {};
+		if (!CreateProcessA(nullptr, command.data(), nullptr, nullptr, FALSE, 0, nullptr, nullptr, &startup, &process))
+		{
+			std::println("Cannot start worker {}", executable);
+			return false;
+		}
+
+		CloseHandle(process.hThread);
+		m_LocalWorkers.push_back((intptr_t)process.hProcess);
+#else
+		std::vector<std::string> arguments = { executable, "--worker", address, "--threads", std::to_string(threads) };
+		std::vector<char*> argv;
+		for (std::string& argument : arguments)
+			argv.push_back(argument.data());
+
+		argv.push_back(nullptr);
+
+		pid_t process;
+		if (posix_spawnp(&process, executable.c_str(), nullptr, nullptr, argv.data(), environ) != 0)
+		{
+			std::println("Cannot start worker {}", executable);
+			return false;
+		}
+
+		m_LocalWorkers.push_back((intptr_t)process);
+#endif
+	}
+
+	return true;
+}
+
+//Blocks until every tile is in image, false if the local workers all died first
+bool RenderCoordinator::Render(AccumulationBuffer& image)
+{
+	image.SetAOVs(m_Job.AOVs);
+	image.Resize(m_Job.Width, m_Job.Height);
+	m_Image = &image;
+
+	TileScheduler layout(m_TileSize);												//Center first, like the tracers
+	layout.Resize(m_Job.Width, m_Job.Height);
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		for (const Tile& tile : layout.GetTiles())
+		{
+			TileState state;
+			state.x = tile.x;
+			state.y = tile.y;
+			state.Width = tile.Width;
+			state.Height = tile.Height;
+			m_Queue.push_back(m_Tiles.size());
+			m_Tiles.push_back(state);
+		}
+
+		m_Remaining = m_Tiles.size();
+		m_Finished = m_Remaining == 0;
+	}
+
+	if (m_LocalWorkers.empty())
+		std::println("Waiting for workers on port {}", GetPort());
+
+	m_AcceptThread = std::thread(&RenderCoordinator::AcceptWorkers, this);
+
+	bool success = true;
+	size_t reported = 0;
+	{
+		std::unique_lock<std::mutex> lock(m_Mutex);
+		while (!m_Finished)
+		{
+			m_Changed.wait_for(lock, std::chrono::milliseconds(PollInterval));
+
+			const size_t tenths = 10 * (m_Tiles.size() - m_Remaining) / m_Tiles.size();
+			if (tenths > reported && tenths < 10)
+			{
+				reported = tenths;
+				std::println("{}% of the tiles in", 10 * reported);
+			}
+
+			//Remote workers may still turn up, but not when every one of ours has died with nobody else connected
+			bool LocalAlive = m_LocalWorkers.empty();
+			for (intptr_t& worker : m_LocalWorkers)
+			{
+#ifdef _WIN32
+				if (worker != -1 && WaitForSingleObject((HANDLE)worker, 0) == WAIT_OBJECT_0)
+				{
+					CloseHandle((HANDLE)worker);
+					worker = -1;
+				}
+#else
+				if (worker != -1 && waitpid((pid_t)worker, nullptr, WNOHANG) == (pid_t)worker)
+					worker = -1;
+#endif
+				LocalAlive |= worker != -1;
+			}
+
+			if (!LocalAlive && m_LiveWorkers == 0)
+			{
+				std::println("Every worker is gone with {} of {} tiles left", m_Remaining, m_Tiles.size());
+				success = false;
+				m_Finished = true;
+			}
+		}
+	}
+
+	m_Changed.notify_all();
+	m_AcceptThread.join();
+	for (std::unique_ptr<Connection>& connection : m_Connections)
+		connection->Thread.join();
+
+	StopLocalWorkers();
+	m_Image = nullptr;
+	return success;
+}
+
+size_t RenderCoordinator::TileCount() const
+{
+	return m_Tiles.size();
+}
+
+//Connections that joined the render, not the ones dropped at hello
+size_t RenderCoordinator::WorkerCount() const
+{
+	return std::count_if(m_Connections.begin(), m_Connections.end(), [](const std::unique_ptr<Connection>& connection) { return connection->Joined; });
+}
+
+//Tiles put back in the queue after their worker dropped
+size_t RenderCoordinator::ReassignedTiles() const
+{
+	return m_Reassigned;
+}
+
+//Second copies handed out for slow tiles
+size_t RenderCoordinator::DuplicateTiles() const
+{
+	return m_Duplicates;
+}
+
+//Passes of the tile that took the most, what RenderedSamples gives for the image traced in one piece
+unsigned int RenderCoordinator::RenderedSamples() const
+{
+	return m_RenderedSamples;
+}
+
+double RenderCoordinator::AveragePathLength() const
+{
+	return m_PathSamples > 0.0 ? m_PathLengthSum / m_PathSamples : 0.0;
+}
+
+void RenderCoordinator::AcceptWorkers()
+{
+	while (true)
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_Mutex);
+			if (m_Finished)
+				return;
+		}
+
+		if (!m_Listener.WaitReadable(PollInterval))
+			continue;
+
+		Socket link = m_Listener.Accept();
+		if (!link.Valid())
+			continue;
+
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		if (m_Finished)
+			return;
+
+		m_Connections.push_back(std::make_unique<Connection>());
+		Connection& connection = *m_Connections.back();
+		connection.Link = std::move(link);
+		connection.Link.SetReceiveTimeout(ReceiveTimeout);
+		connection.Name = connection.Link.GetPeerName();
+		connection.Thread = std::thread(&RenderCoordinator::Serve, this, std::ref(connection));
+		m_LiveWorkers++;
+	}
+}
+
+void RenderCoordinator::Serve(Connection& connection)
+{
+	Protocol::MessageType type;
+	std::vector<char> payload;
+	size_t offset = 0;
+	Protocol::Hello hello = {};
+	const bool greeted = WaitForMessage(connection, HelloTimeout);
+	bool alive = greeted && Protocol::Receive(connection.Link, type, payload, sizeof(Protocol::Hello)) && type == Protocol::MessageType::Hello && Protocol::Read(payload, offset, &hello, 1)
+		&& hello.Version == Protocol::Version;
+
+	if (alive)
+	{
+		std::println("Worker {} joined with {} threads", connection.Name, hello.Threads);
+		connection.Joined = true;
+
+		const Protocol::JobHeader job = { m_Job.Width, m_Job.Height, m_Job.Samples, m_Job.AOVs };
+		payload.clear();
+		Protocol::Append(payload, &job, 1);
+		Protocol::Append(payload, m_Scene.data(), m_Scene.size());
+		alive = Protocol::Send(connection.Link, Protocol::MessageType::Job, payload);
+	}
+
+	else if (greeted)
+		std::println("Dropped {}, it doesn't speak this version of the render protocol", connection.Name);
+
+	else
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		if (!m_Finished)
+			std::println("Dropped {}, it didn't say hello within {} s", connection.Name, HelloTimeout);
+	}
+
+	while (alive)
+	{
+		size_t index;
+		{
+			std::unique_lock<std::mutex> lock(m_Mutex);
+			while (!m_Finished && !NextTile(index))
+				m_Changed.wait_for(lock, std::chrono::milliseconds(PollInterval));
+
+			if (m_Finished)
+				break;
+		}
+
+		const TileState& tile = m_Tiles[index];
+		const Protocol::TileHeader header = { (uint32_t)index, tile.x, tile.y, tile.Width, tile.Height };
+		const uint64_t expected = Protocol::ResultSize(tile.Width, tile.Height, m_Job.AOVs);
+		const auto start = std::chrono::steady_clock::now();
+		payload.clear();
+		Protocol::Append(payload, &header, 1);
+		alive = Protocol::Send(connection.Link, Protocol::MessageType::Tile, payload);
+
+		//Polled so a worker still busy with a tile someone else already returned can be left behind
+		alive = alive && WaitForMessage(connection, 0.0) && Protocol::Receive(connection.Link, type, payload, expected) && type == Protocol::MessageType::Result;
+
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		m_Tiles[index].InFlight--;
+		if (alive)
+		{
+			const bool first = !m_Tiles[index].Done;
+			alive = StoreResult(index, payload);
+			if (alive && first)
+			{
+				m_TileSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+				connection.Tiles++;
+			}
+		}
+
+		if (!alive && !m_Finished)
+		{
+			std::println("Lost worker {} after {} tiles", connection.Name, connection.Tiles);
+			if (!m_Tiles[index].Done && m_Tiles[index].InFlight == 0)
+			{
+				m_Queue.push_front(index);
+				m_Reassigned++;
+			}
+		}
+
+		m_Changed.notify_all();
+	}
+
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	connection.Link.Close();
+	m_LiveWorkers--;
+	m_Changed.notify_all();
+}
+
+//Polls until the connection has a message in, false once the render is over or the timeout in seconds is up, 0 waits
+//as long as the render goes on
+bool RenderCoordinator::WaitForMessage(const Connection& connection, const double& timeout)
+{
+	const auto start = std::chrono::steady_clock::now();
+	while (!connection.Link.WaitReadable(PollInterval))
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_Mutex);
+			if (m_Finished)
+				return false;
+		}
+
+		if (timeout > 0.0 && std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() >= timeout)
+			return false;
+	}
+
+	return true;
+}
+
+//Called with m_Mutex held. Queued tiles first, then a second copy of the tile out longest, once it's well past the
+//average time and nobody else has taken one
+bool RenderCoordinator::NextTile(size_t& tile)
+{
+	const auto now = std::chrono::steady_clock::now();
+	if (!m_Queue.empty())
+	{
+		tile = m_Queue.front();
+		m_Queue.pop_front();
+		m_Tiles[tile].InFlight++;
+		m_Tiles[tile].Started = now;
+		return true;
+	}
+
+	const size_t done = m_Tiles.size() - m_Remaining;
+	if (done == 0)
+		return false;
+
+	const double SlowTime = SlowTileFactor * m_TileSeconds / (double)done;
+	bool found = false;
+	for (size_t i = 0; i < m_Tiles.size(); i++)
+	{
+		const TileState& state = m_Tiles[i];
+		if (state.Done || state.InFlight != 1 || std::chrono::duration<double>(now - state.Started).count() < SlowTime)
+			continue;
+
+		if (!found || state.Started < m_Tiles[tile].Started)
+			tile = i;
+
+		found = true;
+	}
+
+	if (!found)
+		return false;
+
+	m_Tiles[tile].InFlight++;
+	m_Duplicates++;
+	return true;
+}
+
+//Called with m_Mutex held. False if the result is malformed, a copy of a tile already in is checked and dropped
+bool RenderCoordinator::StoreResult(const size_t& tile, const std::vector<char>& payload)
+{
+	const TileState& state = m_Tiles[tile];
+	Protocol::ResultHeader header;
+	size_t offset = 0;
+	if (!Protocol::Read(payload, offset, &header, 1) || header.Tile.Index != tile || header.Tile.x != state.x || header.Tile.y != state.y
+		|| header.Tile.Width != state.Width || header.Tile.Height != state.Height)
+		return false;
+
+	if (state.Done)
+		return true;
+
+	if (!Protocol::ReadResult(payload, offset, header.Tile, *m_Image))
+		return false;
+
+	double samples = 0.0;
+	for (int y = state.y; y < state.y + state.Height; y++)
+	{
+		for (int x = state.x; x < state.x + state.Width; x++)
+			samples += m_Image->Samples((size_t)y * m_Job.Width + x);
+	}
+
+	m_PathLengthSum += header.PathLength * samples;
+	m_PathSamples += samples;
+	m_RenderedSamples = std::max(m_RenderedSamples, header.Samples);
+
+	m_Tiles[tile].Done = true;
+	m_Remaining--;
+	m_Finished = m_Remaining == 0;
+	return true;
+}
+
+void RenderCoordinator::StopLocalWorkers()
+{
+	for (const intptr_t& worker : m_LocalWorkers)
+	{
+		if (worker == -1)
+			continue;
+
+#ifdef _WIN32
+		TerminateProcess((HANDLE)worker, 0);
+		WaitForSingleObject((HANDLE)worker, INFINITE);
+		CloseHandle((HANDLE)worker);
+#else
+		kill((pid_t)worker, SIGKILL);												//Also ends stopped ones, SIGTERM would wait for them to resume
+		waitpid((pid_t)worker, nullptr, 0);
+#endif
+	}
+
+	m_LocalWorkers.clear();
+}
+
+RenderWorker::RenderWorker(const unsigned int& threads)
+	:m_Threads(threads)
+{
+}
+
+//True once the coordinator hangs up, which is how it says the image is done
+bool RenderWorker::Run(const std::string& host, const uint16_t& port)
+{
+	Socket link;
+	if (!link.Connect(host, port))
+		return false;
+
+	std::unique_ptr<CpuRayTracer> tracer;
+	Protocol::JobHeader job = {};
+	std::vector<char> payload;
+
+	const Protocol::Hello hello = { Protocol::Version, m_Threads > 0 ? m_Threads : std::max(std::thread::hardware_concurrency(), 1u) };
+	Protocol::Append(payload, &hello, 1);
+	if (!Protocol::Send(link, Protocol::MessageType::Hello, payload))
+		return false;
+
+	while (true)
+	{
+		Protocol::MessageType type;
+		if (!Protocol::Receive(link, type, payload))
+			return true;
+
+		size_t offset = 0;
+		if (type == Protocol::MessageType::Job)
+		{
+			if (!Protocol::Read(payload, offset, &job, 1))
+				return false;
+
+			Scene scene;
+			if (!scene.Deserialize(std::string(payload.data() + offset, payload.size() - offset), std::format("scene from {}:{}", host, port)))
+				return false;
+
+			//Tiles stop at the sample count or where they converge, a time limit would mean something else per tile
+			tracer = std::make_unique<CpuRayTracer>(1, 1, m_Threads);
+			tracer->LoadScene(scene);
+			tracer->SetTimeLimit(0.0f);
+			tracer->SetDenoise(false);
+			tracer->SetAOVs(job.AOVs != 0);
+		}
+
+		else if (type == Protocol::MessageType::Tile && tracer != nullptr)
+		{
+			Protocol::ResultHeader result = {};
+			if (!Protocol::Read(payload, offset, &result.Tile, 1))
+				return false;
+
+			tracer->SetCropWindow(job.Width, job.Height, result.Tile.x, result.Tile.y, result.Tile.Width, result.Tile.Height);
+			while ((int)tracer->RenderedSamples() < (int)job.Samples && !tracer->Finished())
+				tracer->Accumulate();
+
+			result.Samples = tracer->RenderedSamples();
+			result.PathLength = tracer->AveragePathLength();
+			payload.clear();
+			Protocol::Append(payload, &result, 1);
+			Protocol::WriteResult(payload, tracer->GetAccumulation());
+			if (!Protocol::Send(link, Protocol::MessageType::Result, payload))
+				return true;
+		}
+
+		else
+		{
+			std::println("Unexpected message from the coordinator");
+			return false;
+		}
+	}
+}
@@ -0,0 +1,112 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <chrono>
+#include <memory>
+#include <cstdint>
+
+#include "Scene.h"
+#include "Socket.h"
+#include "AccumulationBuffer.h"
+
+//The image every worker renders tiles of
+struct DistributedJob
+{
+	int Width = 0;
+	int Height = 0;
+	uint32_t Samples = 0;
+	bool AOVs = false;															//Send the AOV sums back too, for denoising the assembled image
+};
+
+//Splits an image into tiles and hands them to worker processes over TCP, local ones it starts itself or remote ones
+//started with halogen-render --worker. Every worker gets the serialized scene once and then a tile at a time, and
+//sends back the tile's accumulation sums. A dropped worker's tile goes back in the queue, and once the queue runs dry
+//idle workers take a second copy of tiles that are slow to come back, whichever copy lands first is kept
+class RenderCoordinator
+{
+public:
+	RenderCoordinator(const Scene& scene, const DistributedJob& job, const int& TileSize);
+	~RenderCoordinator();
+
+	bool Listen(const std::string& address, const uint16_t& port);
+	uint16_t GetPort() const;
+	bool StartLocalWorkers(const std::string& executable, const unsigned int& count, const unsigned int& threads);
+	bool Render(AccumulationBuffer& image);
+
+	size_t TileCount() const;
+	size_t WorkerCount() const;
+	size_t ReassignedTiles() const;
+	size_t DuplicateTiles() const;
+	unsigned int RenderedSamples() const;
+	double AveragePathLength() const;
+
+private:
+	struct TileState
+	{
+		int x = 0;
+		int y = 0;
+		int Width = 0;
+		int Height = 0;
+		bool Done = false;
+		unsigned int InFlight = 0;												//Copies out with workers
+		std::chrono::steady_clock::time_point Started;
+	};
+
+	struct Connection
+	{
+		Socket Link;
+		std::string Name;
+		std::thread Thread;
+		bool Joined = false;													//Said hello with our protocol version
+		size_t Tiles = 0;
+	};
+
+	void AcceptWorkers();
+	void Serve(Connection& connection);
+	bool WaitForMessage(const Connection& connection, const double& timeout);
+	bool NextTile(size_t& tile);
+	bool StoreResult(const size_t& tile, const std::vector<char>& payload);
+	void StopLocalWorkers();
+
+private:
+	std::string m_Scene;
+	DistributedJob m_Job;
+	int m_TileSize;
+	AccumulationBuffer* m_Image = nullptr;
+
+	Socket m_Listener;
+	std::thread m_AcceptThread;
+	std::vector<std::unique_ptr<Connection>> m_Connections;
+	std::vector<intptr_t> m_LocalWorkers;										//Process ids, or handles on Windows
+
+	std::mutex m_Mutex;
+	std::condition_variable m_Changed;
+	std::vector<TileState> m_Tiles;
+	std::deque<size_t> m_Queue;
+	size_t m_Remaining = 0;
+	bool m_Finished = false;
+	size_t m_LiveWorkers = 0;
+	size_t m_Reassigned = 0;
+	size_t m_Duplicates = 0;
+	double m_TileSeconds = 0.0;													//Summed over the tiles done, for spotting slow ones
+	double m_PathLengthSum = 0.0;												//Weighted by the samples behind each tile
+	double m_PathSamples = 0.0;
+	uint32_t m_RenderedSamples = 0;
+};
+
+//Connects to a coordinator and renders the tiles it sends on the CPU until it hangs up
+class RenderWorker
+{
+public:
+	RenderWorker(const unsigned int& threads = 0);
+
+	bool Run(const std::string& host, const uint16_t& port);
+
+private:
+	unsigned int m_Threads;
+};
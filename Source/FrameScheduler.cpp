@@ -0,0 +1,77 @@
+#include "FrameScheduler.h"
+
+void FrameScheduler::SetBudget(const float& milliseconds)
+{
+	m_Budget = std::max(milliseconds, 1.0f);
+}
+
+float FrameScheduler::GetBudget() const
+{
+	return m_Budget;
+}
+
+void FrameScheduler::BeginFrame()
+{
+	m_FrameStart = std::chrono::steady_clock::now();
+	m_TracedTime = 0.0;
+
+	if (m_Started)
+		return;
+
+	m_WindowStart = m_FrameStart;
+	m_Started = true;
+}
+
+//Samples that fit the budget next to the rest of the frame, at least one so that the image still converges when a
+//single sample takes longer than the budget. Before the first sample is measured there's only the one
+int FrameScheduler::FrameSamples(const double& SampleTime) const
+{
+	if (SampleTime <= 0.0)
+		return 1;
+
+	const double fit = ((double)m_Budget - m_UITime) / SampleTime;
+	return (int)std::clamp(fit, 1.0, (double)MaxFrameSamples);
+}
+
+void FrameScheduler::AddSamples(const int& samples, const double& SampleTime)
+{
+	m_TracedTime += samples * SampleTime;
+	m_WindowSamples += samples;
+}
+
+//The UI time carries whatever the sample time misses, driver overhead or a stale estimate, so the samples of the
+//next frames shrink until the frames come back to the budget
+void FrameScheduler::EndFrame()
+{
+	const auto now = std::chrono::steady_clock::now();
+	const double FrameTime = std::chrono::duration<double, std::milli>(now - m_FrameStart).count();
+	const double UITime = std::max(FrameTime - m_TracedTime, 0.0);
+
+	m_FrameTime = m_FrameTime > 0.0 ? 0.9 * m_FrameTime + 0.1 * FrameTime : FrameTime;
+	m_UITime = m_UITime > 0.0 ? 0.9 * m_UITime + 0.1 * UITime : UITime;
+
+	const double elapsed = std::chrono::duration<double>(now - m_WindowStart).count();
+	if (elapsed < 0.5)
+		return;
+
+	m_SamplesPerSecond = (float)(m_WindowSamples / elapsed);
+	m_WindowSamples = 0;
+	m_WindowStart = now;
+}
+
+//Samples per pixel, over the last half second or so, idle time included
+float FrameScheduler::SamplesPerSecond() const
+{
+	return m_SamplesPerSecond;
+}
+
+//What a frame takes from the input it reads to its swap, the time it waits on events before that left out
+float FrameScheduler::FrameTime() const
+{
+	return (float)m_FrameTime;
+}
+
+float FrameScheduler::UITime() const
+{
+	return (float)m_UITime;
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <chrono>
+#include <algorithm>
+
+const int MaxFrameSamples = 4096;
+
+//Decides how many samples the main loop traces in a frame so that the frame, UI included, takes about the budget,
+//whatever the refresh rate. The samples are costed at the GPU time RayTracer::SampleTime measured and the rest of the
+//frame at what the clock shows beyond them, so heavy scenes trace fewer samples a frame and light ones fill the
+//budget. Frames are timed from BeginFrame to EndFrame, the main loop waits on events outside of them while there is
+//nothing to trace
+class FrameScheduler
+{
+public:
+	void SetBudget(const float& milliseconds);
+	float GetBudget() const;
+
+	void BeginFrame();
+	int FrameSamples(const double& SampleTime) const;
+	void AddSamples(const int& samples, const double& SampleTime);
+	void EndFrame();
+
+	float SamplesPerSecond() const;
+	float FrameTime() const;
+	float UITime() const;
+
+private:
+	float m_Budget = 1000.0f / 60.0f;											//Milliseconds
+
+	std::chrono::steady_clock::time_point m_FrameStart;
+	double m_TracedTime = 0.0;													//Milliseconds of GPU time traced this frame
+	double m_FrameTime = 0.0;													//Averages over the last frames, in milliseconds
+	double m_UITime = 0.0;
+
+	std::chrono::steady_clock::time_point m_WindowStart;
+	int m_WindowSamples = 0;
+	float m_SamplesPerSecond = 0.0f;
+	bool m_Started = false;
+};
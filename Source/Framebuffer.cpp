@@ -1,5 +1,8 @@
 #include "Framebuffer.h"
 
+#include <algorithm>
+#include <cmath>
+
 FrameBufferTexture::FrameBufferTexture()
 {
 	glGenTextures(1, &m_RendererID);
@@ -30,8 +33,8 @@ FrameBufferTexture::~FrameBufferTexture()
 	glDeleteTextures(1, &m_RendererID);
 }
 
-Framebuffer::Framebuffer()
-	:m_Width(0), m_Height(0)
+Framebuffer::Framebuffer(const int& Attachments)
+	:m_Width(0), m_Height(0), m_Attachments(std::clamp(Attachments, 1, MaxAttachments))
 {
 	glGenFramebuffers(1, &m_RendererID);
 }
@@ -40,15 +43,8 @@ Framebuffer::Framebuffer(const int& Width, const int& Height)
 	:m_Width(Width), m_Height(Height)
 {
 	glGenFramebuffers(1, &m_RendererID);
-	m_Texture.GenerateTexture(m_Width, m_Height);
-
-	Bind();
-	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, m_Texture.m_RendererID, 0);
-
-	if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
-		std::println("Framebuffer incomplete");
-
-	UnBind();
+	m_Textures[0].GenerateTexture(m_Width, m_Height);
+	Attach();
 }
 
 void Framebuffer::ReSize(const int& Width, const int& Height)
@@ -56,10 +52,32 @@ void Framebuffer::ReSize(const int& Width, const int& Height)
 	m_Width = Width;
 	m_Height = Height;
 
-	m_Texture.GenerateTexture(m_Width, m_Height);
+	for (int i = 0; i < m_Attachments; i++)
+		m_Textures[i].GenerateTexture(m_Width, m_Height);
+
+	Attach();
+}
+
+//Textures past the new count are kept but no longer drawn to
+void Framebuffer::SetAttachments(const int& Attachments)
+{
+	m_Attachments = std::clamp(Attachments, 1, MaxAttachments);
+	if (m_Width > 0 && m_Height > 0)
+		ReSize(m_Width, m_Height);
+}
+
+void Framebuffer::Attach() const
+{
+	unsigned int DrawBuffers[MaxAttachments];
 
 	Bind();
-	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, m_Texture.m_RendererID, 0);
+	for (int i = 0; i < m_Attachments; i++)
+	{
+		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0 + i, GL_TEXTURE_2D, m_Textures[i].m_RendererID, 0);
+		DrawBuffers[i] = GL_COLOR_ATTACHMENT0 + i;
+	}
+
+	glDrawBuffers(m_Attachments, DrawBuffers);
 
 	if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
 		std::println("Framebuffer incomplete");
@@ -70,7 +88,12 @@ void Framebuffer::ReSize(const int& Width, const int& Height)
 void Framebuffer::Bind(const int& slot) const
 {
 	glBindFramebuffer(GL_FRAMEBUFFER, m_RendererID);
-	m_Texture.Bind(slot);
+	m_Textures[0].Bind(slot);
+}
+
+void Framebuffer::BindAttachment(const int& attachment, const int& slot) const
+{
+	m_Textures[attachment].Bind(slot);
 }
 
 void Framebuffer::UnBind() const
@@ -78,6 +101,51 @@ void Framebuffer::UnBind() const
 	glBindFramebuffer(GL_FRAMEBUFFER, 0);
 }
 
+//Lets shaders texelFetch the lower levels, until the next ReSize replaces the base level
+void Framebuffer::GenerateMipmaps(const int& attachment, const int& slot) const
+{
+	m_Textures[attachment].Bind(slot);
+	glGenerateMipmap(GL_TEXTURE_2D);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_NEAREST);
+}
+
+//Mean over the image, read off the top of a freshly generated mip chain rather than copying every pixel back.
+//Levels of odd sizes are filtered by the driver, so it is close to the exact mean rather than equal to it.
+//The texture is left bound to slot, pass the one it is normally sampled from
+glm::vec4 Framebuffer::Average(const int& slot, const int& attachment) const
+{
+	glm::vec4 average = glm::vec4(0.0f);
+	const int TopLevel = (int)std::log2((float)std::max(std::max(m_Width, m_Height), 1));
+
+	m_Textures[attachment].Bind(slot);
+	glGenerateMipmap(GL_TEXTURE_2D);
+	glGetTexImage(GL_TEXTURE_2D, TopLevel, GL_RGBA, GL_FLOAT, &average.x);
+	return average;
+}
+
+//Every pixel of the attachment, rows bottom up. The texture is left bound to slot like Average leaves it
+std::vector<glm::vec4> Framebuffer::Read(const int& attachment, const int& slot) const
+{
+	std::vector<glm::vec4> pixels((size_t)m_Width * m_Height);
+
+	m_Textures[attachment].Bind(slot);
+	glGetTexImage(GL_TEXTURE_2D, 0, GL_RGBA, GL_FLOAT, pixels.data());
+	return pixels;
+}
+
+//Replaces every pixel of the attachment, in the layout Read returns them
+void Framebuffer::Write(const int& attachment, const int& slot, const std::vector<glm::vec4>& pixels) const
+{
+	if (pixels.size() != (size_t)m_Width * m_Height)
+	{
+		std::println("Attempting to write {} pixels to a {}x{} framebuffer", pixels.size(), m_Width, m_Height);
+		return;
+	}
+
+	m_Textures[attachment].Bind(slot);
+	glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, m_Width, m_Height, GL_RGBA, GL_FLOAT, pixels.data());
+}
+
 Framebuffer::~Framebuffer()
 {
 	glDeleteFramebuffers(1, &m_RendererID);
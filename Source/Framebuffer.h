@@ -2,6 +2,9 @@
 #include <GL/glew.h>
 #include <utility>
 #include <print>
+#include <vector>
+
+#include <glm.hpp>
 
 class FrameBufferTexture
 {
@@ -17,20 +20,33 @@ public:
 	unsigned int m_RendererID;
 };
 
+const int MaxAttachments = 5;
+
+//Draws to every attachment at once, a fragment shader writes attachment i through layout(location = i)
 class Framebuffer
 {
 public:
-	Framebuffer();
+	Framebuffer(const int& Attachments = 1);
 	Framebuffer(const int& Width, const int& Height);
 	~Framebuffer();
 
 	void ReSize(const int& Width, const int& Height);
+	void SetAttachments(const int& Attachments);
 	void Bind(const int& slot = 0) const;
+	void BindAttachment(const int& attachment, const int& slot) const;
 	void UnBind() const;
+	void GenerateMipmaps(const int& attachment, const int& slot) const;
+	glm::vec4 Average(const int& slot = 0, const int& attachment = 0) const;
+	std::vector<glm::vec4> Read(const int& attachment, const int& slot) const;
+	void Write(const int& attachment, const int& slot, const std::vector<glm::vec4>& pixels) const;
+
+private:
+	void Attach() const;
 
 private:
 	unsigned int m_RendererID;
 	int m_Width;
 	int m_Height;
-	FrameBufferTexture m_Texture;
+	int m_Attachments = 1;
+	FrameBufferTexture m_Textures[MaxAttachments];
 };
\ No newline at end of file
@@ -0,0 +1,425 @@
+#include <string>
+#include <vector>
+#include <chrono>
+#include <print>
+#include <thread>
+#include <filesystem>
+
+#include "Scene.h"
+#include "CPU Ray Tracer.h"
+#include "DistributedRender.h"
+#include "stb_image_write.h"
+
+#ifdef HALOGEN_EGL
+#include "HeadlessContext.h"
+#include "Ray Tracer.h"
+#endif
+
+//Renders a scene without a window or ImGui, for headless machines and scripts. The OpenGL tracer runs on a surfaceless
+//EGL context where the build has one, the CPU tracer everywhere. Shaders are read from res/ under the working
+//directory like the application does. Images can also be split into tiles across worker processes, see
+//DistributedRender.h, these run the CPU tracer
+struct RenderOptions
+{
+	std::string ScenePath;
+	std::string OutputPath = "render.png";
+	int Width = 1920;
+	int Height = 1080;
+	int Samples = 0;
+	float Seconds = 0.0f;
+	bool CPU = false;
+	unsigned int Threads = 0;
+	bool Denoise = false;
+
+	unsigned int LocalWorkers = 0;
+	bool Listen = false;
+	std::string ListenAddress = "127.0.0.1";
+	uint16_t ListenPort = 0;
+	bool Worker = false;
+	std::string CoordinatorHost;
+	uint16_t CoordinatorPort = 0;
+	int TileSize = 128;
+};
+
+struct RenderResult
+{
+	unsigned int Samples = 0;
+	uint64_t PixelSamples = 0;													//Summed over the pixels, converged tiles took fewer
+	double Seconds = 0.0;
+	double PathLength = 0.0;
+	std::string Device;
+	std::vector<unsigned char> Image;											//Tone mapped, rows bottom up
+	std::vector<glm::vec3> Radiance;											//Mean of the samples, rows bottom up
+};
+
+static const int DefaultSamples = 64;
+static const float OfflinePassTime = 100.0f;									//Milliseconds, there's no UI to keep responsive
+
+static void PrintUsage(const char* program)
+{
+	std::println("Usage: {} <scene.hgns> [options]", program);
+	std::println("  -o, --output <file>       png, jpg, bmp, tga, or hdr for the linear radiance (default render.png)");
+	std::println("  -r, --resolution <WxH>    (default 1920x1080)");
+	std::println("  -s, --samples <count>     samples per pixel (default {} unless --time is given)", DefaultSamples);
+	std::println("  -t, --time <seconds>      stop after this long, with --samples whichever comes first");
+	std::println("      --cpu                 trace on the CPU instead of OpenGL");
+	std::println("      --threads <count>     CPU threads (default all)");
+	std::println("      --denoise             filter the image before writing it, scenes saved with it on always are");
+	std::println("Distributed rendering, on the CPU and by sample count:");
+	std::println("      --local-workers <n>   split the image across n worker processes on this machine");
+	std::println("      --listen [addr:]port  take workers from other machines too, on every address unless one is given");
+	std::println("      --tile <size>         tile edge in pixels handed to a worker at a time (default 128)");
+	std::println("Usage: {} --worker <host:port> [--threads <count>]", program);
+	std::println("  renders tiles for the coordinator at host:port until it's done");
+}
+
+//host:port, or just a port with the host left as it was
+static bool ParseAddress(const std::string& text, std::string& host, uint16_t& port)
+{
+	const size_t colon = text.rfind(':');
+	if (colon != std::string::npos)
+		host = text.substr(0, colon);
+
+	const int value = std::stoi(text.substr(colon == std::string::npos ? 0 : colon + 1));
+	if (value < 0 || value > 65535 || host.empty())
+		return false;
+
+	port = (uint16_t)value;
+	return true;
+}
+
+static bool ParseArguments(const int& argc, char** argv, RenderOptions& options)
+{
+	for (int i = 1; i < argc; i++)
+	{
+		const std::string argument = argv[i];
+		const bool HasValue = i + 1 < argc;
+
+		try
+		{
+			if ((argument == "-o" || argument == "--output") && HasValue)
+				options.OutputPath = argv[++i];
+
+			else if ((argument == "-r" || argument == "--resolution") && HasValue)
+			{
+				const std::string resolution = argv[++i];
+				const size_t x = resolution.find('x');
+				if (x == std::string::npos)
+				{
+					std::println("Resolution {} is not of the form WxH", resolution);
+					return false;
+				}
+
+				options.Width = std::stoi(resolution.substr(0, x));
+				options.Height = std::stoi(resolution.substr(x + 1));
+			}
+
+			else if ((argument == "-s" || argument == "--samples") && HasValue)
+				options.Samples = std::stoi(argv[++i]);
+
+			else if ((argument == "-t" || argument == "--time") && HasValue)
+				options.Seconds = std::stof(argv[++i]);
+
+			else if (argument == "--cpu")
+				options.CPU = true;
+
+			else if (argument == "--threads" && HasValue)
+				options.Threads = (unsigned int)std::stoul(argv[++i]);
+
+			else if (argument == "--denoise")
+				options.Denoise = true;
+
+			else if (argument == "--local-workers" && HasValue)
+				options.LocalWorkers = (unsigned int)std::stoul(argv[++i]);
+
+			else if (argument == "--listen" && HasValue)
+			{
+				options.Listen = true;
+				options.ListenAddress = "0.0.0.0";
+				if (!ParseAddress(argv[++i], options.ListenAddress, options.ListenPort))
+				{
+					std::println("Cannot listen on {}", argv[i]);
+					return false;
+				}
+			}
+
+			else if (argument == "--worker" && HasValue)
+			{
+				options.Worker = true;
+				if (!ParseAddress(argv[++i], options.CoordinatorHost, options.CoordinatorPort))
+				{
+					std::println("Coordinator {} is not of the form host:port", argv[i]);
+					return false;
+				}
+			}
+
+			else if (argument == "--tile" && HasValue)
+				options.TileSize = std::stoi(argv[++i]);
+
+			else if (argument[0] != '-' && options.ScenePath.empty())
+				options.ScenePath = argument;
+
+			else
+			{
+				std::println("Unknown argument {}", argument);
+				return false;
+			}
+		}
+
+		catch (const std::exception&)
+		{
+			std::println("Invalid value for {}", argument);
+			return false;
+		}
+	}
+
+	if (options.Worker)
+		return true;
+
+	if (options.ScenePath.empty() || options.Width < 1 || options.Height < 1 || options.Samples < 0 || options.Seconds < 0.0f || options.TileSize < 1)
+		return false;
+
+	if (options.Samples == 0 && options.Seconds == 0.0f)
+		options.Samples = DefaultSamples;
+
+	if ((options.LocalWorkers > 0 || options.Listen) && options.Seconds > 0.0f)
+	{
+		std::println("Distributed renders go by sample count, --time can't be split across workers");
+		return false;
+	}
+
+	return true;
+}
+
+static uint64_t SampleSum(const AccumulationBuffer& accumulation)
+{
+	uint64_t samples = 0;
+	for (size_t i = 0; i < accumulation.Size(); i++)
+		samples += accumulation.Samples(i);
+
+	return samples;
+}
+
+static RenderResult RenderCPU(const RenderOptions& options, const Scene& scene)
+{
+	const bool denoise = options.Denoise || scene.m_Denoise;
+	CpuRayTracer tracer(options.Width, options.Height, options.Threads);
+	tracer.LoadScene(scene);
+	tracer.SetDenoise(denoise);
+	if (options.Seconds > 0.0f)
+		tracer.SetTimeLimit(options.Seconds);
+
+	const auto start = std::chrono::steady_clock::now();
+	while ((options.Samples == 0 || (int)tracer.RenderedSamples() < options.Samples) && !tracer.Finished())
+		tracer.Accumulate();
+
+	if (denoise)
+		tracer.Denoise();
+
+	RenderResult result;
+	result.Seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	result.Samples = tracer.RenderedSamples();
+	result.PathLength = tracer.AveragePathLength();
+	result.Device = std::format("CPU, {} threads", tracer.GetThreadCount());
+
+	unsigned char* image = tracer.GetRenderedImage();
+	result.Image.assign(image, image + 3 * options.Width * options.Height);
+	delete[] image;
+
+	result.PixelSamples = SampleSum(tracer.GetAccumulation());
+	result.Radiance = tracer.GetAccumulationBuffer();
+	return result;
+}
+
+//The workers send back sums, so the assembled image tone maps and denoises like one traced here
+static bool RenderDistributed(const RenderOptions& options, const Scene& scene, const std::string& executable, RenderResult& result)
+{
+	const bool denoise = options.Denoise || scene.m_Denoise;
+
+	DistributedJob job;
+	job.Width = options.Width;
+	job.Height = options.Height;
+	job.Samples = (uint32_t)options.Samples;
+	job.AOVs = denoise;
+
+	RenderCoordinator coordinator(scene, job, options.TileSize);
+	if (!coordinator.Listen(options.ListenAddress, options.Listen ? options.ListenPort : 0))
+		return false;
+
+	const auto start = std::chrono::steady_clock::now();
+	const unsigned int threads = options.Threads > 0 ? options.Threads : std::max(std::thread::hardware_concurrency() / std::max(options.LocalWorkers, 1u), 1u);
+	if (options.LocalWorkers > 0 && !coordinator.StartLocalWorkers(executable, options.LocalWorkers, threads))
+		return false;
+
+	AccumulationBuffer image;
+	if (!coordinator.Render(image))
+		return false;
+
+	CpuRayTracer tracer(options.Width, options.Height, options.Threads);
+	tracer.LoadScene(scene);
+	tracer.SetDenoise(denoise);
+	tracer.Merge(image);
+	if (denoise)
+		tracer.Denoise();
+
+	result.Seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	result.Samples = coordinator.RenderedSamples();
+	result.PathLength = coordinator.AveragePathLength();
+	result.Device = std::format("{} workers, {} tiles, {} reassigned, {} duplicated", coordinator.WorkerCount(), coordinator.TileCount(),
+		coordinator.ReassignedTiles(), coordinator.DuplicateTiles());
+
+	unsigned char* pixels = tracer.GetRenderedImage();
+	result.Image.assign(pixels, pixels + 3 * options.Width * options.Height);
+	delete[] pixels;
+
+	result.PixelSamples = SampleSum(image);
+	result.Radiance = image.MeanImage();
+	return true;
+}
+
+#ifdef HALOGEN_EGL
+static bool RenderGPU(const RenderOptions& options, const Scene& scene, RenderResult& result)
+{
+	HeadlessContext context;
+	if (!context.Create())
+		return false;
+
+	//Scoped so the tracer lets go of its GL objects before the context goes
+	{
+		RayTracer tracer(options.Width, options.Height);
+		tracer.LoadScene(scene);
+		tracer.StartAccumulation();
+		tracer.SetPassTime(OfflinePassTime);
+		if (options.Denoise)
+			tracer.SetDenoise(true);
+
+		if (options.Seconds > 0.0f)
+			tracer.SetTimeLimit(options.Seconds);
+
+		const auto start = std::chrono::steady_clock::now();
+		while (!tracer.Finished())
+		{
+			const int remaining = options.Samples > 0 ? options.Samples - (int)tracer.RenderedSamples() : INT32_MAX;
+			if (remaining <= 0)
+				break;
+
+			tracer.Accumulate(remaining);
+		}
+
+		tracer.PostProcess();
+		glFinish();
+
+		result.Seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		result.Samples = tracer.RenderedSamples();
+		result.PathLength = tracer.AveragePathLength();
+		result.Device = (const char*)glGetString(GL_RENDERER);
+
+		unsigned char* image = tracer.GetRenderedImage();
+		result.Image.assign(image, image + 3 * options.Width * options.Height);
+		delete[] image;
+
+		const AccumulationBuffer accumulation = tracer.ReadAccumulation();
+		result.PixelSamples = SampleSum(accumulation);
+		result.Radiance = accumulation.MeanImage();
+	}
+
+	return true;
+}
+#endif
+
+//The accumulation is addressed like the tracers' framebuffers, which PostProcess.glsl and GetRenderedImage show turned
+//half a turn, so the radiance is turned the same way to line up with the tone mapped image
+static std::vector<glm::vec3> DisplayOrder(const std::vector<glm::vec3>& image, const int& Width, const int& Height)
+{
+	std::vector<glm::vec3> turned(image.size());
+	for (int y = 0; y < Height; y++)
+	{
+		for (int x = 0; x < Width; x++)
+			turned[(size_t)y * Width + x] = image[(size_t)(Height - 1 - y) * Width + Width - 1 - x];
+	}
+
+	return turned;
+}
+
+static bool WriteImage(const std::string& path, const int& Width, const int& Height, const RenderResult& result)
+{
+	std::string extension = std::filesystem::path(path).extension().string();
+	std::transform(extension.begin(), extension.end(), extension.begin(), [](const unsigned char& c) { return (char)std::tolower(c); });
+
+	stbi_flip_vertically_on_write(1);
+	int written = 0;
+	if (extension == ".png")
+		written = stbi_write_png(path.c_str(), Width, Height, 3, result.Image.data(), 0);
+
+	else if (extension == ".jpg" || extension == ".jpeg")
+		written = stbi_write_jpg(path.c_str(), Width, Height, 3, result.Image.data(), 100);
+
+	else if (extension == ".bmp")
+		written = stbi_write_bmp(path.c_str(), Width, Height, 3, result.Image.data());
+
+	else if (extension == ".tga")
+		written = stbi_write_tga(path.c_str(), Width, Height, 3, result.Image.data());
+
+	else if (extension == ".hdr")
+	{
+		const std::vector<glm::vec3> radiance = DisplayOrder(result.Radiance, Width, Height);
+		written = stbi_write_hdr(path.c_str(), Width, Height, 3, &radiance[0].x);
+	}
+
+	else
+	{
+		std::println("Unknown image format {}", extension);
+		return false;
+	}
+
+	if (!written)
+		std::println("Could not write {}", path);
+
+	return written != 0;
+}
+
+int main(int argc, char** argv)
+{
+	RenderOptions options;
+	if (!ParseArguments(argc, argv, options))
+	{
+		PrintUsage(argv[0]);
+		return 1;
+	}
+
+	if (options.Worker)
+		return RenderWorker(options.Threads).Run(options.CoordinatorHost, options.CoordinatorPort) ? 0 : 1;
+
+	Scene scene;
+	if (!scene.Load(options.ScenePath))
+		return 1;
+
+	RenderResult result;
+	if (options.LocalWorkers > 0 || options.Listen)
+	{
+		if (!RenderDistributed(options, scene, argv[0], result))
+			return 1;
+	}
+
+	else if (options.CPU)
+		result = RenderCPU(options, scene);
+
+	else
+	{
+#ifdef HALOGEN_EGL
+		if (!RenderGPU(options, scene, result))
+			return 1;
+#else
+		std::println("Built without EGL, rendering on the CPU");
+		result = RenderCPU(options, scene);
+#endif
+	}
+
+	if (!WriteImage(options.OutputPath, options.Width, options.Height, result))
+		return 1;
+
+	std::println("Rendered {} samples at {}x{} on {} in {:.3f} s", result.Samples, options.Width, options.Height, result.Device, result.Seconds);
+	std::println("{:.2f} samples/s, {:.2f} Msamples/s, average path length {:.2f}", result.Samples / result.Seconds, result.PixelSamples / result.Seconds / 1e6, result.PathLength);
+	std::println("Wrote {}", options.OutputPath);
+	return 0;
+}
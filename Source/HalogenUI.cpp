@@ -2,7 +2,7 @@
 
 namespace HalogenUI
 {
-	void RenderSettings(Renderer& renderer, RayTracer& RayTracer, Scene& scene, ImGuiIO& io, const float& SinceLastSave, const float& SinceLastRender)
+	void RenderSettings(Renderer& renderer, RayTracer& RayTracer, Scene& scene, FrameScheduler& scheduler, Navigation& navigation, ImGuiIO& io, const float& SinceLastSave, const float& SinceLastRender)
 	{
 		ImGui::Begin("Render Settings");
 
@@ -10,8 +10,8 @@ namespace HalogenUI
 
 		bool modified = false;
 
-		int ResX = RayTracer.GetFramebufferWidth();
-		int ResY = RayTracer.GetFramebufferHeight();
+		int ResX = navigation.GetWidth();
+		int ResY = navigation.GetHeight();
 		ImGui::Text("Image");
 		modified |= ImGui::DragInt("Resolution X", &ResX, 1.0, 1, INT32_MAX);
 		modified |= ImGui::DragInt("Resolution Y", &ResY, 1.0, 1, INT32_MAX);
@@ -19,13 +19,23 @@ namespace HalogenUI
 
 		if (modified)
 		{
-			RayTracer.FramebufferReSize(ResX, ResY);
+			navigation.SetResolution(ResX, ResY);
+			RayTracer.FramebufferReSize(navigation.GetRenderWidth(), navigation.GetRenderHeight());
 			renderer.SetRenderResolution(ResX, ResY);
 			RayTracer.ResetAccumulation();
 		}
 
 		ImGui::Text("Light Paths");
 		modified |= ImGui::DragInt("Max Depth", &scene.m_MaxDepth, 1.0, 0, INT32_MAX);
+		modified |= ImGui::DragInt("Roulette Depth", &scene.m_RouletteDepth, 1.0, 0, INT32_MAX);
+		int sampler = (int)scene.m_Sampler;
+		if (ImGui::Combo("Sampler", &sampler, "Random\0Sobol\0Blue Noise\0"))
+		{
+			scene.m_Sampler = (SamplerType)sampler;
+			RayTracer.SetSampler(scene.m_Sampler);
+			RayTracer.ResetAccumulation();
+		}
+
 		if (ImGui::Checkbox("Render Black Hole", &scene.RenderBlackHole))
 		{
 			RayTracer.SetRenderBlackHole(scene.RenderBlackHole);
@@ -47,6 +57,21 @@ namespace HalogenUI
 		}
 		ImGui::Separator();
 
+		ImGui::Text("Convergence");
+		if (ImGui::DragFloat("Noise Threshold", &scene.m_NoiseThreshold, 0.001f, 0.0f, 1.0f))
+			RayTracer.SetNoiseThreshold(scene.m_NoiseThreshold);
+
+		if (ImGui::DragFloat("Quality Target", &scene.m_QualityTarget, 0.001f, 0.0f, 1.0f))
+			RayTracer.SetQualityTarget(scene.m_QualityTarget);
+
+		if (ImGui::DragFloat("Time Limit", &scene.m_TimeLimit, 1.0f, 0.0f, 86400.0f))
+			RayTracer.SetTimeLimit(scene.m_TimeLimit);
+
+		float budget = scheduler.GetBudget();
+		if (ImGui::DragFloat("Frame Budget", &budget, 0.1f, 1.0f, 1000.0f, "%.1f ms"))
+			scheduler.SetBudget(budget);
+		ImGui::Separator();
+
 		ImGui::Text("World");
 		modified |= ImGui::SliderFloat("Sun Radius", &scene.m_SunRadius, 0.0f, 15.0f);
 		modified |= ImGui::SliderFloat("Sun Intensity", &scene.m_SunIntensity, 0.0f, 2000.0f);
@@ -65,6 +90,20 @@ namespace HalogenUI
 		ImGui::Text("Post Processing");
 		ImGui::SliderFloat("Exposure", &scene.m_Exposure, 0.0, 3.0);
 		ImGui::SliderFloat("Gamma", &scene.m_Gamma, 0.0, 3.0);
+
+		//The AOVs are only written while one of them is shown or the denoiser needs them
+		static int displayed = (int)AOV::Color;
+		if (ImGui::Combo("Display", &displayed, "Color\0Albedo\0Normal\0Depth\0Material ID\0Object ID\0"))
+		{
+			RayTracer.SetAOVs(displayed != (int)AOV::Color);
+			RayTracer.SetDisplayedAOV((AOV)displayed);
+		}
+
+		if (ImGui::Checkbox("Denoise", &scene.m_Denoise))
+		{
+			RayTracer.SetDenoise(scene.m_Denoise);
+			RayTracer.SetAOVs(displayed != (int)AOV::Color);
+		}
 		ImGui::Separator();
 
 		RayTracer.Setting(PostProcess_Setting::Gamma, scene.m_Gamma);
@@ -77,7 +116,8 @@ namespace HalogenUI
 			RayTracer.Setting(RT_Setting::Sun_Altitude, glm::radians(scene.m_SunAltitude));
 			RayTracer.Setting(RT_Setting::Sun_Azimuthal, glm::radians(scene.m_SunAzimuthal));
 			RayTracer.Setting(RT_Setting::Sky_Variation, scene.m_SkyVariation);
-			RayTracer.Setting(RT_Setting::Max_Depth, scene.m_MaxDepth);
+			RayTracer.Setting(RT_Setting::Max_Depth, navigation.GetMaxDepth(scene));
+			RayTracer.Setting(RT_Setting::Roulette_Depth, scene.m_RouletteDepth);
 			RayTracer.Setting(RT_Setting::Sensor_Size, scene.m_SensorSize / 1000.0);
 			RayTracer.Setting(RT_Setting::Focal_Length, scene.m_FocalLength / 1000.0);
 			RayTracer.Setting(RT_Setting::Focus_Dist, scene.m_FocusDist);
@@ -87,8 +127,17 @@ namespace HalogenUI
 		std::stringstream ss;
 		ss << "Samples: " << RayTracer.RenderedSamples();
 		ImGui::Text(ss.str().c_str());
+		ImGui::Text("%d samples per pass, %.1f samples/s", RayTracer.SamplesPerPass(), scheduler.SamplesPerSecond());
+		ImGui::Text("Average path length %.2f", RayTracer.AveragePathLength());
+		ImGui::Text("Relative error %.4f, %.1f%% of pixels sampled", RayTracer.RelativeError(), 100.0f * RayTracer.ActivePixels());
+		if (RayTracer.Finished())
+			ImGui::Text("Finished");
+
+		if (navigation.Active())
+			ImGui::Text("Navigating at 1/%d resolution", navigation.GetDivisor());
 
 		ImGui::Text("Application average %.3f ms/frame (%.1f FPS)", 1000.0f / io.Framerate, io.Framerate);
+		ImGui::Text("UI latency %.1f ms, %.1f ms of it outside tracing", scheduler.FrameTime(), scheduler.UITime());
 
 		if (SinceLastSave < DisplayTime)
 			ImGui::Text("Saved");
@@ -5,10 +5,12 @@
 #include "Ray Tracer.h"
 #include "Renderer.h"
 #include "Scene.h"
+#include "FrameScheduler.h"
+#include "Navigation.h"
 
 namespace HalogenUI
 {
-	void RenderSettings(Renderer& renderer, RayTracer& RayTracer, Scene& scene, ImGuiIO& io, const float& SinceLastSave, const float& SinceLastRender);
+	void RenderSettings(Renderer& renderer, RayTracer& RayTracer, Scene& scene, FrameScheduler& scheduler, Navigation& navigation, ImGuiIO& io, const float& SinceLastSave, const float& SinceLastRender);
 	void SceneSettings(RayTracer& RayTracer, Scene& scene);
 	void MaterialSettings(RayTracer& RayTracer, Scene& scene);
 }
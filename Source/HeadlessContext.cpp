@@ -0,0 +1,80 @@
+#include "HeadlessContext.h"
+
+#include <GL/glew.h>
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#include <print>
+
+HeadlessContext::~HeadlessContext()
+{
+	if (m_Context == nullptr)
+		return;
+
+	eglMakeCurrent(m_Display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+	eglDestroyContext(m_Display, m_Context);
+	eglTerminate(m_Display);
+}
+
+bool HeadlessContext::Create()
+{
+	EGLDisplay display = EGL_NO_DISPLAY;
+	auto GetPlatformDisplay = (PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+	if (GetPlatformDisplay != nullptr)
+		display = GetPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+
+	if (display == EGL_NO_DISPLAY)
+		display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+
+	if (display == EGL_NO_DISPLAY || !eglInitialize(display, nullptr, nullptr))
+	{
+		std::println("Could not initialize an EGL display, error {:#x}", eglGetError());
+		return false;
+	}
+
+	m_Display = display;
+	eglBindAPI(EGL_OPENGL_API);
+
+	//Same version as the window of Application.cpp, drivers hand out their newest core context for it
+	const EGLint ConfigAttributes[] = { EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT, EGL_NONE };
+	EGLConfig config = nullptr;
+	EGLint configs = 0;
+	eglChooseConfig(display, ConfigAttributes, &config, 1, &configs);
+
+	const EGLint ContextAttributes[] =
+	{
+		EGL_CONTEXT_MAJOR_VERSION, 3,
+		EGL_CONTEXT_MINOR_VERSION, 3,
+		EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+		EGL_NONE
+	};
+
+	EGLContext context = eglCreateContext(display, configs > 0 ? config : EGL_NO_CONFIG_KHR, EGL_NO_CONTEXT, ContextAttributes);
+	if (context == EGL_NO_CONTEXT)
+	{
+		std::println("Could not create an OpenGL context, error {:#x}", eglGetError());
+		return false;
+	}
+
+	m_Context = context;
+	if (!eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, context))
+	{
+		std::println("Could not make the OpenGL context current, error {:#x}", eglGetError());
+		return false;
+	}
+
+	//GLEW looks for a GLX display after loading the functions, there is none here. Core contexts have no extension
+	//string to go by, so it loads whatever the driver exports
+	glewExperimental = GL_TRUE;
+	const GLenum status = glewInit();
+#ifdef GLEW_ERROR_NO_GLX_DISPLAY
+	if (status != GLEW_OK && status != GLEW_ERROR_NO_GLX_DISPLAY)
+#else
+	if (status != GLEW_OK)
+#endif
+	{
+		std::println("GLEW ERROR");
+		return false;
+	}
+
+	return true;
+}
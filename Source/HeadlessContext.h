@@ -0,0 +1,17 @@
+#pragma once
+
+//OpenGL context without a window or a display server, on a surfaceless EGL display where Mesa offers one (llvmpipe
+//is enough) and on the default display otherwise. RayTracer renders to its own framebuffers so it never needs a
+//surface. Only built where HALOGEN_EGL is defined, see CMakeLists.txt
+class HeadlessContext
+{
+public:
+	HeadlessContext() = default;
+	~HeadlessContext();
+
+	bool Create();
+
+private:
+	void* m_Display = nullptr;
+	void* m_Context = nullptr;
+};
@@ -0,0 +1,123 @@
+#include "LightList.h"
+
+void LightList::Build(const SphereStore& spheres, const std::vector<bool>& EmissiveMaterials)
+{
+	m_EmissiveMaterials = EmissiveMaterials;
+	m_Slots.clear();
+	m_LightOfSlot.assign(spheres.Size(), -1);
+
+	for (size_t slot = 0; slot < spheres.Size(); slot++)
+	{
+		if (Emissive(spheres.MaterialIndex(slot)))
+			Add(slot);
+	}
+}
+
+//Drops every light but remembers which materials emit, for when the spheres are cleared out
+void LightList::Clear()
+{
+	m_Slots.clear();
+	m_LightOfSlot.clear();
+}
+
+//Returns whether the list changed, a material that keeps emitting leaves it as it is
+bool LightList::SetMaterial(const SphereStore& spheres, const int& MaterialIndex, const bool& emissive)
+{
+	if (MaterialIndex < 0)
+		return false;
+
+	if ((size_t)MaterialIndex >= m_EmissiveMaterials.size())
+		m_EmissiveMaterials.resize(MaterialIndex + 1, false);
+
+	if (m_EmissiveMaterials[MaterialIndex] == emissive)
+		return false;
+
+	m_EmissiveMaterials[MaterialIndex] = emissive;
+	m_LightOfSlot.resize(spheres.Size(), -1);
+
+	bool changed = false;
+	for (size_t slot = 0; slot < spheres.Size(); slot++)
+	{
+		if (spheres.MaterialIndex(slot) != MaterialIndex)
+			continue;
+
+		if (emissive)
+			Add(slot);
+
+		else
+			Remove(slot);
+
+		changed = true;
+	}
+
+	return changed;
+}
+
+//For a sphere that was added or given another material, returns whether it joined or left the list
+bool LightList::SetSphere(const SphereStore& spheres, const size_t& slot)
+{
+	m_LightOfSlot.resize(spheres.Size(), -1);
+
+	const bool emissive = Emissive(spheres.MaterialIndex(slot));
+	if (emissive == (m_LightOfSlot[slot] >= 0))
+		return false;
+
+	if (emissive)
+		Add(slot);
+
+	else
+		Remove(slot);
+
+	return true;
+}
+
+bool LightList::Empty() const
+{
+	return m_Slots.empty();
+}
+
+size_t LightList::Size() const
+{
+	return m_Slots.size();
+}
+
+uint32_t LightList::Slot(const size_t& light) const
+{
+	return m_Slots[light];
+}
+
+int LightList::LightOf(const size_t& slot) const
+{
+	return slot < m_LightOfSlot.size() ? m_LightOfSlot[slot] : -1;
+}
+
+const std::vector<uint32_t>& LightList::GetSlots() const
+{
+	return m_Slots;
+}
+
+bool LightList::Emissive(const int& MaterialIndex) const
+{
+	return MaterialIndex >= 0 && (size_t)MaterialIndex < m_EmissiveMaterials.size() && m_EmissiveMaterials[MaterialIndex];
+}
+
+void LightList::Add(const size_t& slot)
+{
+	if (m_LightOfSlot[slot] >= 0)
+		return;
+
+	m_LightOfSlot[slot] = (int)m_Slots.size();
+	m_Slots.push_back((uint32_t)slot);
+}
+
+void LightList::Remove(const size_t& slot)
+{
+	const int light = m_LightOfSlot[slot];
+	if (light < 0)
+		return;
+
+	m_Slots[light] = m_Slots.back();
+	m_LightOfSlot[m_Slots[light]] = light;
+	m_Slots.pop_back();
+	m_LightOfSlot[slot] = -1;
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+
+#include "SphereStore.h"
+
+//Slots of the emissive spheres, the ones direct light sampling aims at. Material and sphere edits only add or drop
+//the spheres they touch, removing a light moves the last one into its place
+class LightList
+{
+public:
+	void Build(const SphereStore& spheres, const std::vector<bool>& EmissiveMaterials);
+	void Clear();
+
+	bool SetMaterial(const SphereStore& spheres, const int& MaterialIndex, const bool& emissive);
+	bool SetSphere(const SphereStore& spheres, const size_t& slot);
+
+	bool Empty() const;
+	size_t Size() const;
+	uint32_t Slot(const size_t& light) const;
+	int LightOf(const size_t& slot) const;
+	const std::vector<uint32_t>& GetSlots() const;
+
+private:
+	bool Emissive(const int& MaterialIndex) const;
+	void Add(const size_t& slot);
+	void Remove(const size_t& slot);
+
+private:
+	std::vector<bool> m_EmissiveMaterials;
+	std::vector<uint32_t> m_Slots;
+	std::vector<int> m_LightOfSlot;												//-1 for spheres that don't emit
+};
@@ -0,0 +1,208 @@
+#include "LightTree.h"
+
+#include <algorithm>
+#include <numeric>
+#include <cmath>
+#include <cfloat>
+
+void LightTree::Build(const SphereStore& spheres, const LightList& lights, const std::vector<float>& MaterialRadiance)
+{
+	Clear();
+	m_MaterialRadiance = MaterialRadiance;
+	if (lights.Empty())
+		return;
+
+	std::vector<uint32_t> order(lights.Size());
+	std::iota(order.begin(), order.end(), 0);
+
+	m_Nodes.reserve(2 * lights.Size() - 1);
+	m_Parents.reserve(2 * lights.Size() - 1);
+	m_LightLeaf.assign(lights.Size(), 0);
+	BuildNode(spheres, lights, order, 0, (uint32_t)order.size(), UINT32_MAX);
+}
+
+void LightTree::Clear()
+{
+	m_Nodes.clear();
+	m_Parents.clear();
+	m_LightLeaf.clear();
+}
+
+//For a light that moved, was resized or given another emissive material, the list itself staying the same
+void LightTree::Refit(const SphereStore& spheres, const LightList& lights, const size_t& light, std::vector<uint32_t>& ChangedNodes)
+{
+	if (light >= m_LightLeaf.size())
+		return;
+
+	uint32_t index = m_LightLeaf[light];
+	FitLeaf(spheres, lights, (uint32_t)light, index);
+	ChangedNodes.push_back(index);
+
+	index = m_Parents[index];
+	while (index != UINT32_MAX)
+	{
+		FitNode(index);
+		ChangedNodes.push_back(index);
+		index = m_Parents[index];
+	}
+}
+
+//u is rescaled at every level so one number drives the whole descent. Returns the light picked and the probability
+//it was picked with, -1 when there are no lights
+int LightTree::Sample(const glm::vec3& point, float u, float& pdf) const
+{
+	pdf = 0.0f;
+	if (m_Nodes.empty())
+		return -1;
+
+	pdf = 1.0f;
+	uint32_t index = 0;
+	while (!(m_Nodes[index].Child & LightLeafBit))
+	{
+		const float left = LeftProbability(index, point);
+		if (u < left)
+		{
+			u = u / left;
+			pdf *= left;
+			index++;
+		}
+
+		else
+		{
+			u = (u - left) / (1.0f - left);
+			pdf *= 1.0f - left;
+			index = m_Nodes[index].Child;
+		}
+
+		u = std::min(u, 0.99999994f);
+	}
+
+	return (int)(m_Nodes[index].Child & ~LightLeafBit);
+}
+
+//Probability Sample picks light with from point, retracing the walk down to its leaf
+float LightTree::Pdf(const glm::vec3& point, const size_t& light) const
+{
+	if (light >= m_LightLeaf.size())
+		return 0.0f;
+
+	const uint32_t leaf = m_LightLeaf[light];
+	float pdf = 1.0f;
+	uint32_t index = 0;
+	while (index != leaf)
+	{
+		const float left = LeftProbability(index, point);
+		if (leaf < m_Nodes[index].Child)
+		{
+			pdf *= left;
+			index++;
+		}
+
+		else
+		{
+			pdf *= 1.0f - left;
+			index = m_Nodes[index].Child;
+		}
+	}
+
+	return pdf;
+}
+
+bool LightTree::Empty() const
+{
+	return m_Nodes.empty();
+}
+
+uint32_t LightTree::LeafOf(const size_t& light) const
+{
+	return m_LightLeaf[light];
+}
+
+const std::vector<LightNode>& LightTree::GetNodes() const
+{
+	return m_Nodes;
+}
+
+float LightTree::Luminance(const glm::vec3& color)
+{
+	return glm::dot(color, glm::vec3(0.2126f, 0.7152f, 0.0722f));
+}
+
+//Median split on the longest axis of the centers, leaves hold one light so the pdf of every light can be retraced exactly
+uint32_t LightTree::BuildNode(const SphereStore& spheres, const LightList& lights, std::vector<uint32_t>& order, const uint32_t& begin, const uint32_t& end, const uint32_t& parent)
+{
+	const uint32_t index = (uint32_t)m_Nodes.size();
+	m_Nodes.emplace_back();
+	m_Parents.push_back(parent);
+
+	if (end - begin == 1)
+	{
+		FitLeaf(spheres, lights, order[begin], index);
+		return index;
+	}
+
+	glm::vec3 CentroidMin = glm::vec3(FLT_MAX);
+	glm::vec3 CentroidMax = glm::vec3(-FLT_MAX);
+	for (uint32_t i = begin; i < end; i++)
+	{
+		const glm::vec3 center = spheres.Position(lights.Slot(order[i]));
+		CentroidMin = glm::min(CentroidMin, center);
+		CentroidMax = glm::max(CentroidMax, center);
+	}
+
+	const glm::vec3 extent = CentroidMax - CentroidMin;
+	const int axis = extent.x > extent.y ? (extent.x > extent.z ? 0 : 2) : (extent.y > extent.z ? 1 : 2);
+	const uint32_t middle = begin + (end - begin) / 2;
+	std::nth_element(order.begin() + begin, order.begin() + middle, order.begin() + end, [&](const uint32_t& a, const uint32_t& b)
+	{
+		return spheres.Position(lights.Slot(a))[axis] < spheres.Position(lights.Slot(b))[axis];
+	});
+
+	BuildNode(spheres, lights, order, begin, middle, index);
+	m_Nodes[index].Child = BuildNode(spheres, lights, order, middle, end, index);
+	FitNode(index);
+	return index;
+}
+
+//Power only has to be proportional to what the sphere gives off, radiance times its cross section
+void LightTree::FitLeaf(const SphereStore& spheres, const LightList& lights, const uint32_t& light, const uint32_t& index)
+{
+	const uint32_t slot = lights.Slot(light);
+	const glm::vec3 center = spheres.Position(slot);
+	const float radius = std::abs(spheres.Radius(slot));
+	const int MaterialIndex = spheres.MaterialIndex(slot);
+	const float radiance = MaterialIndex >= 0 && (size_t)MaterialIndex < m_MaterialRadiance.size() ? m_MaterialRadiance[MaterialIndex] : 0.0f;
+
+	LightNode& node = m_Nodes[index];
+	node.Min = center - glm::vec3(radius);
+	node.Max = center + glm::vec3(radius);
+	node.Power = std::max(radiance, 0.0f) * radius * radius;
+	node.Child = LightLeafBit | light;
+	m_LightLeaf[light] = index;
+}
+
+void LightTree::FitNode(const uint32_t& index)
+{
+	LightNode& node = m_Nodes[index];
+	const LightNode& left = m_Nodes[index + 1];
+	const LightNode& right = m_Nodes[node.Child];
+	node.Min = glm::min(left.Min, right.Min);
+	node.Max = glm::max(left.Max, right.Max);
+	node.Power = left.Power + right.Power;
+}
+
+//Importance of a child is its power over the squared distance to the middle of its box. That distance is clamped to the
+//half diagonal, so a point close to or inside a cluster doesn't give it all the weight
+static float Importance(const LightNode& node, const glm::vec3& point)
+{
+	const glm::vec3 extent = node.Max - node.Min;
+	const glm::vec3 offset = 0.5f * (node.Min + node.Max) - point;
+	return node.Power / std::max(std::max(glm::dot(offset, offset), 0.25f * glm::dot(extent, extent)), FLT_MIN);
+}
+
+float LightTree::LeftProbability(const uint32_t& index, const glm::vec3& point) const
+{
+	const float left = Importance(m_Nodes[index + 1], point);
+	const float right = Importance(m_Nodes[m_Nodes[index].Child], point);
+	return left + right > 0.0f ? left / (left + right) : 0.5f;
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+
+#include <glm.hpp>
+
+#include "SphereStore.h"
+#include "LightList.h"
+
+const uint32_t LightLeafBit = 0x80000000u;
+
+//Interior nodes keep their left child right after them and store the index of the right child in Child,
+//leaves hold a single light and store LightLeafBit | its index in the LightList
+struct LightNode
+{
+	glm::vec3 Min = glm::vec3(0.0f);
+	float Power = 0.0f;
+	glm::vec3 Max = glm::vec3(0.0f);
+	uint32_t Child = 0;
+};
+
+static_assert(sizeof(LightNode) == 32, "LightNode should fill exactly half a cache line");
+
+//Binary tree over the lights of a LightList, flattened in depth first order. Each node keeps the bounds and total power
+//of the lights below it, a light is picked by walking down from the root in proportion to how much each child could
+//contribute at the shading point, so the cost grows with the depth rather than the light count.
+//Spheres emit the same way in every direction, so there's no orientation cone to bound, every node would have the full sphere
+class LightTree
+{
+public:
+	void Build(const SphereStore& spheres, const LightList& lights, const std::vector<float>& MaterialRadiance);
+	void Clear();
+
+	void Refit(const SphereStore& spheres, const LightList& lights, const size_t& light, std::vector<uint32_t>& ChangedNodes);
+
+	int Sample(const glm::vec3& point, float u, float& pdf) const;
+	float Pdf(const glm::vec3& point, const size_t& light) const;
+
+	bool Empty() const;
+	uint32_t LeafOf(const size_t& light) const;
+	const std::vector<LightNode>& GetNodes() const;
+
+	static float Luminance(const glm::vec3& color);
+
+private:
+	uint32_t BuildNode(const SphereStore& spheres, const LightList& lights, std::vector<uint32_t>& order, const uint32_t& begin, const uint32_t& end, const uint32_t& parent);
+	void FitLeaf(const SphereStore& spheres, const LightList& lights, const uint32_t& light, const uint32_t& index);
+	void FitNode(const uint32_t& index);
+	float LeftProbability(const uint32_t& index, const glm::vec3& point) const;
+
+private:
+	std::vector<LightNode> m_Nodes;
+	std::vector<uint32_t> m_Parents;
+	std::vector<uint32_t> m_LightLeaf;
+	std::vector<float> m_MaterialRadiance;									//Luminance of Albedo * Emission for every material
+};
@@ -0,0 +1,117 @@
+#include "Navigation.h"
+
+static const int ResolutionDivisors[] = { 1, 2, 3, 4, 6, 8 };
+static const float DivisorChangeTime = 0.25f;									//Resizing reallocates the framebuffers, not every frame
+
+Navigation::Navigation(const int& Width, const int& Height)
+	:m_Width(Width), m_Height(Height)
+{
+}
+
+//Full resolution, the tracer only runs at it while the camera is still
+void Navigation::SetResolution(const int& Width, const int& Height)
+{
+	m_Width = Width;
+	m_Height = Height;
+}
+
+int Navigation::GetWidth() const
+{
+	return m_Width;
+}
+
+int Navigation::GetHeight() const
+{
+	return m_Height;
+}
+
+int Navigation::GetRenderWidth() const
+{
+	return std::max(m_Width / m_Divisor, 1);
+}
+
+int Navigation::GetRenderHeight() const
+{
+	return std::max(m_Height / m_Divisor, 1);
+}
+
+int Navigation::GetDivisor() const
+{
+	return m_Divisor;
+}
+
+bool Navigation::Active() const
+{
+	return m_Active;
+}
+
+//Path depth the tracer should run at, the scene's while the camera is still
+int Navigation::GetMaxDepth(const Scene& scene) const
+{
+	return m_Active ? std::min(scene.m_MaxDepth, NavigationMaxDepth) : scene.m_MaxDepth;
+}
+
+//Call once a frame before tracing, moved when the camera was turned or moved since the last one
+void Navigation::Update(RayTracer& RayTracer, const Scene& scene, const FrameScheduler& scheduler, const bool& moved, const float& deltaTime)
+{
+	m_Still = moved ? 0.0f : m_Still + deltaTime;
+	m_SinceChange += deltaTime;
+
+	if (!m_Active)
+	{
+		if (!moved)
+			return;
+
+		m_Active = true;
+		Apply(RayTracer, scene, PickDivisor(RayTracer, scheduler));
+		return;
+	}
+
+	if (m_Still >= NavigationSettleTime)
+	{
+		m_Active = false;
+		Apply(RayTracer, scene, 1);
+		return;
+	}
+
+	if (!moved || m_SinceChange < DivisorChangeTime)
+		return;
+
+	const int divisor = PickDivisor(RayTracer, scheduler);
+	if (divisor != m_Divisor)
+		Apply(RayTracer, scene, divisor);
+}
+
+//RayTracer::SampleTime is per sample at the current resolution, the cost of one at full resolution is that times the
+//pixels it left out. Frames that are too slow step down right away, finer steps wait for a margin so the resolution
+//doesn't flip back and forth at the edge of the budget. Without a measurement yet it starts at half resolution
+int Navigation::PickDivisor(const RayTracer& RayTracer, const FrameScheduler& scheduler) const
+{
+	const double SampleTime = RayTracer.SampleTime();
+	if (SampleTime <= 0.0)
+		return m_Active && m_Divisor > 1 ? m_Divisor : 2;
+
+	const double FullSampleTime = SampleTime * m_Divisor * m_Divisor;
+	const double available = std::max((double)scheduler.GetBudget() - scheduler.UITime(), 0.0);
+	for (const int& divisor : ResolutionDivisors)
+	{
+		const double cost = FullSampleTime / (divisor * divisor);
+		if (divisor < m_Divisor ? cost <= 0.7 * available : cost <= available)
+			return divisor;
+	}
+
+	return ResolutionDivisors[std::size(ResolutionDivisors) - 1];
+}
+
+void Navigation::Apply(RayTracer& RayTracer, const Scene& scene, const int& divisor)
+{
+	m_SinceChange = 0.0f;
+	if (divisor != m_Divisor)
+	{
+		m_Divisor = divisor;
+		RayTracer.FramebufferReSize(GetRenderWidth(), GetRenderHeight());
+	}
+
+	RayTracer.Setting(RT_Setting::Max_Depth, GetMaxDepth(scene));
+	RayTracer.ResetAccumulation();
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include "Ray Tracer.h"
+#include "Scene.h"
+#include "FrameScheduler.h"
+
+const int NavigationMaxDepth = 3;
+const float NavigationSettleTime = 0.25f;										//Seconds the camera stays still before the full quality comes back
+
+//Lowers the resolution and path depth of the tracer while the camera moves so every frame of a fly-through is one
+//sample that fits the frame budget, Display.glsl scales the smaller image back up. The resolution is divided by the
+//smallest of ResolutionDivisors whose sample fits next to the rest of the frame, chosen again as the sample time
+//changes. Once the camera has settled the full resolution and depth come back and accumulation starts over
+class Navigation
+{
+public:
+	Navigation(const int& Width, const int& Height);
+
+	void SetResolution(const int& Width, const int& Height);
+	int GetWidth() const;
+	int GetHeight() const;
+	int GetRenderWidth() const;
+	int GetRenderHeight() const;
+	int GetDivisor() const;
+	bool Active() const;
+	int GetMaxDepth(const Scene& scene) const;
+
+	void Update(RayTracer& RayTracer, const Scene& scene, const FrameScheduler& scheduler, const bool& moved, const float& deltaTime);
+
+private:
+	int PickDivisor(const RayTracer& RayTracer, const FrameScheduler& scheduler) const;
+	void Apply(RayTracer& RayTracer, const Scene& scene, const int& divisor);
+
+private:
+	int m_Width;
+	int m_Height;
+	int m_Divisor = 1;
+	bool m_Active = false;
+	float m_Still = 0.0f;														//Seconds since the camera last moved
+	float m_SinceChange = 0.0f;
+};
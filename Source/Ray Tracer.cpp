@@ -1,4 +1,5 @@
 #include"Ray Tracer.h"
+#include "SphereIntersect.h"
 
 RayTracer::RayTracer(const int& FramebufferWidth, const int& FramebufferHeight)
 	:m_RenderTexSlot(1), m_AccumulationTexSlot(2), m_FramebufferWidth(FramebufferWidth), m_FramebufferHeight(FramebufferHeight)
@@ -10,6 +11,7 @@ RayTracer::RayTracer(const int& FramebufferWidth, const int& FramebufferHeight)
 
 	m_RTShader.SetUniform("View", m_Camera.GetViewMatrix());
 	m_RTShader.SetUniform("CameraPos", Vec3(m_Camera.m_Position.x, m_Camera.m_Position.y, m_Camera.m_Position.z));
+	m_RTShader.SetUniform("SamplesPerPass", 1);
 
 	float Vertices[] =
 	{				   //Tex Coords
@@ -34,7 +36,10 @@ RayTracer::RayTracer(const int& FramebufferWidth, const int& FramebufferHeight)
 	m_WindowVA.AddBuffer(m_WindowVB, WindowBufferLayout);
 	m_WindowIB.Bind();
 
-	m_SphereList.reserve(2);
+	const std::vector<uint32_t>& ranks = Sampler::BlueNoiseRanks();
+	m_BlueNoiseBuffer.Load(ranks.data(), ranks.size() * sizeof(uint32_t), GL_R32UI);
+
+	m_Spheres.Reserve(2);
 	SetDefaultSettings();
 }
 
@@ -45,6 +50,7 @@ RayTracer::~RayTracer()
 void RayTracer::SetDefaultSettings()
 {
 	int max_depth = 60;
+	int RouletteDepth = 3;
 	float Sensor_Size = 100.0;
 	float Focal_Length = 35.0;
 	float Focus_Dist = 1.0;
@@ -56,6 +62,8 @@ void RayTracer::SetDefaultSettings()
 	float SunAzimuthal = 0.0;
 	float SkyVariation = 0.2;
 
+	float NoiseThreshold = 0.0;
+
 	float gamma = 2.2;
 	float exposure = 1.5;
 
@@ -65,76 +73,101 @@ void RayTracer::SetDefaultSettings()
 	Setting(RT_Setting::Sun_Azimuthal, glm::radians(SunAzimuthal));
 	Setting(RT_Setting::Sky_Variation, SkyVariation);
 	Setting(RT_Setting::Max_Depth, max_depth);
+	Setting(RT_Setting::Roulette_Depth, RouletteDepth);
 	Setting(RT_Setting::Sensor_Size, Sensor_Size / 1000.0);
 	Setting(RT_Setting::Focal_Length, Focal_Length / 1000.0);
 	Setting(RT_Setting::Focus_Dist, Focus_Dist);
 	Setting(RT_Setting::F_Stop, F_Stop);
 	Setting(PostProcess_Setting::Gamma, gamma);
 	Setting(PostProcess_Setting::Exposure, exposure);
+	SetNoiseThreshold(NoiseThreshold);
 }
 
+//The sample time measured so far is scaled to the new pixel count rather than measured again, see Navigation
 void RayTracer::FramebufferReSize(const int& Width, const int& Height)
 {
+	const double PixelRatio = ((double)Width * Height) / ((double)m_FramebufferWidth * m_FramebufferHeight);
 	m_FramebufferWidth = Width;
 	m_FramebufferHeight = Height;
 	m_RenderFB.ReSize(m_FramebufferWidth, m_FramebufferHeight);
-	m_AccumulationFB.ReSize(m_FramebufferWidth, m_FramebufferHeight);
+	m_AccumulationFB[0].ReSize(m_FramebufferWidth, m_FramebufferHeight);
+	m_AccumulationFB[1].ReSize(m_FramebufferWidth, m_FramebufferHeight);
 	const float AspectRatio = (float)Width / (float)Height;
 	m_RTShader.SetUniform("AspectRatio", AspectRatio);
 	m_RTShader.SetUniform("FramebufferWidth", m_FramebufferWidth);
 	m_RTShader.SetUniform("FramebufferHeight", m_FramebufferHeight);
+
+	m_PassTimer.Discard();
+	m_SampleTime *= PixelRatio;
+	m_AveragedSample[0] = m_AveragedSample[1] = -1;
 }
 
 void RayTracer::AddToBuffer(const std::string& name, const Sphere& Sphere)
 {
-	const auto& found = m_SphereIndexMap.find(name);
-	if (found != m_SphereIndexMap.end())
+	const auto& found = m_SphereHandleMap.find(name);
+	if (found != m_SphereHandleMap.end())
 	{
 		std::println("Attempting to add Sphere {}, already exists, try using SwapBufferObject instead", name);
 		return;
 	}
 
-	m_SphereList.push_back(Sphere);
-	m_SphereIndexMap[name] = m_SphereList.size() - 1;
+	const glm::vec3 Position = glm::vec3(Sphere.Position.x, Sphere.Position.y, Sphere.Position.z);
+	m_SphereHandleMap[name] = m_Spheres.Add(Position, Sphere.Radius, ResolveMaterial(name, Sphere));
+	const bool LightsChanged = m_Lights.SetSphere(m_Spheres, m_Spheres.Slot(m_SphereHandleMap[name]));
 
 	if (!m_Accumulating)
 		return;
 
-	m_RTShader.AddToLookUp("ModelCount", m_SphereList.size());
-	m_RTShader.ReCompile();
-	UploadSphere(m_SphereList.size() - 1);
+	if (LightsChanged)
+		LoadLightBuffer();
+
+	UpdateSphereLayout();
 	ResetAccumulation();
 }
 
 void RayTracer::SwapBufferObject(const std::string& name, const Sphere& Sphere)
 {
-	const auto& found = m_SphereIndexMap.find(name);
-	if (found == m_SphereIndexMap.end())
+	const auto& found = m_SphereHandleMap.find(name);
+	if (found == m_SphereHandleMap.end())
 	{
 		std::println("Attempting to Swap Object {}, does not exist, try AddToBuffer instead", name);
 		return;
 	}
 
-	int index = found->second;
-	m_SphereList.at(index) = Sphere;
+	const glm::vec3 Position = glm::vec3(Sphere.Position.x, Sphere.Position.y, Sphere.Position.z);
+	m_Spheres.Set(found->second, Position, Sphere.Radius, ResolveMaterial(name, Sphere));
+	const bool LightsChanged = m_Lights.SetSphere(m_Spheres, m_Spheres.Slot(found->second));
 
 	if (!m_Accumulating)
 		return;
 
-	UploadSphere(index);
+	UpdateBlackHoleClearRadius();
+
+	if (LightsChanged)
+		LoadLightBuffer();
+
+	else
+		UpdateLight(m_Spheres.Slot(found->second));
+
+	if (m_UseBVH)
+		RefitBVH(m_Spheres.Slot(found->second));
+
+	else
+		UploadSphere(m_Spheres.Slot(found->second));
+
 	ResetAccumulation();
 }
 
 void RayTracer::ClearBuffer()
 {
-	m_SphereList.clear();
-	m_SphereIndexMap.clear();
+	m_Spheres.Clear();
+	m_SphereHandleMap.clear();
+	m_Lights.Clear();
 
 	if (!m_Accumulating)
 		return;
 
-	m_RTShader.AddToLookUp("ModelCount", 1);
-	m_RTShader.ReCompile();
+	UpdateSphereLayout();
 	ResetAccumulation();
 }
 
@@ -149,6 +182,7 @@ void RayTracer::AddMaterial(const std::string& name, const Material& material)
 
 	m_MaterialList.push_back(material);
 	m_MaterialIndexMap[name] = m_MaterialList.size() - 1;
+	const bool LightsChanged = m_Lights.SetMaterial(m_Spheres, m_MaterialList.size() - 1, material.Emission != 0.0f);
 
 	if (!m_Accumulating)
 		return;
@@ -156,6 +190,10 @@ void RayTracer::AddMaterial(const std::string& name, const Material& material)
 	m_RTShader.AddToLookUp("MaterialCount", m_MaterialList.size());
 	m_RTShader.ReCompile();
 	UploadMaterial(m_MaterialList.size() - 1);
+
+	if (LightsChanged || material.Emission != 0.0f)
+		LoadLightBuffer();
+
 	ResetAccumulation();
 }
 
@@ -170,11 +208,16 @@ void RayTracer::SwapMaterial(const std::string& name, const Material& material)
 
 	int index = found->second;
 	m_MaterialList.at(index) = material;
+	const bool LightsChanged = m_Lights.SetMaterial(m_Spheres, index, material.Emission != 0.0f);
 
 	if (!m_Accumulating)
 		return;
 
 	UploadMaterial(index);
+
+	if (LightsChanged || material.Emission != 0.0f)
+		LoadLightBuffer();
+
 	ResetAccumulation();
 }
 
@@ -182,10 +225,13 @@ void RayTracer::ClearMaterials()
 {
 	m_MaterialList.clear();
 	m_MaterialIndexMap.clear();
+	m_Lights.Build(m_Spheres, std::vector<bool>());
 
 	if (!m_Accumulating)
 		return;
 
+	LoadLightBuffer();
+
 	m_RTShader.AddToLookUp("MaterialCount", 1);
 	m_RTShader.ReCompile();
 	ResetAccumulation();
@@ -197,39 +243,209 @@ void RayTracer::Draw() const
 	glDrawElements(GL_TRIANGLES, m_WindowIB.GetCount(), GL_UNSIGNED_INT, nullptr);
 }
 
-void RayTracer::Clear(const float& Red, const float& Green, const float& Blue) const
+void RayTracer::Clear(const float& Red, const float& Green, const float& Blue, const float& Alpha) const
 {
-	glClearColor(Red, Green, Blue, 1.0f);
+	glClearColor(Red, Green, Blue, Alpha);
 	glClear(GL_COLOR_BUFFER_BIT);
 }
 
+int RayTracer::ResolveMaterial(const std::string& name, const Sphere& Sphere) const
+{
+	const auto& found = m_MaterialIndexMap.find(Sphere.MaterialName);
+	if (found == m_MaterialIndexMap.end())
+	{
+		std::println("Sphere {} has material {}, does not exist!", name, Sphere.MaterialName);
+		return 0;
+	}
+
+	return found->second;
+}
+
 void RayTracer::UploadSphere(const int& index) const
 {
 	std::string out = std::format("SphereList[{}]", std::to_string(index));
 
-	const Sphere& sphere = m_SphereList[index];
-	m_RTShader.SetFloat(out + ".Position", sphere.Position);
-	m_RTShader.SetFloat(out + ".Radius", sphere.Radius);
+	const glm::vec3 Position = m_Spheres.Position(index);
+	m_RTShader.SetFloat(out + ".Position", Position.x, Position.y, Position.z);
+	m_RTShader.SetFloat(out + ".Radius", m_Spheres.Radius(index));
+	m_RTShader.SetInt(out + ".MatIndex", m_Spheres.MaterialIndex(index));
+}
 
-	const auto& found = m_MaterialIndexMap.find(sphere.MaterialName);
-	if (found == m_MaterialIndexMap.end())
-	{
-		for (auto& [name, sphereindex] : m_SphereIndexMap)						//Cache the inverse map
-		{
-			if (sphereindex == index)
-				std::println("Sphere {} has material {}, does not exist!", name, sphere.MaterialName);
-		}
+void RayTracer::UploadSpheres()
+{
+	UpdateBlackHoleClearRadius();
+	LoadLightBuffer();
 
+	if (m_UseBVH)
+	{
+		UploadBVH();
 		return;
 	}
 
-	m_RTShader.SetInt(out + ".MatIndex", found->second);
+	for (size_t i = 0; i < m_Spheres.Size(); i++)
+		UploadSphere(i);
+}
+
+void RayTracer::UpdateSphereLayout()
+{
+	const bool UseBVH = m_Spheres.Size() >= BVHMinSpheres;
+	const size_t ModelCount = UseBVH ? 1 : std::max(m_Spheres.Size(), (size_t)1);
+
+	if (UseBVH != m_UseBVH || ModelCount != m_ModelCount)
+	{
+		m_UseBVH = UseBVH;
+		m_ModelCount = ModelCount;
+
+		m_RTShader.AddToLookUp("UseBVH", m_UseBVH);
+		m_RTShader.AddToLookUp("ModelCount", m_ModelCount);
+		m_RTShader.ReCompile();
+		UploadMaterials();
+	}
+
+	UploadSpheres();
 }
 
-void RayTracer::UploadSpheres() const
+//Spheres go up in leaf order with the material index and slot behind each one, as unsigned texels so the
+//integer fields can't get flushed as denormal floats
+static void PackSphere(const SphereStore& spheres, const uint32_t& slot, uint32_t* texels)
 {
-	for (size_t i = 0; i < m_SphereList.size(); i++)
-		UploadSphere(i);
+	const glm::vec3 Position = spheres.Position(slot);
+	texels[0] = std::bit_cast<uint32_t>(Position.x);
+	texels[1] = std::bit_cast<uint32_t>(Position.y);
+	texels[2] = std::bit_cast<uint32_t>(Position.z);
+	texels[3] = std::bit_cast<uint32_t>(spheres.Radius(slot));
+	texels[4] = (uint32_t)spheres.MaterialIndex(slot);
+	texels[5] = slot;
+	texels[6] = 0;
+	texels[7] = 0;
+}
+
+void RayTracer::UploadBVH()
+{
+	CancelBVHRebuild();
+	m_BVH.Build(m_Spheres);
+	LoadBVHBuffers();
+}
+
+void RayTracer::LoadBVHBuffers()
+{
+	const std::vector<BVHNode>& nodes = m_BVH.GetNodes();
+	const std::vector<uint32_t>& primitives = m_BVH.GetPrimitives();
+
+	std::vector<uint32_t> spheres(8 * primitives.size());
+	for (size_t i = 0; i < primitives.size(); i++)
+		PackSphere(m_Spheres, primitives[i], &spheres[8 * i]);
+
+	m_BVHNodeBuffer.Load(nodes.data(), nodes.size() * sizeof(BVHNode), GL_RGBA32UI);
+	m_BVHSphereBuffer.Load(spheres.data(), spheres.size() * sizeof(uint32_t), GL_RGBA32UI);
+}
+
+//Only the moved sphere and the boxes on its path to the root are touched, on the host and on the GPU
+void RayTracer::RefitBVH(const size_t& slot)
+{
+	m_ChangedBVHNodes.clear();
+	m_BVH.Refit(m_Spheres, slot, m_ChangedBVHNodes);
+
+	const std::vector<BVHNode>& nodes = m_BVH.GetNodes();
+	for (const uint32_t& index : m_ChangedBVHNodes)
+		m_BVHNodeBuffer.Update(index * sizeof(BVHNode), &nodes[index], sizeof(BVHNode));
+
+	uint32_t texels[8];
+	PackSphere(m_Spheres, (uint32_t)slot, texels);
+	m_BVHSphereBuffer.Update(m_BVH.EntryOf(slot) * sizeof(texels), texels, sizeof(texels));
+
+	if (m_BVHRebuild.valid())
+		m_EditedDuringRebuild.push_back(slot);
+
+	else if (m_BVH.Degraded())
+		StartBVHRebuild();
+}
+
+//Refitting keeps the topology of the original build, once the boxes overlap too much a fresh tree is built off the main thread
+void RayTracer::StartBVHRebuild()
+{
+	m_EditedDuringRebuild.clear();
+	m_BVHRebuild = std::async(std::launch::async, [spheres = m_Spheres]()
+	{
+		SphereBVH bvh;
+		bvh.Build(spheres);
+		return bvh;
+	});
+}
+
+void RayTracer::PollBVHRebuild()
+{
+	if (!m_BVHRebuild.valid() || m_BVHRebuild.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+		return;
+
+	m_BVH = m_BVHRebuild.get();
+
+	//The new tree was built from a copy, bring over whatever moved since
+	m_ChangedBVHNodes.clear();
+	for (const size_t& slot : m_EditedDuringRebuild)
+		m_BVH.Refit(m_Spheres, slot, m_ChangedBVHNodes);
+
+	m_EditedDuringRebuild.clear();
+	LoadBVHBuffers();
+}
+
+void RayTracer::CancelBVHRebuild()
+{
+	if (m_BVHRebuild.valid())
+		m_BVHRebuild.wait();
+
+	m_BVHRebuild = std::future<SphereBVH>();
+	m_EditedDuringRebuild.clear();
+}
+
+//Emissive spheres go up in the order of the light list, packed like the BVH leaf entries, along with the light tree
+//and the leaf of every slot so emissive hits can retrace the pick
+void RayTracer::LoadLightBuffer()
+{
+	const std::vector<uint32_t>& slots = m_Lights.GetSlots();
+	std::vector<uint32_t> lights(8 * slots.size());
+	for (size_t i = 0; i < slots.size(); i++)
+		PackSphere(m_Spheres, slots[i], &lights[8 * i]);
+
+	m_LightTree.Build(m_Spheres, m_Lights, MaterialRadiance());
+	const std::vector<LightNode>& nodes = m_LightTree.GetNodes();
+
+	std::vector<int> leaves(std::max(m_Spheres.Size(), (size_t)1), -1);
+	for (size_t i = 0; i < slots.size(); i++)
+		leaves[slots[i]] = (int)m_LightTree.LeafOf(i);
+
+	m_LightBuffer.Load(lights.data(), lights.size() * sizeof(uint32_t), GL_RGBA32UI);
+	m_LightTreeBuffer.Load(nodes.data(), nodes.size() * sizeof(LightNode), GL_RGBA32UI);
+	m_LightLeafBuffer.Load(leaves.data(), leaves.size() * sizeof(int), GL_R32I);
+	m_RTShader.SetUniform("LightCount", (int)slots.size());
+}
+
+//A light that moved or changed size keeps its place in the list, only its leaf and the nodes above it are refit
+void RayTracer::UpdateLight(const size_t& slot)
+{
+	const int light = m_Lights.LightOf(slot);
+	if (light < 0)
+		return;
+
+	uint32_t texels[8];
+	PackSphere(m_Spheres, (uint32_t)slot, texels);
+	m_LightBuffer.Update(light * sizeof(texels), texels, sizeof(texels));
+
+	m_ChangedLightNodes.clear();
+	m_LightTree.Refit(m_Spheres, m_Lights, light, m_ChangedLightNodes);
+
+	const std::vector<LightNode>& nodes = m_LightTree.GetNodes();
+	for (const uint32_t& index : m_ChangedLightNodes)
+		m_LightTreeBuffer.Update(index * sizeof(LightNode), &nodes[index], sizeof(LightNode));
+}
+
+std::vector<float> RayTracer::MaterialRadiance() const
+{
+	std::vector<float> radiance;
+	for (const Material& material : m_MaterialList)
+		radiance.push_back(LightTree::Luminance(glm::vec3(material.Albedo.x, material.Albedo.y, material.Albedo.z)) * material.Emission);
+
+	return radiance;
 }
 
 void RayTracer::UploadMaterial(const int& index) const
@@ -272,22 +488,50 @@ void RayTracer::StartAccumulation(const unsigned int& RenderSlot, const unsigned
 	m_AccumulationTexSlot = AccumulationSlot;
 
 	m_RenderFB.ReSize(m_FramebufferWidth, m_FramebufferHeight);
-	m_AccumulationFB.ReSize(m_FramebufferWidth, m_FramebufferHeight);
+	m_AccumulationFB[0].ReSize(m_FramebufferWidth, m_FramebufferHeight);
+	m_AccumulationFB[1].ReSize(m_FramebufferWidth, m_FramebufferHeight);
 
 	m_AccumulationShader.SetUniform("CurrentSampleImage", m_RenderTexSlot);
+	m_AccumulationShader.SetUniform("CurrentMoments", m_PassMomentTexSlot);
 	m_AccumulationShader.SetUniform("Accumulated", m_AccumulationTexSlot);
+	m_AccumulationShader.SetUniform("AccumulatedMoments", m_MomentTexSlot);
+	m_AccumulationShader.SetUniform("CurrentAlbedo", m_AOVTexSlot);
+	m_AccumulationShader.SetUniform("CurrentNormal", m_AOVTexSlot + 1);
+	m_AccumulationShader.SetUniform("CurrentIds", m_AOVTexSlot + 2);
+	m_AccumulationShader.SetUniform("AccumulatedAlbedo", m_AccumulatedAOVTexSlot);
+	m_AccumulationShader.SetUniform("AccumulatedNormal", m_AccumulatedAOVTexSlot + 1);
+	m_AccumulationShader.SetUniform("AccumulatedIds", m_AccumulatedAOVTexSlot + 2);
 
 	m_PostProcessShader.SetUniform("Image", m_AccumulationTexSlot);
-
-	m_RTShader.AddToLookUp("ModelCount", m_SphereList.size());
+	m_PostProcessShader.SetUniform("Moments", m_MomentTexSlot);
+	m_PostProcessShader.SetUniform("AOVAlbedo", m_AccumulatedAOVTexSlot);
+	m_PostProcessShader.SetUniform("AOVNormal", m_AccumulatedAOVTexSlot + 1);
+	m_PostProcessShader.SetUniform("AOVIds", m_AccumulatedAOVTexSlot + 2);
+
+	m_RTShader.SetUniform("BVHNodes", m_BVHNodeTexSlot);
+	m_RTShader.SetUniform("BVHSpheres", m_BVHSphereTexSlot);
+	m_RTShader.SetUniform("DeflectionAngles", m_DeflectionTexSlot);
+	m_RTShader.SetUniform("SkyTexture", m_SkyTexSlot);
+	m_RTShader.SetUniform("LightSpheres", m_LightTexSlot);
+	m_RTShader.SetUniform("LightTreeNodes", m_LightTreeTexSlot);
+	m_RTShader.SetUniform("LightLeaves", m_LightLeafTexSlot);
+	m_RTShader.SetUniform("BlueNoiseRanks", m_BlueNoiseTexSlot);
+	m_RTShader.SetUniform("PixelMoments", m_MomentTexSlot);
+
+	m_UseBVH = m_Spheres.Size() >= BVHMinSpheres;
+	m_ModelCount = m_UseBVH ? 1 : std::max(m_Spheres.Size(), (size_t)1);
+	m_RTShader.AddToLookUp("UseBVH", m_UseBVH);
+	m_RTShader.AddToLookUp("ModelCount", m_ModelCount);
 	m_RTShader.AddToLookUp("MaterialCount", m_MaterialList.size());
 	m_RTShader.ReCompile();
 	UploadMaterials();
 	UploadSpheres();
+	ResetPassTuning();
 	ResetAccumulation();
 }
 
-void RayTracer::Accumulate()
+//One pass of up to MaxSamples samples per pixel, see SetSamplesPerPass
+void RayTracer::Accumulate(const int& MaxSamples)
 {
 	if (!m_Accumulating)
 	{
@@ -297,17 +541,92 @@ void RayTracer::Accumulate()
 
 	glViewport(0, 0, m_FramebufferWidth, m_FramebufferHeight);
 
+	if (m_UseBVH)
+	{
+		PollBVHRebuild();
+		m_BVHNodeBuffer.Bind(m_BVHNodeTexSlot);
+		m_BVHSphereBuffer.Bind(m_BVHSphereTexSlot);
+	}
+
+	m_DeflectionBuffer.Bind(m_DeflectionTexSlot);
+	m_SkyTexture.Bind(m_SkyTexSlot);
+	m_LightBuffer.Bind(m_LightTexSlot);
+	m_LightTreeBuffer.Bind(m_LightTreeTexSlot);
+	m_LightLeafBuffer.Bind(m_LightLeafTexSlot);
+	m_BlueNoiseBuffer.Bind(m_BlueNoiseTexSlot);
+
+	const Framebuffer& accumulated = m_AccumulationFB[m_Front];
+	const Framebuffer& target = m_AccumulationFB[1 - m_Front];
+	if (m_NoiseThreshold > 0.0f)
+		accumulated.GenerateMipmaps(1, m_MomentTexSlot);
+
+	else
+		accumulated.BindAttachment(1, m_MomentTexSlot);
+
+	TunePassSamples();
+	const int samples = std::clamp(MaxSamples, 1, m_PassSamples);
+	const bool timed = m_PassTimer.Begin(samples);
+
 	m_RenderFB.Bind(m_RenderTexSlot);
-	m_RTShader.SetUniform("CurrentSample", m_CurrentSample);
+	m_RTShader.SetUniform("CurrentSample", m_CurrentSample + (int)m_SampleOffset);
+	m_RTShader.SetUniform("SamplesPerPass", samples);
 	Render();
 
-	m_AccumulationFB.Bind(m_AccumulationTexSlot);
-	m_AccumulationShader.SetUniform("CurrentSample", (float)m_CurrentSample);
+	target.Bind(m_AccumulationTexSlot);
+	accumulated.BindAttachment(0, m_AccumulationTexSlot);
+	m_RenderFB.BindAttachment(1, m_PassMomentTexSlot);
+	if (m_WriteAOVs)
+	{
+		for (int i = 0; i < 3; i++)
+		{
+			m_RenderFB.BindAttachment(i + 2, m_AOVTexSlot + i);
+			accumulated.BindAttachment(i + 2, m_AccumulatedAOVTexSlot + i);
+		}
+	}
+
 	m_AccumulationShader.Use();
 	Draw();
-	m_AccumulationFB.UnBind();
+	target.UnBind();
+
+	if (timed)
+		m_PassTimer.End();
+
+	m_Front = 1 - m_Front;
+	m_CurrentSample += samples;
+}
+
+//Picks the samples of the next pass from the GPU time of the passes before it, so that a pass takes about m_PassTime
+//whatever a sample costs. The passes are timed whole, the accumulation draw is counted against their samples
+void RayTracer::TunePassSamples()
+{
+	double milliseconds;
+	int samples;
+	while (m_PassTimer.Result(milliseconds, samples))
+	{
+		const double SampleTime = milliseconds / (double)samples;
+		m_SampleTime = m_SampleTime > 0.0 ? 0.75 * m_SampleTime + 0.25 * SampleTime : SampleTime;
+	}
+
+	if (m_SamplesPerPass > 0)
+	{
+		m_PassSamples = m_SamplesPerPass;
+		return;
+	}
+
+	if (m_SampleTime <= 0.0)
+		return;
 
-	m_CurrentSample++;
+	//Grows by at most twice per pass, the estimate lags behind the passes still in flight
+	const int fit = (int)std::min((double)m_PassTime / m_SampleTime, (double)MaxSamplesPerPass);
+	m_PassSamples = std::clamp(fit, 1, 2 * m_PassSamples);
+}
+
+//The cost of a sample changes with the shader and the resolution, the old measurements don't carry over
+void RayTracer::ResetPassTuning()
+{
+	m_PassTimer.Discard();
+	m_SampleTime = 0.0;
+	m_PassSamples = m_SamplesPerPass > 0 ? m_SamplesPerPass : 1;
 }
 
 void RayTracer::ResetAccumulation()
@@ -319,13 +638,33 @@ void RayTracer::ResetAccumulation()
 	}
 
 	m_CurrentSample = 0;
-	m_AccumulationFB.Bind(m_AccumulationTexSlot);
-	Clear();
-	m_AccumulationFB.UnBind();
+	m_DenoisedSample = -1;
+	m_AveragedSample[0] = m_AveragedSample[1] = -1;
+	m_AccumulationStart = std::chrono::steady_clock::now();
+	m_AccumulationFB[m_Front].Bind(m_AccumulationTexSlot);
+	Clear(0.0f, 0.0f, 0.0f, 0.0f);													//Every channel is a sum, alpha included
+	m_AccumulationFB[m_Front].UnBind();
 }
 
 void RayTracer::PostProcess()
 {
+	const bool denoised = m_Denoise && m_CurrentSample > 0;
+	if (denoised)
+	{
+		Denoise();
+		m_DenoisedTexture.Bind(m_DenoisedTexSlot);
+	}
+
+	m_AccumulationFB[m_Front].BindAttachment(0, m_AccumulationTexSlot);
+	m_AccumulationFB[m_Front].BindAttachment(1, m_MomentTexSlot);
+	if (m_WriteAOVs)
+	{
+		for (int i = 0; i < 3; i++)
+			m_AccumulationFB[m_Front].BindAttachment(i + 2, m_AccumulatedAOVTexSlot + i);
+	}
+
+	m_PostProcessShader.SetUniform("Image", denoised ? m_DenoisedTexSlot : m_AccumulationTexSlot);
+	m_PostProcessShader.SetUniform("DisplayedAOV", m_WriteAOVs ? (int)m_DisplayedAOV : 0);
 	m_RenderFB.Bind(m_RenderTexSlot);
 	m_PostProcessShader.Use();
 
@@ -333,6 +672,126 @@ void RayTracer::PostProcess()
 	m_RenderFB.UnBind();
 }
 
+//Reads the accumulation back, filters it on the CPU and uploads the result for PostProcess to show, as sums over the
+//samples of each pixel like the accumulation itself. Once per pass, the readback waits on the passes already queued
+void RayTracer::Denoise()
+{
+	if (m_DenoisedSample == m_CurrentSample)
+		return;
+
+	const AccumulationBuffer accumulation = ReadAccumulation();
+	const size_t count = accumulation.Size();
+	std::vector<glm::vec3> color(count), albedo(count), normal(count);
+	std::vector<float> depth(count), variance(count);
+	for (size_t i = 0; i < count; i++)
+	{
+		color[i] = accumulation.Mean(i);
+		albedo[i] = accumulation.Albedo(i);
+		normal[i] = accumulation.Normal(i);
+		depth[i] = accumulation.Depth(i);
+		variance[i] = accumulation.Variance(i);
+	}
+
+	DenoiseInput input;
+	input.Width = m_FramebufferWidth;
+	input.Height = m_FramebufferHeight;
+	input.Color = color.data();
+	input.Albedo = albedo.data();
+	input.Normal = normal.data();
+	input.Depth = depth.data();
+	input.Variance = variance.data();
+
+	if (!m_DenoisePool)
+		m_DenoisePool = std::make_unique<ThreadPool>();
+
+	const std::vector<glm::vec3>& denoised = m_Denoiser.Denoise(*m_DenoisePool, input);
+	std::vector<float> pixels(4 * count);
+	for (size_t i = 0; i < count; i++)
+	{
+		const float n = (float)std::max(accumulation.Samples(i), 1u);
+		pixels[4 * i] = denoised[i].x * n;
+		pixels[4 * i + 1] = denoised[i].y * n;
+		pixels[4 * i + 2] = denoised[i].z * n;
+		pixels[4 * i + 3] = 1.0f;
+	}
+
+	m_DenoisedTexture.Load(pixels.data(), m_FramebufferWidth, m_FramebufferHeight);
+	m_DenoisedSample = m_CurrentSample;
+}
+
+//The sums behind the accumulated image and, when they're written, the AOVs. Rows bottom up like GetRenderedImage
+AccumulationBuffer RayTracer::ReadAccumulation() const
+{
+	const Framebuffer& accumulated = m_AccumulationFB[m_Front];
+	const std::vector<glm::vec4> color = accumulated.Read(0, m_AccumulationTexSlot);
+	const std::vector<glm::vec4> moments = accumulated.Read(1, m_MomentTexSlot);
+
+	AccumulationBuffer buffer;
+	buffer.Resize(m_FramebufferWidth, m_FramebufferHeight);
+	buffer.SetAOVs(m_WriteAOVs);
+	for (size_t i = 0; i < color.size(); i++)
+		buffer.SetSums(i, glm::vec3(color[i]), moments[i].x, (uint32_t)moments[i].y);
+
+	if (!m_WriteAOVs)
+		return buffer;
+
+	const std::vector<glm::vec4> albedo = accumulated.Read(2, m_AccumulatedAOVTexSlot);
+	const std::vector<glm::vec4> normal = accumulated.Read(3, m_AccumulatedAOVTexSlot + 1);
+	const std::vector<glm::vec4> ids = accumulated.Read(4, m_AccumulatedAOVTexSlot + 2);
+	for (size_t i = 0; i < color.size(); i++)
+		buffer.SetAOVSums(i, glm::vec3(albedo[i]), glm::vec3(normal[i]), normal[i].w, (int)ids[i].x, (int)ids[i].y);
+
+	return buffer;
+}
+
+//Adds the samples of a buffer rendered elsewhere to the accumulation, see AccumulationBuffer::Merge. The path lengths
+//and which pixels the last pass traced stay those of the passes rendered here
+bool RayTracer::Merge(const AccumulationBuffer& other)
+{
+	if (!m_Accumulating)
+	{
+		std::println("Warning: Call to Merge without a call to StartAccumulation");
+		return false;
+	}
+
+	AccumulationBuffer merged = ReadAccumulation();
+	if (!merged.Merge(other))
+		return false;
+
+	const Framebuffer& accumulated = m_AccumulationFB[m_Front];
+	std::vector<glm::vec4> color = accumulated.Read(0, m_AccumulationTexSlot);
+	std::vector<glm::vec4> moments = accumulated.Read(1, m_MomentTexSlot);
+	//Path lengths aren't merged, the sums here are scaled so the average still describes the paths traced here
+	for (size_t i = 0; i < color.size(); i++)
+	{
+		const float PathLengths = moments[i].y > 0.0f ? color[i].w * (float)merged.Samples(i) / moments[i].y : 0.0f;
+		color[i] = glm::vec4(merged.ColorSum(i), PathLengths);
+		moments[i] = glm::vec4(merged.LuminanceSquareSum(i), (float)merged.Samples(i), merged.SquaredError(i), moments[i].w);
+	}
+
+	accumulated.Write(0, m_AccumulationTexSlot, color);
+	accumulated.Write(1, m_MomentTexSlot, moments);
+
+	if (m_WriteAOVs)
+	{
+		std::vector<glm::vec4> albedo(color.size()), normal(color.size()), ids(color.size());
+		for (size_t i = 0; i < color.size(); i++)
+		{
+			albedo[i] = glm::vec4(merged.AlbedoSum(i), (float)merged.Samples(i));
+			normal[i] = glm::vec4(merged.NormalSum(i), merged.DepthSum(i));
+			ids[i] = glm::vec4((float)merged.MaterialID(i), (float)merged.ObjectID(i), 0.0f, 1.0f);
+		}
+
+		accumulated.Write(2, m_AccumulatedAOVTexSlot, albedo);
+		accumulated.Write(3, m_AccumulatedAOVTexSlot + 1, normal);
+		accumulated.Write(4, m_AccumulatedAOVTexSlot + 2, ids);
+	}
+
+	m_DenoisedSample = -1;
+	m_AveragedSample[0] = m_AveragedSample[1] = -1;
+	return true;
+}
+
 unsigned char* RayTracer::GetRenderedImage() const
 {
 	unsigned char* Image = new unsigned char[3 * m_FramebufferWidth * m_FramebufferHeight];
@@ -347,6 +806,107 @@ unsigned int RayTracer::RenderedSamples() const
 	return m_CurrentSample;
 }
 
+//Samples the next pass will take
+int RayTracer::SamplesPerPass() const
+{
+	return m_PassSamples;
+}
+
+//GPU milliseconds a sample of the whole frame takes, its share of the accumulation draw included, 0 until a pass was
+//timed
+double RayTracer::SampleTime() const
+{
+	return m_SampleTime;
+}
+
+//Ray Trace.frag writes the segments of each path to alpha, so the accumulated alpha sums them per pixel
+float RayTracer::AveragePathLength() const
+{
+	if (m_CurrentSample == 0)
+		return 0.0f;
+
+	const float samples = Average(1).y;
+	return samples > 0.0f ? Average(0).w / samples : 0.0f;
+}
+
+//RMS over the image of the relative error of each pixel's mean, estimated from its own samples
+float RayTracer::RelativeError() const
+{
+	return m_CurrentSample > 1 ? std::sqrt(Average(1).z) : 1.0f;
+}
+
+//Fraction of the pixels traced in the last pass, the rest are in tiles below the noise threshold
+float RayTracer::ActivePixels() const
+{
+	return m_CurrentSample > 0 ? Average(1).w : 1.0f;
+}
+
+//Image average of an attachment of the accumulation. Reading it back waits on the passes already queued, so it's read
+//once per pass count and the statistics asked for in between share it
+glm::vec4 RayTracer::Average(const int& attachment) const
+{
+	if (m_AveragedSample[attachment] != m_CurrentSample)
+	{
+		m_Averages[attachment] = m_AccumulationFB[m_Front].Average(attachment == 0 ? m_AccumulationTexSlot : m_MomentTexSlot, attachment);
+		m_AveragedSample[attachment] = m_CurrentSample;
+	}
+
+	return m_Averages[attachment];
+}
+
+float RayTracer::RenderTime() const
+{
+	return std::chrono::duration<float>(std::chrono::steady_clock::now() - m_AccumulationStart).count();
+}
+
+//Done once the image is below the quality target, every tile is below the noise threshold or the time limit is up
+bool RayTracer::Finished() const
+{
+	if (!m_Accumulating || m_CurrentSample < AdaptiveMinSamples)
+		return false;
+
+	if (m_TimeLimit > 0.0f && RenderTime() >= m_TimeLimit)
+		return true;
+
+	if (m_QualityTarget <= 0.0f && m_NoiseThreshold <= 0.0f)
+		return false;
+
+	const glm::vec4 moments = Average(1);
+	return (m_QualityTarget > 0.0f && std::sqrt(moments.z) < m_QualityTarget) || (m_NoiseThreshold > 0.0f && moments.w == 0.0f);
+}
+
+//Accumulated AOV, AOVChannelMap.at(aov) floats per pixel with rows bottom up like GetRenderedImage
+std::vector<float> RayTracer::GetAOV(const AOV& aov) const
+{
+	if (aov != AOV::Color && !m_WriteAOVs)
+	{
+		std::println("Attempting to read AOV {}, AOVs are not being written, try SetAOVs first", aov);
+		return std::vector<float>();
+	}
+
+	const AccumulationBuffer accumulation = ReadAccumulation();
+	const size_t count = accumulation.Size();
+	std::vector<float> values(count * AOVChannelMap.at(aov));
+	for (size_t i = 0; i < count; i++)
+	{
+		if (aov == AOV::Color || aov == AOV::Albedo || aov == AOV::Normal)
+		{
+			const glm::vec3 value = aov == AOV::Color ? accumulation.Mean(i) : aov == AOV::Albedo ? accumulation.Albedo(i) : accumulation.Normal(i);
+			values[3 * i] = value.x;
+			values[3 * i + 1] = value.y;
+			values[3 * i + 2] = value.z;
+		}
+
+		else if (aov == AOV::Depth)
+			values[i] = accumulation.Depth(i);
+
+		else
+			values[i] = (float)(aov == AOV::MaterialID ? accumulation.MaterialID(i) : accumulation.ObjectID(i));
+	}
+
+	return values;
+}
+
 int RayTracer::GetFramebufferWidth() const
 {
 	return m_FramebufferWidth;
@@ -365,19 +925,154 @@ void RayTracer::SetRenderBlackHole(const bool& value)
 	UploadSpheres();
 }
 
+void RayTracer::SetSampler(const SamplerType& type)
+{
+	if (type == m_Sampler)
+		return;
+
+	m_Sampler = type;
+	m_RTShader.AddToLookUp("SamplerType", (int)type);
+	m_RTShader.ReCompile();
+	UploadMaterials();
+	UploadSpheres();
+}
+
+//Tiles whose RMS relative error drops below threshold stop being traced, 0 keeps tracing every pixel
+void RayTracer::SetNoiseThreshold(const float& threshold)
+{
+	m_NoiseThreshold = std::max(threshold, 0.0f);
+	m_RTShader.SetUniform("NoiseThreshold", m_NoiseThreshold);
+}
+
+void RayTracer::SetQualityTarget(const float& target)
+{
+	m_QualityTarget = std::max(target, 0.0f);
+}
+
+void RayTracer::SetTimeLimit(const float& seconds)
+{
+	m_TimeLimit = std::max(seconds, 0.0f);
+}
+
+//Adds the AOV attachments to both framebuffers and recompiles the ray and accumulation shaders to write them. Off,
+//the shaders compile without the extra outputs and the framebuffers without the extra textures. The denoiser is
+//guided by the AOVs, they stay on while it is
+void RayTracer::SetAOVs(const bool& enabled)
+{
+	if ((enabled || m_Denoise) == m_WriteAOVs)
+		return;
+
+	m_WriteAOVs = enabled || m_Denoise;
+	m_RenderFB.SetAttachments(m_WriteAOVs ? 5 : 2);
+	m_AccumulationFB[0].SetAttachments(m_WriteAOVs ? 5 : 2);
+	m_AccumulationFB[1].SetAttachments(m_WriteAOVs ? 5 : 2);
+
+	m_AccumulationShader.AddToLookUp("WriteAOVs", m_WriteAOVs);
+	m_AccumulationShader.ReCompile();
+	m_RTShader.AddToLookUp("WriteAOVs", m_WriteAOVs);
+	m_RTShader.ReCompile();
+	UploadMaterials();
+	UploadSpheres();
+
+	if (m_Accumulating)
+		ResetAccumulation();
+}
+
+//Shown by PostProcess in place of the image, as long as AOVs are being written
+void RayTracer::SetDisplayedAOV(const AOV& aov)
+{
+	m_DisplayedAOV = aov;
+}
+
+//Samples are drawn from index offset on, so renders merged together can each take their own range of them
+void RayTracer::SetSampleOffset(const unsigned int& offset)
+{
+	m_SampleOffset = offset;
+	if (m_Accumulating)
+		ResetAccumulation();
+}
+
+//Fixes the samples every pass takes, 0 goes back to tuning them to the pass time
+void RayTracer::SetSamplesPerPass(const int& samples)
+{
+	m_SamplesPerPass = std::clamp(samples, 0, MaxSamplesPerPass);
+	m_PassSamples = m_SamplesPerPass > 0 ? m_SamplesPerPass : m_PassSamples;
+}
+
+//GPU time a pass aims for while the samples per pass are tuned, longer passes waste less on the accumulation draw but
+//hold up whatever else the GPU draws
+void RayTracer::SetPassTime(const float& milliseconds)
+{
+	m_PassTime = std::max(milliseconds, 0.0f);
+}
+
+//PostProcess shows the denoised image in place of the accumulated one
+void RayTracer::SetDenoise(const bool& enabled)
+{
+	m_Denoise = enabled;
+	m_DenoisedSample = -1;
+	if (m_Denoise)
+		SetAOVs(true);
+}
+
 void RayTracer::SetBlackHolePosition(const Vec3& value)
 {
+	m_BlackHolePosition = glm::vec3(value.x, value.y, value.z);
 	m_RTShader.SetUniform("BlackHolePosition", value);
+	UpdateBlackHoleClearRadius();
+}
+
+//Lets the shader capture photons analytically while no sphere is closer to the hole than they are,
+//and skip the march altogether while no sphere reaches into the influence sphere
+void RayTracer::UpdateBlackHoleClearRadius() const
+{
+	const float ClearRadius = SphereIntersect::ClearRadius(m_Spheres, m_BlackHolePosition);
+	m_RTShader.SetUniform("BlackHoleClearRadius", ClearRadius);
+	m_RTShader.SetUniform("UseDeflection", (int)(!m_Deflection.Empty() && ClearRadius >= m_MaxInfluenceRadius));
+}
+
+void RayTracer::UpdateDeflectionTable()
+{
+	m_Deflection.Build(m_SchwarzschildRadius, m_MaxInfluenceRadius);
+
+	const std::vector<float>& angles = m_Deflection.GetAngles();
+	m_DeflectionBuffer.Load(angles.data(), angles.size() * sizeof(float), GL_R32F);
+	m_RTShader.SetUniform("DeflectionSize", (int)angles.size());
+	m_RTShader.SetUniform("DeflectionCriticalH", m_Deflection.CriticalH());
+	UpdateBlackHoleClearRadius();
+}
+
+//Rebakes the sky, the sun radius and intensity only scale the disk, which is still evaluated in the shader
+void RayTracer::UpdateSky(const RT_Setting& setting, const float& value)
+{
+	if (setting == RT_Setting::Sun_Altitude)
+		m_SunAltitude = value;
+
+	else if (setting == RT_Setting::Sun_Azimuthal)
+		m_SunAzimuthal = value;
+
+	else
+		m_SkyVariation = value;
+
+	m_Sky.Build(m_SunAltitude, m_SunAzimuthal, m_SkyVariation);
+	m_SkyTexture.Load(&m_Sky.GetTexels()[0].x, m_Sky.GetSize(), m_Sky.GetSize());
+
+	const glm::vec3 SunDirection = m_Sky.SunDirection();
+	m_RTShader.SetUniform("SunDirection", Vec3(SunDirection.x, SunDirection.y, SunDirection.z));
 }
 
 void RayTracer::SetBlackHoleRadius(const float& value)
 {
+	m_SchwarzschildRadius = value;
 	m_RTShader.SetUniform("SchwarzsRadius", value);
+	UpdateDeflectionTable();
 }
 
 void RayTracer::SetMaxInfluenceRadius(const float& value)
 {
+	m_MaxInfluenceRadius = value;
 	m_RTShader.SetUniform("MaxInfluenceRadius", value);
+	UpdateDeflectionTable();
 }
 
 void RayTracer::SetLightPathStepSize(const float& value)
@@ -422,6 +1117,7 @@ void RayTracer::LoadScene(const Scene& scene)
 	Setting(RT_Setting::Sun_Azimuthal, glm::radians(scene.m_SunAzimuthal));
 	Setting(RT_Setting::Sky_Variation, scene.m_SkyVariation);
 	Setting(RT_Setting::Max_Depth, scene.m_MaxDepth);
+	Setting(RT_Setting::Roulette_Depth, scene.m_RouletteDepth);
 	Setting(RT_Setting::Sensor_Size, scene.m_SensorSize / 1000.0);
 	Setting(RT_Setting::Focal_Length, scene.m_FocalLength / 1000.0);
 	Setting(RT_Setting::Focus_Dist, scene.m_FocusDist);
@@ -429,6 +1125,11 @@ void RayTracer::LoadScene(const Scene& scene)
 	Setting(PostProcess_Setting::Gamma, scene.m_Gamma);
 	Setting(PostProcess_Setting::Exposure, scene.m_Exposure);
 	SetRenderBlackHole(scene.RenderBlackHole);
+	SetSampler(scene.m_Sampler);
+	SetNoiseThreshold(scene.m_NoiseThreshold);
+	SetQualityTarget(scene.m_QualityTarget);
+	SetTimeLimit(scene.m_TimeLimit);
+	SetDenoise(scene.m_Denoise);
 	SetBlackHolePosition(scene.BlackHolePosition);
 	SetBlackHoleRadius(scene.SchwarzschildRadius);
 	SetMaxInfluenceRadius(scene.MaxInfluenceRadius);
@@ -3,6 +3,10 @@
 #include<vector>
 #include<iostream>
 #include <algorithm>
+#include <bit>
+#include <future>
+#include <chrono>
+#include <memory>
 
 #include "Shader.h"
 #include "VertexArray.h"
@@ -14,10 +18,23 @@
 #include "Camera.h"
 #include "Framebuffer.h"
 #include "Scene.h"
+#include "SphereStore.h"
+#include "BVH.h"
+#include "TextureBuffer.h"
+#include "DeflectionTable.h"
+#include "SkyTable.h"
+#include "Texture.h"
+#include "LightList.h"
+#include "LightTree.h"
+#include "Sampler.h"
+#include "AOV.h"
+#include "Denoiser.h"
+#include "AccumulationBuffer.h"
+#include "TimerQuery.h"
 
 enum class RT_Setting
 {
-	Max_Depth,
+	Max_Depth, Roulette_Depth,
 	Sun_Radius, Sun_Intensity, Sun_Altitude, Sun_Azimuthal, Sky_Variation,
 	Sensor_Size, Focal_Length, Focus_Dist, F_Stop
 };
@@ -35,6 +52,9 @@ struct std::formatter<RT_Setting> : std::formatter<std::string>
 		if(Setting == RT_Setting::Max_Depth)
 			return std::formatter<std::string>::format(std::format("{}", "Max_Depth"), ctx);
 
+		if (Setting == RT_Setting::Roulette_Depth)
+			return std::formatter<std::string>::format(std::format("{}", "Roulette_Depth"), ctx);
+
 		if (Setting == RT_Setting::Sun_Radius)
 			return std::formatter<std::string>::format(std::format("{}", "Sun_Radius"), ctx);
 
@@ -83,9 +103,12 @@ struct std::formatter<PostProcess_Setting> : std::formatter<std::string>
 	}
 };
 
+const int MaxSamplesPerPass = 64;												//Keeps a pass well short of driver watchdogs
+
 static const std::unordered_map<RT_Setting, std::string> SettingUniformMap =
 {
 	std::pair(RT_Setting::Max_Depth, "max_depth"),
+	std::pair(RT_Setting::Roulette_Depth, "RouletteDepth"),
 	std::pair(RT_Setting::Sun_Radius, "SunRadius"),
 	std::pair(RT_Setting::Sun_Intensity, "SunIntensity"),
 	std::pair(RT_Setting::Sun_Altitude, "SunAltitude"),
@@ -113,16 +136,36 @@ public:
 	void Draw() const;
 	void Render() const;
 	void StartAccumulation(const unsigned int& RenderSlot = 1, const unsigned int& AccumulationSlot = 2);
-	void Accumulate();
+	void Accumulate(const int& MaxSamples = INT32_MAX);
 	void ResetAccumulation();
 	void PostProcess();
 	unsigned char* GetRenderedImage() const;
-	void Clear(const float& Red = 0.0f, const float& Green = 0.0f, const float& Blue = 0.0f) const;
+	void Clear(const float& Red = 0.0f, const float& Green = 0.0f, const float& Blue = 0.0f, const float& Alpha = 1.0f) const;
 	unsigned int RenderedSamples() const;
+	int SamplesPerPass() const;
+	double SampleTime() const;
+	float AveragePathLength() const;
+	float RelativeError() const;
+	float ActivePixels() const;
+	float RenderTime() const;
+	bool Finished() const;
+	std::vector<float> GetAOV(const AOV& aov) const;
+	AccumulationBuffer ReadAccumulation() const;
+	bool Merge(const AccumulationBuffer& other);
 	int GetFramebufferWidth() const;
 	int GetFramebufferHeight() const;
 
 	void SetRenderBlackHole(const bool& value);
+	void SetSampler(const SamplerType& type);
+	void SetNoiseThreshold(const float& threshold);
+	void SetQualityTarget(const float& target);
+	void SetTimeLimit(const float& seconds);
+	void SetAOVs(const bool& enabled);
+	void SetDisplayedAOV(const AOV& aov);
+	void SetDenoise(const bool& enabled);
+	void SetSampleOffset(const unsigned int& offset);
+	void SetSamplesPerPass(const int& samples);
+	void SetPassTime(const float& milliseconds);
 	void SetBlackHolePosition(const Vec3& value);
 	void SetBlackHoleRadius(const float& value);
 	void SetMaxInfluenceRadius(const float& value);
@@ -150,6 +193,9 @@ public:
 		const std::string& name = SettingUniformMap.at(setting);
 		m_RTShader.SetUniform(name, value);
 
+		if (setting == RT_Setting::Sun_Altitude || setting == RT_Setting::Sun_Azimuthal || setting == RT_Setting::Sky_Variation)
+			UpdateSky(setting, (float)value);
+
 		if (!m_Accumulating)
 			return;
 
@@ -164,11 +210,30 @@ public:
 	}
 
 private:
+	int ResolveMaterial(const std::string& name, const Sphere& Sphere) const;
 	void UploadSphere(const int& index) const;
-	void UploadSpheres() const;
+	void UploadSpheres();
+	void UpdateSphereLayout();
+	void UploadBVH();
+	void LoadBVHBuffers();
+	void RefitBVH(const size_t& slot);
+	void StartBVHRebuild();
+	void PollBVHRebuild();
+	void CancelBVHRebuild();
+
+	void Denoise();
+	void TunePassSamples();
+	void ResetPassTuning();
+	glm::vec4 Average(const int& attachment) const;
 
 	void UploadMaterial(const int& index) const;
 	void UploadMaterials() const;
+	void UpdateBlackHoleClearRadius() const;
+	void UpdateDeflectionTable();
+	void UpdateSky(const RT_Setting& setting, const float& value);
+	void LoadLightBuffer();
+	void UpdateLight(const size_t& slot);
+	std::vector<float> MaterialRadiance() const;
 
 private:
 	mutable Shader m_RTShader = Shader("res/Ray Trace.glsl");
@@ -179,20 +244,86 @@ private:
 	VertexArray m_WindowVA;
 	Camera m_Camera;
 
-	Framebuffer m_RenderFB;
-	Framebuffer m_AccumulationFB;
+	Framebuffer m_RenderFB = Framebuffer(2);									//Sums of the samples of a pass, their moments, then their AOVs
+	Framebuffer m_AccumulationFB[2] = { Framebuffer(2), Framebuffer(2) };		//Sums of color and path length, the moments of Accumulator.glsl, then the AOVs
+	int m_Front = 0;															//The one holding the accumulation, passes write the other
 	bool m_Accumulating = false;
 
 	int m_RenderTexSlot;
 	int m_AccumulationTexSlot;
+	int m_BVHNodeTexSlot = 3;
+	int m_BVHSphereTexSlot = 4;
+	int m_DeflectionTexSlot = 5;
+	int m_SkyTexSlot = 6;
+	int m_LightTexSlot = 7;
+	int m_LightTreeTexSlot = 8;
+	int m_LightLeafTexSlot = 9;
+	int m_BlueNoiseTexSlot = 10;
+	int m_MomentTexSlot = 11;
+	int m_AOVTexSlot = 12;														//Albedo, normal and ids of the last pass, then the accumulated ones from 15
+	int m_AccumulatedAOVTexSlot = 15;
+	int m_DenoisedTexSlot = 18;
+	int m_PassMomentTexSlot = 19;
 	int m_FramebufferWidth;
 	int m_FramebufferHeight;
 
 	int m_CurrentSample = 0;
-
-	std::vector<Sphere> m_SphereList;
-	std::unordered_map<std::string, int> m_SphereIndexMap;
+	mutable glm::vec4 m_Averages[2];											//Of the color and moment attachments, see Average
+	mutable int m_AveragedSample[2] = { -1, -1 };								//Pass count they were read at, -1 once they're out of date
+	unsigned int m_SampleOffset = 0;
+	int m_SamplesPerPass = 0;													//0 tunes the samples of a pass to m_PassTime
+	int m_PassSamples = 1;
+	float m_PassTime = 12.0f;													//Milliseconds
+	double m_SampleTime = 0.0;													//Measured milliseconds per sample, 0 before the first
+	TimerQuery m_PassTimer;
+	float m_NoiseThreshold = 0.0f;
+	float m_QualityTarget = 0.0f;
+	float m_TimeLimit = 0.0f;
+	std::chrono::steady_clock::time_point m_AccumulationStart;
+
+	bool m_WriteAOVs = false;
+	AOV m_DisplayedAOV = AOV::Color;
+
+	bool m_Denoise = false;
+	Denoiser m_Denoiser;
+	std::unique_ptr<ThreadPool> m_DenoisePool;									//Made the first time the denoiser runs
+	Texture m_DenoisedTexture;
+	int m_DenoisedSample = -1;													//Pass count m_DenoisedTexture was filtered at, -1 once it's out of date
+
+	SphereStore m_Spheres;
+	std::unordered_map<std::string, SphereHandle> m_SphereHandleMap;
+
+	bool m_UseBVH = false;
+	size_t m_ModelCount = 1;
+	SphereBVH m_BVH;
+	TextureBuffer m_BVHNodeBuffer;
+	TextureBuffer m_BVHSphereBuffer;
+	std::vector<uint32_t> m_ChangedBVHNodes;
+	std::future<SphereBVH> m_BVHRebuild;
+	std::vector<size_t> m_EditedDuringRebuild;
 
 	std::vector<Material> m_MaterialList;
 	std::unordered_map<std::string, int> m_MaterialIndexMap;
+
+	glm::vec3 m_BlackHolePosition = glm::vec3(0.0f);
+	float m_SchwarzschildRadius = 0.0f;
+	float m_MaxInfluenceRadius = 0.0f;
+	DeflectionTable m_Deflection;
+	TextureBuffer m_DeflectionBuffer;
+
+	float m_SunAltitude = 0.0f;
+	float m_SunAzimuthal = 0.0f;
+	float m_SkyVariation = 0.0f;
+	SkyTable m_Sky;
+	Texture m_SkyTexture;
+
+	LightList m_Lights;
+	TextureBuffer m_LightBuffer;
+	LightTree m_LightTree;
+	TextureBuffer m_LightTreeBuffer;
+	TextureBuffer m_LightLeafBuffer;											//Leaf of every sphere slot, -1 for the ones that don't emit
+	std::vector<uint32_t> m_ChangedLightNodes;
+
+	SamplerType m_Sampler = SamplerType::Sobol;
+	TextureBuffer m_BlueNoiseBuffer;
 };
\ No newline at end of file
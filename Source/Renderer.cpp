@@ -48,6 +48,7 @@ void Renderer::SetRenderResolution(const int& ResolutionX, const int& Resolution
 {
 	float AspectRatio = (float)ResolutionX / (float)ResolutionY;
 	m_DisplayShader.SetUniform("RenderAspectRatio", AspectRatio);
+	m_DisplayShader.SetUniform("RenderResolution", Vec2(ResolutionX, ResolutionY));
 }
 
 void Renderer::SetDisplayImage(const int& Image)
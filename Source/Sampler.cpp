@@ -0,0 +1,206 @@
+#include "Sampler.h"
+
+#include <cmath>
+
+static uint32_t ReverseBits(uint32_t x)
+{
+	x = ((x >> 1) & 0x55555555u) | ((x & 0x55555555u) << 1);
+	x = ((x >> 2) & 0x33333333u) | ((x & 0x33333333u) << 2);
+	x = ((x >> 4) & 0x0F0F0F0Fu) | ((x & 0x0F0F0F0Fu) << 4);
+	x = ((x >> 8) & 0x00FF00FFu) | ((x & 0x00FF00FFu) << 8);
+	return (x >> 16) | (x << 16);
+}
+
+static uint32_t Hash(uint32_t x)
+{
+	x ^= x >> 16;
+	x *= 0x7FEB352Du;
+	x ^= x >> 15;
+	x *= 0x846CA68Bu;
+	x ^= x >> 16;
+	return x;
+}
+
+static uint32_t HashCombine(const uint32_t& seed, const uint32_t& value)
+{
+	return seed ^ (value + 0x9E3779B9u + (seed << 6) + (seed >> 2));
+}
+
+//Flips every bit depending on the ones below it, so on bit reversed values it is an Owen scramble in base 2
+static uint32_t LaineKarras(uint32_t x, const uint32_t& seed)
+{
+	x += seed;
+	x ^= x * 0x6C50B47Cu;
+	x ^= x * 0xB82F1E52u;
+	x ^= x * 0xC7AFE638u;
+	x ^= x * 0x8D22F6E6u;
+	return x;
+}
+
+//Generator matrix of the second Sobol dimension, the Pascal matrix mod 2, without a loop over the bits of the index.
+//Bit reversed like the first dimension, whose matrix is the identity
+static uint32_t Pascal(uint32_t x)
+{
+	x ^= (x & 0xAAAAAAAAu) >> 1;
+	x ^= (x & 0xCCCCCCCCu) >> 2;
+	x ^= (x & 0xF0F0F0F0u) >> 4;
+	x ^= (x & 0xFF00FF00u) >> 8;
+	x ^= (x & 0xFFFF0000u) >> 16;
+	return x;
+}
+
+//Top 24 bits, so the largest value stays below 1
+static float ToUnit(const uint32_t& x)
+{
+	return (float)(x >> 8) * (1.0f / 16777216.0f);
+}
+
+Sampler::Sampler(const SamplerType& type, const int& x, const int& y, const uint32_t& sample)
+	:m_Type(type), m_x(x), m_y(y), m_Index(sample), m_ReversedIndex(ReverseBits(sample))
+{
+	m_Seed = type == SamplerType::BlueNoise ? 0x5EED5EEDu : HashCombine(Hash((uint32_t)x), (uint32_t)y);
+}
+
+void Sampler::StartBounce(const int& depth)
+{
+	m_Base = CameraDimensions + (uint32_t)depth * BounceDimensions;
+}
+
+float Sampler::Get1D(const uint32_t& dimension) const
+{
+	const uint32_t pair = (m_Base + dimension) >> 1;
+	const uint32_t seed = HashCombine(m_Seed, pair);
+	return ToUnit(Draw(pair, seed, ShuffledIndex(seed), dimension & 1u));
+}
+
+glm::vec2 Sampler::Get2D(const uint32_t& dimension) const
+{
+	const uint32_t pair = (m_Base + dimension) >> 1;
+	const uint32_t seed = HashCombine(m_Seed, pair);
+	const uint32_t index = ShuffledIndex(seed);
+	return glm::vec2(ToUnit(Draw(pair, seed, index, 0)), ToUnit(Draw(pair, seed, index, 1)));
+}
+
+//The index is Owen scrambled with the seed of the pair, which shuffles the order its points come in. Both components
+//share it, reversing the bits only where needed spares most of the reversals of Burley's version
+uint32_t Sampler::ShuffledIndex(const uint32_t& seed) const
+{
+	return m_Type == SamplerType::Random ? 0 : ReverseBits(LaineKarras(m_ReversedIndex, seed));
+}
+
+//The point of the shuffled index, scrambled again per component
+uint32_t Sampler::Draw(const uint32_t& pair, const uint32_t& seed, const uint32_t& index, const uint32_t& component) const
+{
+	if (m_Type == SamplerType::Random)
+		return Hash(HashCombine(HashCombine(seed, component), m_Index));
+
+	uint32_t value = ReverseBits(LaineKarras(component == 0 ? index : Pascal(index), HashCombine(seed, component)));
+
+	//Toroidal shift by the rank of the pixel, read from the mask at an offset of the pair and component's own so they
+	//don't all move together
+	if (m_Type == SamplerType::BlueNoise)
+	{
+		const std::vector<uint32_t>& ranks = BlueNoiseRanks();
+		const uint32_t mask = (1u << BlueNoiseBits) - 1u;
+		const uint32_t offset = Hash(HashCombine(pair, component));
+		const uint32_t x = ((uint32_t)m_x + offset) & mask;
+		const uint32_t y = ((uint32_t)m_y + (offset >> 16)) & mask;
+		value += ranks[(y << BlueNoiseBits) | x] << (32 - 2 * BlueNoiseBits);
+	}
+
+	return value;
+}
+
+const std::vector<uint32_t>& Sampler::BlueNoiseRanks()
+{
+	static const std::vector<uint32_t> ranks = BuildBlueNoise();
+	return ranks;
+}
+
+//Void and cluster (Ulichney 1993). A tenth of the pixels are set and moved from their tightest cluster to the largest void
+//until that stops changing anything, then ranked by taking them out again one cluster at a time, and the rest by
+//filling in one void at a time. Energy is a Gaussian of every set pixel, wrapped around the edges so the mask tiles
+std::vector<uint32_t> Sampler::BuildBlueNoise()
+{
+	const int size = 1 << BlueNoiseBits;
+	const int count = size * size;
+	const int radius = 6;
+	const float sigma = 1.5f;
+
+	std::vector<float> kernel((2 * radius + 1) * (2 * radius + 1));
+	for (int dy = -radius; dy <= radius; dy++)
+	{
+		for (int dx = -radius; dx <= radius; dx++)
+			kernel[(dy + radius) * (2 * radius + 1) + dx + radius] = std::exp(-(float)(dx * dx + dy * dy) / (2.0f * sigma * sigma));
+	}
+
+	std::vector<float> energy(count, 0.0f);
+	std::vector<bool> set(count, false);
+	auto Toggle = [&](const int& pixel)
+	{
+		set[pixel] = !set[pixel];
+		const float sign = set[pixel] ? 1.0f : -1.0f;
+		const int px = pixel % size;
+		const int py = pixel / size;
+		for (int dy = -radius; dy <= radius; dy++)
+		{
+			for (int dx = -radius; dx <= radius; dx++)
+				energy[((py + dy + size) % size) * size + (px + dx + size) % size] += sign * kernel[(dy + radius) * (2 * radius + 1) + dx + radius];
+		}
+	};
+
+	auto Find = [&](const bool& state, const bool& highest)
+	{
+		int best = -1;
+		for (int pixel = 0; pixel < count; pixel++)
+		{
+			if (set[pixel] == state && (best < 0 || (highest ? energy[pixel] > energy[best] : energy[pixel] < energy[best])))
+				best = pixel;
+		}
+
+		return best;
+	};
+
+	const int InitialCount = count / 10;
+	uint32_t state = 0;
+	for (int placed = 0; placed < InitialCount; state++)
+	{
+		const int pixel = (int)(Hash(state) % (uint32_t)count);
+		if (set[pixel])
+			continue;
+
+		Toggle(pixel);
+		placed++;
+	}
+
+	for (int i = 0; i < count; i++)
+	{
+		const int cluster = Find(true, true);
+		Toggle(cluster);
+		const int gap = Find(false, false);
+		Toggle(gap);
+		if (gap == cluster)
+			break;
+	}
+
+	const std::vector<bool> prototype = set;
+	const std::vector<float> PrototypeEnergy = energy;
+	std::vector<uint32_t> ranks(count);
+	for (int rank = InitialCount - 1; rank >= 0; rank--)
+	{
+		const int cluster = Find(true, true);
+		Toggle(cluster);
+		ranks[cluster] = (uint32_t)rank;
+	}
+
+	set = prototype;
+	energy = PrototypeEnergy;
+	for (int rank = InitialCount; rank < count; rank++)
+	{
+		const int gap = Find(false, false);
+		Toggle(gap);
+		ranks[gap] = (uint32_t)rank;
+	}
+
+	return ranks;
+}
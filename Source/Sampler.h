@@ -0,0 +1,89 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <format>
+#include <unordered_map>
+#include <vector>
+
+#include <glm.hpp>
+
+enum class SamplerType
+{
+	Random, Sobol, BlueNoise
+};
+
+template<>
+struct std::formatter<SamplerType> : std::formatter<std::string>
+{
+	auto format(const SamplerType& type, format_context& ctx) const
+	{
+		if (type == SamplerType::Random)
+			return std::formatter<std::string>::format(std::format("{}", "Random"), ctx);
+
+		if (type == SamplerType::Sobol)
+			return std::formatter<std::string>::format(std::format("{}", "Sobol"), ctx);
+
+		if (type == SamplerType::BlueNoise)
+			return std::formatter<std::string>::format(std::format("{}", "BlueNoise"), ctx);
+
+		else
+			return std::formatter<std::string>::format(std::format("{}", "<Invalid Sampler>"), ctx);
+	}
+};
+
+const std::unordered_map<std::string, SamplerType> SamplerTypeMap =
+{
+	std::pair("Random", SamplerType::Random),
+	std::pair("Sobol", SamplerType::Sobol),
+	std::pair("BlueNoise", SamplerType::BlueNoise)
+};
+
+//Every decision of a path reads a fixed dimension, so it sees a well spread sequence over the samples of its pixel.
+//The camera takes the first ones and each bounce the next BounceDimensions. Dimensions 2k and 2k + 1 are drawn as a pair
+const uint32_t PixelDimension = 0;
+const uint32_t LensDimension = 2;
+const uint32_t CameraDimensions = 4;
+
+const uint32_t ScatterDimension = 0;											//The glass reflection choice reads the first of the pair
+const uint32_t SunDimension = 2;												//Radius and azimuth on the disk
+const uint32_t SunAngleDimension = 4;
+const uint32_t LightPickDimension = 5;
+const uint32_t LightConeDimension = 6;
+const uint32_t RouletteDimension = 8;
+const uint32_t BounceDimensions = 10;
+
+const int BlueNoiseBits = 6;													//The rank mask tiles the screen in 64 x 64 blocks
+const int AdaptiveMinSamples = 16;												//Before that the error a pixel estimates from its own samples isn't trusted
+
+//Random numbers of one pixel, indexed by sample and dimension so nothing has to be drawn in order. Random hashes all three
+//together. Sobol is Owen scrambled Sobol (Burley 2020), a 2D Sobol pattern per pair of dimensions with its own scramble
+//and shuffle, seeded per pixel. BlueNoise shares one scrambled sequence over the screen and shifts it per pixel by a
+//void and cluster rank mask, so each pixel still gets a well spread sequence while neighbours start from values far
+//apart, which pushes the error to high frequencies. Bit for bit the same as Sampler.glsl
+class Sampler
+{
+public:
+	Sampler(const SamplerType& type, const int& x, const int& y, const uint32_t& sample);
+
+	void StartBounce(const int& depth);
+
+	float Get1D(const uint32_t& dimension) const;
+	glm::vec2 Get2D(const uint32_t& dimension) const;
+
+	static const std::vector<uint32_t>& BlueNoiseRanks();
+
+private:
+	uint32_t ShuffledIndex(const uint32_t& seed) const;
+	uint32_t Draw(const uint32_t& pair, const uint32_t& seed, const uint32_t& index, const uint32_t& component) const;
+	static std::vector<uint32_t> BuildBlueNoise();
+
+private:
+	SamplerType m_Type;
+	int m_x = 0;
+	int m_y = 0;
+	uint32_t m_Seed = 0;
+	uint32_t m_Index = 0;
+	uint32_t m_ReversedIndex = 0;
+	uint32_t m_Base = 0;															//First dimension of the current bounce
+};
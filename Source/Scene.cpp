@@ -8,20 +8,43 @@ Scene::Scene(const std::string& filepath)
 bool Scene::Load(const std::string& filepath)
 {
 	std::ifstream stream(filepath);
+	if (!stream.is_open())
+	{
+		std::println("Failed to Load Scene: {}\n", filepath);
+		return false;
+	}
+
+	if (!Parse(stream, filepath))
+		return false;
+
+	m_Filepath = filepath;
+	return true;
+}
+
+//Scene file contents as Save writes them, for handing scenes to other processes
+std::string Scene::Serialize() const
+{
+	std::stringstream stream;
+	Write(stream);
+	return stream.str();
+}
+
+//name stands in for the file path in parse errors, the scene keeps no path to Save to
+bool Scene::Deserialize(const std::string& text, const std::string& name)
+{
+	std::stringstream stream(text);
+	return Parse(stream, name);
+}
+
+bool Scene::Parse(std::istream& stream, const std::string& filepath)
+{
 	std::string line;
-	std::stringstream ss;
 
 	enum class Target
 	{
 		None, Spheres, Settings, Camera, Materials, BlackHole
 	};
 
-	if (!stream.is_open())
-	{
-		std::println("Failed to Load Scene: {}\n", filepath);
-		return false;
-	}
-
 	Target target = Target::None;
 	std::string SphereTargetName;
 	std::string MaterialTargetName;
@@ -92,7 +115,6 @@ bool Scene::Load(const std::string& filepath)
 		return success;
 	}
 
-	m_Filepath = filepath;
 	return success;
 }
 
@@ -104,7 +126,11 @@ void Scene::Save()
 void Scene::Save(const std::string& filepath)
 {
 	std::ofstream stream(filepath);
+	Write(stream);
+}
 
+void Scene::Write(std::ostream& stream) const
+{
 	std::println(stream, "Camera:");
 	std::println(stream, "\tPosition = ({}, {}, {})", m_Camera.m_Position.x, m_Camera.m_Position.y, m_Camera.m_Position.z);
 	std::println(stream, "\tYaw = {}", m_Camera.m_Yaw);
@@ -147,6 +173,11 @@ void Scene::Save(const std::string& filepath)
 
 	std::println(stream, "Settings:");
 	std::println(stream, "\tMax_Depth = {}", m_MaxDepth);
+	std::println(stream, "\tRoulette_Depth = {}", m_RouletteDepth);
+	std::println(stream, "\tSampler = {}", m_Sampler);
+	std::println(stream, "\tNoise_Threshold = {}", m_NoiseThreshold);
+	std::println(stream, "\tQuality_Target = {}", m_QualityTarget);
+	std::println(stream, "\tTime_Limit = {}", m_TimeLimit);
 	std::println(stream, "\tSun_Radius = {}", m_SunRadius);
 	std::println(stream, "\tSun_Intensity = {}", m_SunIntensity);
 	std::println(stream, "\tSun_Altitude = {}", m_SunAltitude);
@@ -158,6 +189,7 @@ void Scene::Save(const std::string& filepath)
 	std::println(stream, "\tF_Stop = {}", m_FStop);
 	std::println(stream, "\tExposure = {}", m_Exposure);
 	std::println(stream, "\tRenderBlackHole = {}", RenderBlackHole);
+	std::println(stream, "\tDenoise = {}", m_Denoise);
 }
 
 std::string Scene::GetSphereName(const std::string& line, const int& LineNumber, const std::string& filepath)
@@ -384,6 +416,25 @@ bool inline Scene::ParseTargetSettings(const std::string& line, const int& LineN
 		return true;
 	}
 
+	if (SettingName == "Denoise")
+	{
+		Setting(Scene_Setting::Denoise, GetToken(line, found + 1) == "true");
+		return true;
+	}
+
+	if (SettingName == "Sampler")
+	{
+		const std::string type = GetToken(line, found + 1);
+		if (SamplerTypeMap.find(type) == SamplerTypeMap.end())
+		{
+			std::println("SCENE FILE PARSE FAILED: Unknown sampler {} at line {} in {}", type, LineNumber, filepath);
+			return false;
+		}
+
+		m_Sampler = SamplerTypeMap.at(type);
+		return true;
+	}
+
 	if (line.find("(") == std::string::npos && line.find(",") == std::string::npos)
 	{
 		float value = std::stof(line.substr(found + 1));
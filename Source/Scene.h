@@ -15,19 +15,25 @@
 #include "Camera.h"
 #include "Tokenization.h"
 #include "VectorMath.h"
+#include "Sampler.h"
 
 enum class Scene_Setting
 {
-	Max_Depth,
+	Max_Depth, Roulette_Depth,
+	Noise_Threshold, Quality_Target, Time_Limit,
 	Sun_Radius, Sun_Intensity, Sun_Altitude, Sun_Azimuthal, Sky_Variation,
 	Sensor_Size, Focal_Length, Focus_Dist, F_Stop,
 	Gamma, Exposure,
-	RenderBlackHole
+	RenderBlackHole, Denoise
 };
 
 const std::unordered_map<std::string, Scene_Setting> SettingMap =
 {
 	std::pair("Max_Depth", Scene_Setting::Max_Depth),
+	std::pair("Roulette_Depth", Scene_Setting::Roulette_Depth),
+	std::pair("Noise_Threshold", Scene_Setting::Noise_Threshold),
+	std::pair("Quality_Target", Scene_Setting::Quality_Target),
+	std::pair("Time_Limit", Scene_Setting::Time_Limit),
 	std::pair("Sun_Radius", Scene_Setting::Sun_Radius),
 	std::pair("Sun_Intensity", Scene_Setting::Sun_Intensity),
 	std::pair("Sun_Altitude", Scene_Setting::Sun_Altitude),
@@ -39,7 +45,8 @@ const std::unordered_map<std::string, Scene_Setting> SettingMap =
 	std::pair("F_Stop", Scene_Setting::F_Stop),
 	std::pair("Gamma", Scene_Setting::Gamma),
 	std::pair("Exposure", Scene_Setting::Exposure),
-	std::pair("RenderBlackHole", Scene_Setting::RenderBlackHole)
+	std::pair("RenderBlackHole", Scene_Setting::RenderBlackHole),
+	std::pair("Denoise", Scene_Setting::Denoise)
 };
 
 static bool EqualPresent(const std::string& string, const int& Line, const std::string& filepath)
@@ -64,6 +71,12 @@ class Scene
 {
 public:
 	int m_MaxDepth = 30;
+	int m_RouletteDepth = 3;
+	SamplerType m_Sampler = SamplerType::Sobol;
+
+	float m_NoiseThreshold = 0.0;													//Relative error a tile stops being sampled at, 0 samples every tile
+	float m_QualityTarget = 0.0;													//Relative error of the whole image the render stops at, 0 for none
+	float m_TimeLimit = 0.0;														//Seconds, 0 for none
 
 	float m_SensorSize = 100.0;
 	float m_FocalLength = 35.0;
@@ -78,6 +91,7 @@ public:
 
 	float m_Gamma = 2.2;
 	float m_Exposure = 1.5;
+	bool m_Denoise = false;														//Filter the accumulated image before post processing
 
 	bool RenderBlackHole = false;
 	Vec3 BlackHolePosition = Vec3(0.0);
@@ -95,11 +109,15 @@ public:
 	void Save();
 	void Save(const std::string& filepath);
 	bool Load(const std::string& filepath);
+	std::string Serialize() const;
+	bool Deserialize(const std::string& text, const std::string& name);
 
 private:
 	std::string m_Filepath;
 
 private:
+	bool Parse(std::istream& stream, const std::string& filepath);
+	void Write(std::ostream& stream) const;
 	std::string GetSphereName(const std::string& line, const int& LineNumber, const std::string& filepath);
 	std::string GetMaterialName(const std::string& line, const int& LineNumber, const std::string& filepath);
 	bool ParseTargetSpheres(std::string& TargetName, const std::string& line, const int& LineNumber, const std::string& filepath);
@@ -121,6 +139,22 @@ void Scene::Setting(const Scene_Setting& Setting, const T& value)
 			m_MaxDepth = value;
 			break;
 
+		case Scene_Setting::Roulette_Depth:
+			m_RouletteDepth = value;
+			break;
+
+		case Scene_Setting::Noise_Threshold:
+			m_NoiseThreshold = value;
+			break;
+
+		case Scene_Setting::Quality_Target:
+			m_QualityTarget = value;
+			break;
+
+		case Scene_Setting::Time_Limit:
+			m_TimeLimit = value;
+			break;
+
 		case Scene_Setting::Sun_Radius:
 			m_SunRadius = value;
 			break;
@@ -168,5 +202,9 @@ void Scene::Setting(const Scene_Setting& Setting, const T& value)
 		case Scene_Setting::RenderBlackHole:
 			RenderBlackHole = value;
 			break;
+
+		case Scene_Setting::Denoise:
+			m_Denoise = value;
+			break;
 	}
 }
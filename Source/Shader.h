@@ -1,7 +1,6 @@
 #pragma once
 
 #include <GL/glew.h>
-#include <GLFW/glfw3.h>
 
 #include <fstream>
 #include <string>
@@ -62,13 +61,17 @@ struct std::formatter<glslType> : std::formatter<std::string>
 const std::unordered_map<std::string, glslType> glslTypeMap =
 {
 	std::pair("int", glslType::glslInt),
+	std::pair("bool", glslType::glslInt),
 	std::pair("float", glslType::glslFloat),
 	std::pair("vec2", glslType::glslVec2),
 	std::pair("vec3", glslType::glslVec3),
 	std::pair("vec4", glslType::glslVec4),
 	std::pair("mat3", glslType::glslMat3),
 	std::pair("mat4", glslType::glslMat4),
-	std::pair("sampler2D", glslType::glslInt)
+	std::pair("sampler2D", glslType::glslInt),
+	std::pair("samplerBuffer", glslType::glslInt),
+	std::pair("usamplerBuffer", glslType::glslInt),
+	std::pair("isamplerBuffer", glslType::glslInt)
 };
 
 class Uniform
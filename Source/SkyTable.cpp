@@ -0,0 +1,88 @@
+#include "SkyTable.h"
+
+#include <algorithm>
+#include <cmath>
+
+void SkyTable::Build(const float& SunAltitude, const float& SunAzimuthal, const float& SkyVariation, const int& size)
+{
+	if (SunAltitude == m_SunAltitude && SunAzimuthal == m_SunAzimuthal && SkyVariation == m_SkyVariation && size == m_Size)
+		return;
+
+	m_SunAltitude = SunAltitude;
+	m_SunAzimuthal = SunAzimuthal;
+	m_SkyVariation = SkyVariation;
+	m_Size = std::max(size, 2);
+
+	const float CosAltitude = std::cos(SunAltitude);
+	m_SunDirection = glm::normalize(glm::vec3(CosAltitude * std::sin(SunAzimuthal), std::sin(SunAltitude), CosAltitude * std::cos(SunAzimuthal)));
+
+	m_Texels.resize((size_t)m_Size * m_Size);
+	for (int y = 0; y < m_Size; y++)
+	{
+		const float SunCosine = 2.0f * (float)y / (float)(m_Size - 1) - 1.0f;
+		for (int x = 0; x < m_Size; x++)
+		{
+			const float height = 2.0f * (float)x / (float)(m_Size - 1) - 1.0f;
+			m_Texels[(size_t)y * m_Size + x] = glm::vec4(Evaluate(height, SunCosine, SkyVariation), 1.0f);
+		}
+	}
+}
+
+//Direction has to be normalized. fmax sends NaN directions to the table edge rather than outside the table
+glm::vec3 SkyTable::Lookup(const glm::vec3& direction) const
+{
+	const float x = std::fmin(std::fmax(0.5f * direction.y + 0.5f, 0.0f), 1.0f) * (float)(m_Size - 1);
+	const float y = std::fmin(std::fmax(0.5f * glm::dot(direction, m_SunDirection) + 0.5f, 0.0f), 1.0f) * (float)(m_Size - 1);
+
+	const int x0 = std::min((int)x, m_Size - 2);
+	const int y0 = std::min((int)y, m_Size - 2);
+	const float fx = x - (float)x0;
+	const float fy = y - (float)y0;
+
+	const glm::vec4* row0 = &m_Texels[(size_t)y0 * m_Size + x0];
+	const glm::vec4* row1 = row0 + m_Size;
+	const glm::vec4 bottom = row0[0] + fx * (row0[1] - row0[0]);
+	const glm::vec4 top = row1[0] + fx * (row1[1] - row1[0]);
+	return glm::vec3(bottom + fy * (top - bottom));
+}
+
+//Everything WorldColor adds up except the sun disk
+glm::vec3 SkyTable::Evaluate(const float& height, const float& SunCosine, const float& SkyVariation)
+{
+	const glm::vec3 SunHaloColor = glm::vec3(1.0f, 1.0f, 0.2f) * 2.0f;
+	const float SunHaloRadius = 0.9f;
+
+	glm::vec3 color;
+	if (height < 0.0f)
+	{
+		float expVal = std::exp(-10.0f * height * height);
+		color = glm::vec3(0.8f * expVal, 0.8f * expVal, expVal);
+	}
+
+	else
+	{
+		float theta = std::cos(height);
+		float R = (theta - 0.2f) * SkyVariation + 0.8f * (1.0f - SkyVariation);
+		float B = theta * SkyVariation + 1.0f - SkyVariation;
+		color = glm::vec3(R, R, B);
+	}
+
+	color *= 10.0f;
+	float t = std::exp(-1.0f * (SunCosine - 1.0f) * (SunCosine - 1.0f) / (SunHaloRadius * SunHaloRadius));
+	return color + SunHaloColor * std::sin(1.57f * t);
+}
+
+glm::vec3 SkyTable::SunDirection() const
+{
+	return m_SunDirection;
+}
+
+int SkyTable::GetSize() const
+{
+	return m_Size;
+}
+
+const std::vector<glm::vec4>& SkyTable::GetTexels() const
+{
+	return m_Texels;
+}
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <vector>
+
+#include <glm.hpp>
+
+//Sky gradient and sun halo of WorldColor, baked over the height of a direction and its cosine to the sun. Both are smooth
+//in those two, so a bilinear lookup stands in for the exp and trig calls every miss used to make. The sun disk is far
+//narrower than a texel and is still evaluated where it matters
+class SkyTable
+{
+public:
+	void Build(const float& SunAltitude, const float& SunAzimuthal, const float& SkyVariation, const int& size = 128);
+
+	glm::vec3 Lookup(const glm::vec3& direction) const;
+	static glm::vec3 Evaluate(const float& height, const float& SunCosine, const float& SkyVariation);
+
+	glm::vec3 SunDirection() const;
+	int GetSize() const;
+	const std::vector<glm::vec4>& GetTexels() const;
+
+private:
+	float m_SunAltitude = 0.0f;
+	float m_SunAzimuthal = 0.0f;
+	float m_SkyVariation = 0.0f;
+	glm::vec3 m_SunDirection = glm::vec3(0.0f, 0.0f, 1.0f);
+
+	int m_Size = 0;
+	std::vector<glm::vec4> m_Texels;												//Row per sun cosine, column per height, both from -1 to 1
+};
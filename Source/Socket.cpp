@@ -0,0 +1,275 @@
+#include "Socket.h"
+
+#include <print>
+#include <algorithm>
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <winsock2.h>
+#include <ws2tcpip.h>
+
+using SocketLength = int;
+static const int SendFlags = 0;
+
+static bool StartSockets()
+{
+	static const bool started = []()
+	{
+		WSADATA data;
+		return WSAStartup(MAKEWORD(2, 2), &data) == 0;
+	}();
+
+	return started;
+}
+
+static void CloseSocket(const intptr_t& handle)
+{
+	closesocket((SOCKET)handle);
+}
+
+static int Poll(pollfd* descriptors, const size_t& count, const int& milliseconds)
+{
+	return WSAPoll(descriptors, (ULONG)count, milliseconds);
+}
+
+static void ReceiveTimeout(const intptr_t& handle, const int& milliseconds)
+{
+	const DWORD timeout = (DWORD)milliseconds;
+	setsockopt((SOCKET)handle, SOL_SOCKET, SO_RCVTIMEO, (const char*)&timeout, sizeof(timeout));
+}
+#else
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <netdb.h>
+#include <poll.h>
+#include <unistd.h>
+
+using SocketLength = socklen_t;
+static const int SendFlags = MSG_NOSIGNAL;										//A dead peer fails the send instead of raising SIGPIPE
+
+static bool StartSockets()
+{
+	return true;
+}
+
+static void CloseSocket(const intptr_t& handle)
+{
+	close((int)handle);
+}
+
+static int Poll(pollfd* descriptors, const size_t& count, const int& milliseconds)
+{
+	return poll(descriptors, (nfds_t)count, milliseconds);
+}
+
+static void ReceiveTimeout(const intptr_t& handle, const int& milliseconds)
+{
+	timeval timeout = {};
+	timeout.tv_sec = milliseconds / 1000;
+	timeout.tv_usec = (milliseconds % 1000) * 1000;
+	setsockopt((int)handle, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+}
+#endif
+
+Socket::~Socket()
+{
+	Close();
+}
+
+Socket::Socket(Socket&& other) noexcept
+	:m_Handle(other.m_Handle)
+{
+	other.m_Handle = -1;
+}
+
+Socket& Socket::operator=(Socket&& other) noexcept
+{
+	if (this != &other)
+	{
+		Close();
+		m_Handle = other.m_Handle;
+		other.m_Handle = -1;
+	}
+
+	return *this;
+}
+
+//Port 0 lets the system pick one, GetPort tells which
+bool Socket::Listen(const std::string& address, const uint16_t& port)
+{
+	if (!StartSockets())
+		return false;
+
+	Close();
+	m_Handle = (intptr_t)socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+	if (m_Handle == -1)
+		return false;
+
+	const int reuse = 1;
+	setsockopt(m_Handle, SOL_SOCKET, SO_REUSEADDR, (const char*)&reuse, sizeof(reuse));
+
+	sockaddr_in local = {};
+	local.sin_family = AF_INET;
+	local.sin_port = htons(port);
+	if (inet_pton(AF_INET, address.c_str(), &local.sin_addr) != 1)
+	{
+		std::println("Cannot listen on {}, not an IPv4 address", address);
+		Close();
+		return false;
+	}
+
+	if (bind(m_Handle, (const sockaddr*)&local, sizeof(local)) != 0 || listen(m_Handle, SOMAXCONN) != 0)
+	{
+		std::println("Cannot listen on {}:{}", address, port);
+		Close();
+		return false;
+	}
+
+	return true;
+}
+
+//Blocks until a connection comes in, WaitReadable tells when one has
+Socket Socket::Accept() const
+{
+	Socket connection;
+	connection.m_Handle = (intptr_t)accept(m_Handle, nullptr, nullptr);
+	if (connection.m_Handle == -1)
+		return connection;
+
+	const int NoDelay = 1;															//Messages are whole, don't hold back their tails
+	setsockopt(connection.m_Handle, IPPROTO_TCP, TCP_NODELAY, (const char*)&NoDelay, sizeof(NoDelay));
+	return connection;
+}
+
+bool Socket::Connect(const std::string& host, const uint16_t& port)
+{
+	if (!StartSockets())
+		return false;
+
+	Close();
+
+	addrinfo hints = {};
+	hints.ai_family = AF_UNSPEC;
+	hints.ai_socktype = SOCK_STREAM;
+	hints.ai_protocol = IPPROTO_TCP;
+
+	addrinfo* addresses = nullptr;
+	if (getaddrinfo(host.c_str(), std::to_string(port).c_str(), &hints, &addresses) != 0)
+	{
+		std::println("Cannot resolve {}", host);
+		return false;
+	}
+
+	for (addrinfo* address = addresses; address != nullptr; address = address->ai_next)
+	{
+		m_Handle = (intptr_t)socket(address->ai_family, address->ai_socktype, address->ai_protocol);
+		if (m_Handle == -1)
+			continue;
+
+		if (connect(m_Handle, address->ai_addr, (SocketLength)address->ai_addrlen) == 0)
+			break;
+
+		Close();
+	}
+
+	freeaddrinfo(addresses);
+	if (m_Handle == -1)
+	{
+		std::println("Cannot connect to {}:{}", host, port);
+		return false;
+	}
+
+	const int NoDelay = 1;
+	setsockopt(m_Handle, IPPROTO_TCP, TCP_NODELAY, (const char*)&NoDelay, sizeof(NoDelay));
+	return true;
+}
+
+bool Socket::Send(const void* data, const size_t& size) const
+{
+	const char* bytes = (const char*)data;
+	size_t sent = 0;
+	while (sent < size)
+	{
+		const int chunk = (int)std::min(size - sent, (size_t)(1 << 30));
+		const auto count = send(m_Handle, bytes + sent, chunk, SendFlags);
+		if (count <= 0)
+			return false;
+
+		sent += (size_t)count;
+	}
+
+	return true;
+}
+
+bool Socket::Receive(void* data, const size_t& size) const
+{
+	char* bytes = (char*)data;
+	size_t received = 0;
+	while (received < size)
+	{
+		const int chunk = (int)std::min(size - received, (size_t)(1 << 30));
+		const auto count = recv(m_Handle, bytes + received, chunk, 0);
+		if (count <= 0)
+			return false;
+
+		received += (size_t)count;
+	}
+
+	return true;
+}
+
+//Whether a Receive or, on a listener, an Accept would go ahead without blocking, also true once the other end is gone
+bool Socket::WaitReadable(const int& milliseconds) const
+{
+	pollfd descriptor = {};
+	descriptor.fd = (decltype(descriptor.fd))m_Handle;
+	descriptor.events = POLLIN;
+	return Poll(&descriptor, 1, milliseconds) != 0;
+}
+
+//Receives fail once the other end has gone quiet this long part way through, 0 waits for ever
+void Socket::SetReceiveTimeout(const int& milliseconds) const
+{
+	ReceiveTimeout(m_Handle, milliseconds);
+}
+
+uint16_t Socket::GetPort() const
+{
+	sockaddr_in local = {};
+	SocketLength length = sizeof(local);
+	if (getsockname(m_Handle, (sockaddr*)&local, &length) != 0)
+		return 0;
+
+	return ntohs(local.sin_port);
+}
+
+std::string Socket::GetPeerName() const
+{
+	sockaddr_storage peer = {};
+	SocketLength length = sizeof(peer);
+	if (getpeername(m_Handle, (sockaddr*)&peer, &length) != 0)
+		return "unknown";
+
+	char host[NI_MAXHOST];
+	char port[NI_MAXSERV];
+	if (getnameinfo((const sockaddr*)&peer, length, host, sizeof(host), port, sizeof(port), NI_NUMERICHOST | NI_NUMERICSERV) != 0)
+		return "unknown";
+
+	return std::string(host) + ":" + port;
+}
+
+bool Socket::Valid() const
+{
+	return m_Handle != -1;
+}
+
+void Socket::Close()
+{
+	if (m_Handle == -1)
+		return;
+
+	CloseSocket(m_Handle);
+	m_Handle = -1;
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <string>
+#include <cstdint>
+#include <cstddef>
+
+//Blocking TCP connection or listener over BSD sockets or Winsock, just what the distributed renderer needs. Sends
+//and receives move whole buffers or fail, a failure means the other end is gone
+class Socket
+{
+public:
+	Socket() = default;
+	~Socket();
+
+	Socket(const Socket&) = delete;
+	Socket& operator=(const Socket&) = delete;
+	Socket(Socket&& other) noexcept;
+	Socket& operator=(Socket&& other) noexcept;
+
+	bool Listen(const std::string& address, const uint16_t& port);
+	Socket Accept() const;
+	bool Connect(const std::string& host, const uint16_t& port);
+
+	bool Send(const void* data, const size_t& size) const;
+	bool Receive(void* data, const size_t& size) const;
+	bool WaitReadable(const int& milliseconds) const;
+	void SetReceiveTimeout(const int& milliseconds) const;
+
+	uint16_t GetPort() const;
+	std::string GetPeerName() const;
+	bool Valid() const;
+	void Close();
+
+private:
+	intptr_t m_Handle = -1;
+};
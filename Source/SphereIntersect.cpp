@@ -0,0 +1,484 @@
+#include "SphereIntersect.h"
+
+#include <cmath>
+#include <cfloat>
+#include <cstdint>
+#include <print>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+	#define HALOGEN_X86
+	#include <immintrin.h>
+
+	#if defined(_MSC_VER)
+		#include <intrin.h>
+	#else
+		#include <cpuid.h>
+	#endif
+#endif
+
+#if defined(_MSC_VER) && !defined(__clang__)
+	#define HALOGEN_TARGET(isa)
+#else
+	#define HALOGEN_TARGET(isa) __attribute__((target(isa)))
+#endif
+
+//AVX-512 brings FMA with it, fusing the multiply adds would make the wide kernels disagree with the scalar one on grazing hits
+#if defined(__GNUC__) && !defined(__clang__)
+	#pragma GCC optimize("fp-contract=off")
+#endif
+
+namespace SphereIntersect
+{
+	using ClosestHitFunction = int(*)(const float*, const float*, const float*, const float*, const size_t&, const glm::vec3&, const glm::vec3&, float&);
+
+	float HitDistance(const glm::vec3& origin, const glm::vec3& dir, const glm::vec3& center, const float& radius)
+	{
+		const float dx = origin.x - center.x;
+		const float dy = origin.y - center.y;
+		const float dz = origin.z - center.z;
+
+		const float RaySphereDist = dx * dx + dy * dy + dz * dz;
+		const float DirDotDiff = dir.x * dx + dir.y * dy + dir.z * dz;
+		const float RadiusSquared = radius * radius;
+		const float discriminant = DirDotDiff * DirDotDiff - (RaySphereDist - RadiusSquared);
+
+		if (discriminant < 0.0f)
+			return -1.0f;
+
+		const float root = std::sqrt(discriminant);
+		const float temp = -root - DirDotDiff;
+		const float temp2 = root - DirDotDiff;
+
+		const bool NearZero = std::abs(temp) < Epsilon;
+		const bool NearZero2 = std::abs(temp2) < Epsilon;
+
+		if (NearZero && NearZero2)
+			return -1.0f;
+
+		if (NearZero)
+			return temp2;
+
+		if (NearZero2)
+			return temp;
+
+		if (RaySphereDist < RadiusSquared)
+			return temp > 0.0f ? temp : temp2;
+
+		return temp < temp2 ? temp : temp2;
+	}
+
+	static int ClosestHitScalar(const float* x, const float* y, const float* z, const float* r, const size_t& count, const glm::vec3& origin, const glm::vec3& dir, float& t)
+	{
+		int index = -1;
+		t = NoHit;
+
+		for (size_t i = 0; i < count; i++)
+		{
+			const float hit = HitDistance(origin, dir, glm::vec3(x[i], y[i], z[i]), r[i]);
+			if (0.0f < hit && hit < t)
+			{
+				t = hit;
+				index = (int)i;
+			}
+		}
+
+		return index;
+	}
+
+	//Finishes the spheres that don't fill a whole vector, indices past the packed ones only win on a strictly closer hit
+	static void ScalarTail(const float* x, const float* y, const float* z, const float* r, const size_t& start, const size_t& count, const glm::vec3& origin, const glm::vec3& dir, float& t, int& index)
+	{
+		for (size_t i = start; i < count; i++)
+		{
+			const float hit = HitDistance(origin, dir, glm::vec3(x[i], y[i], z[i]), r[i]);
+			if (0.0f < hit && hit < t)
+			{
+				t = hit;
+				index = (int)i;
+			}
+		}
+	}
+
+	//Lanes each keep their own closest hit, the smallest index wins ties to match the scalar loop order
+	static void ReduceLanes(const float* LaneT, const int* LaneIndex, const int& lanes, float& t, int& index)
+	{
+		t = NoHit;
+		index = -1;
+
+		for (int lane = 0; lane < lanes; lane++)
+		{
+			if (LaneIndex[lane] < 0)
+				continue;
+
+			if (LaneT[lane] < t || (LaneT[lane] == t && LaneIndex[lane] < index))
+			{
+				t = LaneT[lane];
+				index = LaneIndex[lane];
+			}
+		}
+	}
+
+#ifdef HALOGEN_X86
+	HALOGEN_TARGET("sse2")
+	static inline __m128 Select(const __m128& mask, const __m128& a, const __m128& b)				//mask ? a : b
+	{
+		return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+	}
+
+	HALOGEN_TARGET("sse2")
+	static int ClosestHitSSE(const float* x, const float* y, const float* z, const float* r, const size_t& count, const glm::vec3& origin, const glm::vec3& dir, float& t)
+	{
+		const size_t packed = count & ~(size_t)3;
+
+		const __m128 ox = _mm_set1_ps(origin.x);
+		const __m128 oy = _mm_set1_ps(origin.y);
+		const __m128 oz = _mm_set1_ps(origin.z);
+		const __m128 dx = _mm_set1_ps(dir.x);
+		const __m128 dy = _mm_set1_ps(dir.y);
+		const __m128 dz = _mm_set1_ps(dir.z);
+		const __m128 zero = _mm_setzero_ps();
+		const __m128 epsilon = _mm_set1_ps(Epsilon);
+		const __m128 SignMask = _mm_set1_ps(-0.0f);
+
+		__m128 best = _mm_set1_ps(NoHit);
+		__m128i BestIndex = _mm_set1_epi32(-1);
+		__m128i index = _mm_setr_epi32(0, 1, 2, 3);
+		const __m128i step = _mm_set1_epi32(4);
+
+		for (size_t i = 0; i < packed; i += 4)
+		{
+			const __m128 diffX = _mm_sub_ps(ox, _mm_loadu_ps(x + i));
+			const __m128 diffY = _mm_sub_ps(oy, _mm_loadu_ps(y + i));
+			const __m128 diffZ = _mm_sub_ps(oz, _mm_loadu_ps(z + i));
+			const __m128 radius = _mm_loadu_ps(r + i);
+
+			const __m128 RaySphereDist = _mm_add_ps(_mm_add_ps(_mm_mul_ps(diffX, diffX), _mm_mul_ps(diffY, diffY)), _mm_mul_ps(diffZ, diffZ));
+			const __m128 DirDotDiff = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, diffX), _mm_mul_ps(dy, diffY)), _mm_mul_ps(dz, diffZ));
+			const __m128 RadiusSquared = _mm_mul_ps(radius, radius);
+			const __m128 discriminant = _mm_sub_ps(_mm_mul_ps(DirDotDiff, DirDotDiff), _mm_sub_ps(RaySphereDist, RadiusSquared));
+
+			const __m128 valid = _mm_cmpge_ps(discriminant, zero);
+			const __m128 root = _mm_sqrt_ps(_mm_max_ps(discriminant, zero));
+			const __m128 temp = _mm_sub_ps(_mm_xor_ps(root, SignMask), DirDotDiff);
+			const __m128 temp2 = _mm_sub_ps(root, DirDotDiff);
+
+			const __m128 NearZero = _mm_cmplt_ps(_mm_andnot_ps(SignMask, temp), epsilon);
+			const __m128 NearZero2 = _mm_cmplt_ps(_mm_andnot_ps(SignMask, temp2), epsilon);
+			const __m128 inside = _mm_cmplt_ps(RaySphereDist, RadiusSquared);
+
+			__m128 hit = Select(inside, Select(_mm_cmpgt_ps(temp, zero), temp, temp2), Select(_mm_cmplt_ps(temp, temp2), temp, temp2));
+			hit = Select(NearZero2, temp, hit);
+			hit = Select(NearZero, temp2, hit);
+
+			__m128 accept = _mm_andnot_ps(_mm_and_ps(NearZero, NearZero2), valid);
+			accept = _mm_and_ps(accept, _mm_and_ps(_mm_cmpgt_ps(hit, zero), _mm_cmplt_ps(hit, best)));
+
+			best = Select(accept, hit, best);
+			const __m128i AcceptInt = _mm_castps_si128(accept);
+			BestIndex = _mm_or_si128(_mm_and_si128(AcceptInt, index), _mm_andnot_si128(AcceptInt, BestIndex));
+			index = _mm_add_epi32(index, step);
+		}
+
+		alignas(16) float LaneT[4];
+		alignas(16) int LaneIndex[4];
+		_mm_store_ps(LaneT, best);
+		_mm_store_si128((__m128i*)LaneIndex, BestIndex);
+
+		int closest;
+		ReduceLanes(LaneT, LaneIndex, 4, t, closest);
+		ScalarTail(x, y, z, r, packed, count, origin, dir, t, closest);
+		return closest;
+	}
+
+	HALOGEN_TARGET("avx2")
+	static int ClosestHitAVX2(const float* x, const float* y, const float* z, const float* r, const size_t& count, const glm::vec3& origin, const glm::vec3& dir, float& t)
+	{
+		const size_t packed = count & ~(size_t)7;
+
+		const __m256 ox = _mm256_set1_ps(origin.x);
+		const __m256 oy = _mm256_set1_ps(origin.y);
+		const __m256 oz = _mm256_set1_ps(origin.z);
+		const __m256 dx = _mm256_set1_ps(dir.x);
+		const __m256 dy = _mm256_set1_ps(dir.y);
+		const __m256 dz = _mm256_set1_ps(dir.z);
+		const __m256 zero = _mm256_setzero_ps();
+		const __m256 epsilon = _mm256_set1_ps(Epsilon);
+		const __m256 SignMask = _mm256_set1_ps(-0.0f);
+
+		__m256 best = _mm256_set1_ps(NoHit);
+		__m256i BestIndex = _mm256_set1_epi32(-1);
+		__m256i index = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+		const __m256i step = _mm256_set1_epi32(8);
+
+		for (size_t i = 0; i < packed; i += 8)
+		{
+			const __m256 diffX = _mm256_sub_ps(ox, _mm256_loadu_ps(x + i));
+			const __m256 diffY = _mm256_sub_ps(oy, _mm256_loadu_ps(y + i));
+			const __m256 diffZ = _mm256_sub_ps(oz, _mm256_loadu_ps(z + i));
+			const __m256 radius = _mm256_loadu_ps(r + i);
+
+			const __m256 RaySphereDist = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(diffX, diffX), _mm256_mul_ps(diffY, diffY)), _mm256_mul_ps(diffZ, diffZ));
+			const __m256 DirDotDiff = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(dx, diffX), _mm256_mul_ps(dy, diffY)), _mm256_mul_ps(dz, diffZ));
+			const __m256 RadiusSquared = _mm256_mul_ps(radius, radius);
+			const __m256 discriminant = _mm256_sub_ps(_mm256_mul_ps(DirDotDiff, DirDotDiff), _mm256_sub_ps(RaySphereDist, RadiusSquared));
+
+			const __m256 valid = _mm256_cmp_ps(discriminant, zero, _CMP_GE_OQ);
+			const __m256 root = _mm256_sqrt_ps(_mm256_max_ps(discriminant, zero));
+			const __m256 temp = _mm256_sub_ps(_mm256_xor_ps(root, SignMask), DirDotDiff);
+			const __m256 temp2 = _mm256_sub_ps(root, DirDotDiff);
+
+			const __m256 NearZero = _mm256_cmp_ps(_mm256_andnot_ps(SignMask, temp), epsilon, _CMP_LT_OQ);
+			const __m256 NearZero2 = _mm256_cmp_ps(_mm256_andnot_ps(SignMask, temp2), epsilon, _CMP_LT_OQ);
+			const __m256 inside = _mm256_cmp_ps(RaySphereDist, RadiusSquared, _CMP_LT_OQ);
+
+			const __m256 InsideHit = _mm256_blendv_ps(temp2, temp, _mm256_cmp_ps(temp, zero, _CMP_GT_OQ));
+			const __m256 OutsideHit = _mm256_blendv_ps(temp2, temp, _mm256_cmp_ps(temp, temp2, _CMP_LT_OQ));
+			__m256 hit = _mm256_blendv_ps(OutsideHit, InsideHit, inside);
+			hit = _mm256_blendv_ps(hit, temp, NearZero2);
+			hit = _mm256_blendv_ps(hit, temp2, NearZero);
+
+			__m256 accept = _mm256_andnot_ps(_mm256_and_ps(NearZero, NearZero2), valid);
+			accept = _mm256_and_ps(accept, _mm256_and_ps(_mm256_cmp_ps(hit, zero, _CMP_GT_OQ), _mm256_cmp_ps(hit, best, _CMP_LT_OQ)));
+
+			best = _mm256_blendv_ps(best, hit, accept);
+			BestIndex = _mm256_blendv_epi8(BestIndex, index, _mm256_castps_si256(accept));
+			index = _mm256_add_epi32(index, step);
+		}
+
+		alignas(32) float LaneT[8];
+		alignas(32) int LaneIndex[8];
+		_mm256_store_ps(LaneT, best);
+		_mm256_store_si256((__m256i*)LaneIndex, BestIndex);
+
+		int closest;
+		ReduceLanes(LaneT, LaneIndex, 8, t, closest);
+		ScalarTail(x, y, z, r, packed, count, origin, dir, t, closest);
+		return closest;
+	}
+
+	HALOGEN_TARGET("avx512f")
+	static int ClosestHitAVX512(const float* x, const float* y, const float* z, const float* r, const size_t& count, const glm::vec3& origin, const glm::vec3& dir, float& t)
+	{
+		const size_t packed = count & ~(size_t)15;
+
+		const __m512 ox = _mm512_set1_ps(origin.x);
+		const __m512 oy = _mm512_set1_ps(origin.y);
+		const __m512 oz = _mm512_set1_ps(origin.z);
+		const __m512 dx = _mm512_set1_ps(dir.x);
+		const __m512 dy = _mm512_set1_ps(dir.y);
+		const __m512 dz = _mm512_set1_ps(dir.z);
+		const __m512 zero = _mm512_setzero_ps();
+		const __m512 epsilon = _mm512_set1_ps(Epsilon);
+		const __m512i AbsMask = _mm512_set1_epi32(0x7FFFFFFF);					//_mm512_and_ps needs AVX512DQ, the integer and doesn't
+
+		__m512 best = _mm512_set1_ps(NoHit);
+		__m512i BestIndex = _mm512_set1_epi32(-1);
+		__m512i index = _mm512_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15);
+		const __m512i step = _mm512_set1_epi32(16);
+
+		for (size_t i = 0; i < packed; i += 16)
+		{
+			const __m512 diffX = _mm512_sub_ps(ox, _mm512_loadu_ps(x + i));
+			const __m512 diffY = _mm512_sub_ps(oy, _mm512_loadu_ps(y + i));
+			const __m512 diffZ = _mm512_sub_ps(oz, _mm512_loadu_ps(z + i));
+			const __m512 radius = _mm512_loadu_ps(r + i);
+
+			const __m512 RaySphereDist = _mm512_add_ps(_mm512_add_ps(_mm512_mul_ps(diffX, diffX), _mm512_mul_ps(diffY, diffY)), _mm512_mul_ps(diffZ, diffZ));
+			const __m512 DirDotDiff = _mm512_add_ps(_mm512_add_ps(_mm512_mul_ps(dx, diffX), _mm512_mul_ps(dy, diffY)), _mm512_mul_ps(dz, diffZ));
+			const __m512 RadiusSquared = _mm512_mul_ps(radius, radius);
+			const __m512 discriminant = _mm512_sub_ps(_mm512_mul_ps(DirDotDiff, DirDotDiff), _mm512_sub_ps(RaySphereDist, RadiusSquared));
+
+			const __mmask16 valid = _mm512_cmp_ps_mask(discriminant, zero, _CMP_GE_OQ);
+			const __m512 root = _mm512_maskz_sqrt_ps(valid, discriminant);
+			const __m512 temp = _mm512_sub_ps(_mm512_sub_ps(zero, root), DirDotDiff);
+			const __m512 temp2 = _mm512_sub_ps(root, DirDotDiff);
+
+			const __mmask16 NearZero = _mm512_cmp_ps_mask(_mm512_castsi512_ps(_mm512_and_si512(_mm512_castps_si512(temp), AbsMask)), epsilon, _CMP_LT_OQ);
+			const __mmask16 NearZero2 = _mm512_cmp_ps_mask(_mm512_castsi512_ps(_mm512_and_si512(_mm512_castps_si512(temp2), AbsMask)), epsilon, _CMP_LT_OQ);
+			const __mmask16 inside = _mm512_cmp_ps_mask(RaySphereDist, RadiusSquared, _CMP_LT_OQ);
+
+			const __m512 InsideHit = _mm512_mask_blend_ps(_mm512_cmp_ps_mask(temp, zero, _CMP_GT_OQ), temp2, temp);
+			const __m512 OutsideHit = _mm512_mask_blend_ps(_mm512_cmp_ps_mask(temp, temp2, _CMP_LT_OQ), temp2, temp);
+			__m512 hit = _mm512_mask_blend_ps(inside, OutsideHit, InsideHit);
+			hit = _mm512_mask_blend_ps(NearZero2, hit, temp);
+			hit = _mm512_mask_blend_ps(NearZero, hit, temp2);
+
+			__mmask16 accept = valid & ~(NearZero & NearZero2);
+			accept &= _mm512_cmp_ps_mask(hit, zero, _CMP_GT_OQ) & _mm512_cmp_ps_mask(hit, best, _CMP_LT_OQ);
+
+			best = _mm512_mask_blend_ps(accept, best, hit);
+			BestIndex = _mm512_mask_blend_epi32(accept, BestIndex, index);
+			index = _mm512_add_epi32(index, step);
+		}
+
+		alignas(64) float LaneT[16];
+		alignas(64) int LaneIndex[16];
+		_mm512_store_ps(LaneT, best);
+		_mm512_store_si512(LaneIndex, BestIndex);
+
+		int closest;
+		ReduceLanes(LaneT, LaneIndex, 16, t, closest);
+		ScalarTail(x, y, z, r, packed, count, origin, dir, t, closest);
+		return closest;
+	}
+
+	static void CPUID(const int& leaf, const int& subleaf, uint32_t registers[4])
+	{
+	#if defined(_MSC_VER)
+		int values[4];
+		__cpuidex(values, leaf, subleaf);
+		for (int i = 0; i < 4; i++)
+			registers[i] = (uint32_t)values[i];
+	#else
+		__cpuid_count(leaf, subleaf, registers[0], registers[1], registers[2], registers[3]);
+	#endif
+	}
+
+	static uint64_t XGETBV()
+	{
+	#if defined(_MSC_VER)
+		return _xgetbv(0);
+	#else
+		uint32_t low, high;
+		__asm__ volatile("xgetbv" : "=a"(low), "=d"(high) : "c"(0));
+		return ((uint64_t)high << 32) | low;
+	#endif
+	}
+#endif
+
+	static SIMDLevel DetectLevel()
+	{
+	#ifdef HALOGEN_X86
+		uint32_t leaf0[4], leaf1[4], leaf7[4] = { 0, 0, 0, 0 };
+		CPUID(0, 0, leaf0);
+		CPUID(1, 0, leaf1);
+		if (leaf0[0] >= 7)
+			CPUID(7, 0, leaf7);
+
+		const bool SSE2 = (leaf1[3] >> 26) & 1;
+		const bool OSXSAVE = (leaf1[2] >> 27) & 1;
+		const bool AVX = (leaf1[2] >> 28) & 1;
+		const bool AVX2 = (leaf7[1] >> 5) & 1;
+		const bool AVX512F = (leaf7[1] >> 16) & 1;
+
+		const uint64_t XCR0 = OSXSAVE ? XGETBV() : 0;
+		const bool YMMState = (XCR0 & 0x6) == 0x6;							//The OS has to save the wide registers as well
+		const bool ZMMState = (XCR0 & 0xE6) == 0xE6;
+
+		if (AVX512F && ZMMState)
+			return SIMDLevel::AVX512;
+
+		if (AVX && AVX2 && YMMState)
+			return SIMDLevel::AVX2;
+
+		if (SSE2)
+			return SIMDLevel::SSE;
+	#endif
+
+		return SIMDLevel::Scalar;
+	}
+
+	static ClosestHitFunction GetFunction(const SIMDLevel& level)
+	{
+	#ifdef HALOGEN_X86
+		switch (level)
+		{
+			case SIMDLevel::Scalar:
+				break;
+
+			case SIMDLevel::SSE:
+				return ClosestHitSSE;
+
+			case SIMDLevel::AVX2:
+				return ClosestHitAVX2;
+
+			case SIMDLevel::AVX512:
+				return ClosestHitAVX512;
+		}
+	#endif
+
+		return ClosestHitScalar;
+	}
+
+	static SIMDLevel s_BestLevel = DetectLevel();
+	static SIMDLevel s_Level = s_BestLevel;
+	static ClosestHitFunction s_ClosestHit = GetFunction(s_Level);
+
+	bool Supported(const SIMDLevel& level)
+	{
+		return (int)level <= (int)s_BestLevel;
+	}
+
+	SIMDLevel BestLevel()
+	{
+		return s_BestLevel;
+	}
+
+	void SetLevel(const SIMDLevel& level)
+	{
+		if (!Supported(level))
+		{
+			std::println("SIMD level {} is not supported by this CPU, staying on {}", level, s_Level);
+			return;
+		}
+
+		s_Level = level;
+		s_ClosestHit = GetFunction(level);
+	}
+
+	SIMDLevel GetLevel()
+	{
+		return s_Level;
+	}
+
+	int ClosestHit(const SphereStore& spheres, const glm::vec3& origin, const glm::vec3& dir, float& t)
+	{
+		return s_ClosestHit(spheres.X(), spheres.Y(), spheres.Z(), spheres.Radii(), spheres.Size(), origin, dir, t);
+	}
+
+	int ClosestHit(const SphereStore& spheres, const glm::vec3& origin, const glm::vec3& dir, float& t, const SIMDLevel& level)
+	{
+		if (!Supported(level))
+			return ClosestHit(spheres, origin, dir, t);
+
+		return GetFunction(level)(spheres.X(), spheres.Y(), spheres.Z(), spheres.Radii(), spheres.Size(), origin, dir, t);
+	}
+
+	//Occlusion only, stops at the first sphere in the way closer than MaxT rather than looking for the closest one
+	bool AnyHit(const SphereStore& spheres, const glm::vec3& origin, const glm::vec3& dir, const float& MaxT)
+	{
+		const float* x = spheres.X();
+		const float* y = spheres.Y();
+		const float* z = spheres.Z();
+		const float* r = spheres.Radii();
+
+		for (size_t i = 0; i < spheres.Size(); i++)
+		{
+			const float hit = HitDistance(origin, dir, glm::vec3(x[i], y[i], z[i]), r[i]);
+			if (0.0f < hit && hit < MaxT)
+				return true;
+		}
+
+		return false;
+	}
+
+	//Radius of the largest ball around point that no sphere reaches into, negative when point is inside a sphere
+	float ClearRadius(const SphereStore& spheres, const glm::vec3& point)
+	{
+		const float* x = spheres.X();
+		const float* y = spheres.Y();
+		const float* z = spheres.Z();
+		const float* radius = spheres.Radii();
+
+		float clear = FLT_MAX;
+		for (size_t i = 0; i < spheres.Size(); i++)
+		{
+			const float dx = x[i] - point.x;
+			const float dy = y[i] - point.y;
+			const float dz = z[i] - point.z;
+			clear = std::min(clear, std::sqrt(dx * dx + dy * dy + dz * dz) - std::abs(radius[i]));
+		}
+
+		return clear;
+	}
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <string>
+#include <format>
+
+#include <glm.hpp>
+
+#include "SphereStore.h"
+
+enum class SIMDLevel
+{
+	Scalar, SSE, AVX2, AVX512
+};
+
+template<>
+struct std::formatter<SIMDLevel> : std::formatter<std::string>
+{
+	auto format(const SIMDLevel& level, format_context& ctx) const
+	{
+		if (level == SIMDLevel::Scalar)
+			return std::formatter<std::string>::format(std::format("{}", "Scalar"), ctx);
+
+		if (level == SIMDLevel::SSE)
+			return std::formatter<std::string>::format(std::format("{}", "SSE"), ctx);
+
+		if (level == SIMDLevel::AVX2)
+			return std::formatter<std::string>::format(std::format("{}", "AVX2"), ctx);
+
+		if (level == SIMDLevel::AVX512)
+			return std::formatter<std::string>::format(std::format("{}", "AVX-512"), ctx);
+
+		else
+			return std::formatter<std::string>::format(std::format("{}", "<NO_LEVEL>"), ctx);
+	}
+};
+
+//Closest hit of one ray against many spheres, with the same 0.001 self intersection rules as HitPoint in Ray.glsl
+namespace SphereIntersect
+{
+	const float Epsilon = 0.001f;
+	const float NoHit = 99999.999f;
+
+	bool Supported(const SIMDLevel& level);
+	SIMDLevel BestLevel();
+	void SetLevel(const SIMDLevel& level);
+	SIMDLevel GetLevel();
+
+	float HitDistance(const glm::vec3& origin, const glm::vec3& dir, const glm::vec3& center, const float& radius);
+	int ClosestHit(const SphereStore& spheres, const glm::vec3& origin, const glm::vec3& dir, float& t);
+	int ClosestHit(const SphereStore& spheres, const glm::vec3& origin, const glm::vec3& dir, float& t, const SIMDLevel& level);
+	bool AnyHit(const SphereStore& spheres, const glm::vec3& origin, const glm::vec3& dir, const float& MaxT);
+
+	float ClearRadius(const SphereStore& spheres, const glm::vec3& point);
+}
@@ -0,0 +1,164 @@
+#include "SphereStore.h"
+
+SphereHandle SphereStore::Add(const glm::vec3& Position, const float& radius, const int& MaterialIndex)
+{
+	SphereHandle handle;
+	if (m_FreeHandles.empty())
+	{
+		handle = (SphereHandle)m_HandleSlot.size();
+		m_HandleSlot.push_back(0);
+	}
+
+	else
+	{
+		handle = m_FreeHandles.back();
+		m_FreeHandles.pop_back();
+	}
+
+	m_HandleSlot[handle] = (uint32_t)m_SlotHandle.size();
+	m_SlotHandle.push_back(handle);
+
+	m_x.push_back(Position.x);
+	m_y.push_back(Position.y);
+	m_z.push_back(Position.z);
+	m_Radius.push_back(radius);
+	m_MaterialIndex.push_back(MaterialIndex);
+	return handle;
+}
+
+//Set, SetMaterial and Remove ignore handles that were never added or are already removed
+void SphereStore::Set(const SphereHandle& handle, const glm::vec3& Position, const float& radius, const int& MaterialIndex)
+{
+	if (!Valid(handle))
+		return;
+
+	const size_t slot = Slot(handle);
+	m_x[slot] = Position.x;
+	m_y[slot] = Position.y;
+	m_z[slot] = Position.z;
+	m_Radius[slot] = radius;
+	m_MaterialIndex[slot] = MaterialIndex;
+}
+
+void SphereStore::SetMaterial(const SphereHandle& handle, const int& MaterialIndex)
+{
+	if (!Valid(handle))
+		return;
+
+	m_MaterialIndex[Slot(handle)] = MaterialIndex;
+}
+
+void SphereStore::Remove(const SphereHandle& handle)
+{
+	if (!Valid(handle))
+		return;
+
+	const size_t slot = Slot(handle);
+	const size_t last = Size() - 1;
+
+	if (slot != last)
+	{
+		m_x[slot] = m_x[last];
+		m_y[slot] = m_y[last];
+		m_z[slot] = m_z[last];
+		m_Radius[slot] = m_Radius[last];
+		m_MaterialIndex[slot] = m_MaterialIndex[last];
+
+		m_SlotHandle[slot] = m_SlotHandle[last];
+		m_HandleSlot[m_SlotHandle[slot]] = (uint32_t)slot;
+	}
+
+	m_x.pop_back();
+	m_y.pop_back();
+	m_z.pop_back();
+	m_Radius.pop_back();
+	m_MaterialIndex.pop_back();
+	m_SlotHandle.pop_back();
+
+	m_HandleSlot[handle] = UINT32_MAX;
+	m_FreeHandles.push_back(handle);
+}
+
+void SphereStore::Clear()
+{
+	m_x.clear();
+	m_y.clear();
+	m_z.clear();
+	m_Radius.clear();
+	m_MaterialIndex.clear();
+
+	m_SlotHandle.clear();
+	m_HandleSlot.clear();
+	m_FreeHandles.clear();
+}
+
+void SphereStore::Reserve(const size_t& count)
+{
+	m_x.reserve(count);
+	m_y.reserve(count);
+	m_z.reserve(count);
+	m_Radius.reserve(count);
+	m_MaterialIndex.reserve(count);
+	m_SlotHandle.reserve(count);
+	m_HandleSlot.reserve(count);
+}
+
+bool SphereStore::Valid(const SphereHandle& handle) const
+{
+	return handle < m_HandleSlot.size() && m_HandleSlot[handle] != UINT32_MAX;
+}
+
+size_t SphereStore::Slot(const SphereHandle& handle) const
+{
+	return m_HandleSlot[handle];
+}
+
+SphereHandle SphereStore::Handle(const size_t& slot) const
+{
+	return m_SlotHandle[slot];
+}
+
+size_t SphereStore::Size() const
+{
+	return m_Radius.size();
+}
+
+glm::vec3 SphereStore::Position(const size_t& slot) const
+{
+	return glm::vec3(m_x[slot], m_y[slot], m_z[slot]);
+}
+
+float SphereStore::Radius(const size_t& slot) const
+{
+	return m_Radius[slot];
+}
+
+int SphereStore::MaterialIndex(const size_t& slot) const
+{
+	return m_MaterialIndex[slot];
+}
+
+const float* SphereStore::X() const
+{
+	return m_x.data();
+}
+
+const float* SphereStore::Y() const
+{
+	return m_y.data();
+}
+
+const float* SphereStore::Z() const
+{
+	return m_z.data();
+}
+
+const float* SphereStore::Radii() const
+{
+	return m_Radius.data();
+}
+
+const int* SphereStore::MaterialIndices() const
+{
+	return m_MaterialIndex.data();
+}
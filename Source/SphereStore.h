@@ -0,0 +1,82 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <new>
+
+#include <glm.hpp>
+
+template<typename T, size_t Alignment>
+struct AlignedAllocator
+{
+	using value_type = T;
+
+	template<typename U>
+	struct rebind
+	{
+		using other = AlignedAllocator<U, Alignment>;
+	};
+
+	AlignedAllocator() = default;
+
+	template<typename U>
+	AlignedAllocator(const AlignedAllocator<U, Alignment>&) {}
+
+	T* allocate(const size_t count)
+	{
+		return (T*)::operator new(count * sizeof(T), std::align_val_t(Alignment));
+	}
+
+	void deallocate(T* pointer, const size_t)
+	{
+		::operator delete(pointer, std::align_val_t(Alignment));
+	}
+
+	template<typename U>
+	bool operator==(const AlignedAllocator<U, Alignment>&) const { return true; }
+};
+
+template<typename T>
+using AlignedVector = std::vector<T, AlignedAllocator<T, 64>>;
+
+using SphereHandle = uint32_t;
+const SphereHandle InvalidSphere = UINT32_MAX;
+
+//Spheres as separate 64 byte aligned arrays so the SIMD kernels and GPU uploads can read them straight through.
+//Slots stay densely packed, removing a sphere moves the last one into its slot, handles stay valid across that
+class SphereStore
+{
+public:
+	SphereHandle Add(const glm::vec3& Position, const float& radius, const int& MaterialIndex);
+	void Set(const SphereHandle& handle, const glm::vec3& Position, const float& radius, const int& MaterialIndex);
+	void SetMaterial(const SphereHandle& handle, const int& MaterialIndex);
+	void Remove(const SphereHandle& handle);
+	void Clear();
+	void Reserve(const size_t& count);
+
+	bool Valid(const SphereHandle& handle) const;
+	size_t Slot(const SphereHandle& handle) const;
+	SphereHandle Handle(const size_t& slot) const;
+	size_t Size() const;
+
+	glm::vec3 Position(const size_t& slot) const;
+	float Radius(const size_t& slot) const;
+	int MaterialIndex(const size_t& slot) const;
+
+	const float* X() const;
+	const float* Y() const;
+	const float* Z() const;
+	const float* Radii() const;
+	const int* MaterialIndices() const;
+
+private:
+	AlignedVector<float> m_x;
+	AlignedVector<float> m_y;
+	AlignedVector<float> m_z;
+	AlignedVector<float> m_Radius;
+	AlignedVector<int> m_MaterialIndex;
+
+	std::vector<SphereHandle> m_SlotHandle;
+	std::vector<uint32_t> m_HandleSlot;
+	std::vector<SphereHandle> m_FreeHandles;
+};
@@ -0,0 +1,33 @@
+#include "Texture.h"
+
+Texture::Texture()
+{
+	glGenTextures(1, &m_RendererID);
+}
+
+Texture::~Texture()
+{
+	glDeleteTextures(1, &m_RendererID);
+}
+
+void Texture::Load(const float* data, const int& Width, const int& Height)
+{
+	Bind();
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA32F, Width, Height, 0, GL_RGBA, GL_FLOAT, data);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	UnBind();
+}
+
+void Texture::Bind(const int& slot) const
+{
+	glActiveTexture(GL_TEXTURE0 + slot);
+	glBindTexture(GL_TEXTURE_2D, m_RendererID);
+}
+
+void Texture::UnBind() const
+{
+	glBindTexture(GL_TEXTURE_2D, 0);
+}
@@ -0,0 +1,18 @@
+#pragma once
+
+#include <GL/glew.h>
+
+//Float RGBA image read through a sampler2D with bilinear filtering, clamped at the edges
+class Texture
+{
+public:
+	Texture();
+	~Texture();
+
+	void Load(const float* data, const int& Width, const int& Height);
+	void Bind(const int& slot = 0) const;
+	void UnBind() const;
+
+private:
+	unsigned int m_RendererID;
+};
@@ -0,0 +1,54 @@
+#include "TextureBuffer.h"
+
+TextureBuffer::TextureBuffer()
+{
+	glGenBuffers(1, &m_BufferID);
+	glGenTextures(1, &m_TextureID);
+}
+
+TextureBuffer::~TextureBuffer()
+{
+	glDeleteTextures(1, &m_TextureID);
+	glDeleteBuffers(1, &m_BufferID);
+}
+
+void TextureBuffer::Load(const void* data, const size_t& size, const unsigned int& format)
+{
+	int MaxTexels;
+	glGetIntegerv(GL_MAX_TEXTURE_BUFFER_SIZE, &MaxTexels);
+	if (size / 16 > (size_t)MaxTexels)
+		std::println("Texture buffer of {} texels exceeds the driver limit of {}", size / 16, MaxTexels);
+
+	m_Size = size;
+	glBindBuffer(GL_TEXTURE_BUFFER, m_BufferID);
+	glBufferData(GL_TEXTURE_BUFFER, size, data, GL_DYNAMIC_DRAW);
+
+	glBindTexture(GL_TEXTURE_BUFFER, m_TextureID);
+	glTexBuffer(GL_TEXTURE_BUFFER, format, m_BufferID);
+
+	glBindTexture(GL_TEXTURE_BUFFER, 0);
+	glBindBuffer(GL_TEXTURE_BUFFER, 0);
+}
+
+void TextureBuffer::Update(const size_t& offset, const void* data, const size_t& size) const
+{
+	glBindBuffer(GL_TEXTURE_BUFFER, m_BufferID);
+	glBufferSubData(GL_TEXTURE_BUFFER, offset, size, data);
+	glBindBuffer(GL_TEXTURE_BUFFER, 0);
+}
+
+void TextureBuffer::Bind(const int& slot) const
+{
+	glActiveTexture(GL_TEXTURE0 + slot);
+	glBindTexture(GL_TEXTURE_BUFFER, m_TextureID);
+}
+
+void TextureBuffer::UnBind() const
+{
+	glBindTexture(GL_TEXTURE_BUFFER, 0);
+}
+
+size_t TextureBuffer::GetSize() const
+{
+	return m_Size;
+}
@@ -0,0 +1,23 @@
+#pragma once
+
+#include <GL/glew.h>
+#include <print>
+
+//Buffer object read in shaders through a samplerBuffer, one texel per 16 bytes of data
+class TextureBuffer
+{
+public:
+	TextureBuffer();
+	~TextureBuffer();
+
+	void Load(const void* data, const size_t& size, const unsigned int& format = GL_RGBA32F);
+	void Update(const size_t& offset, const void* data, const size_t& size) const;
+	void Bind(const int& slot = 0) const;
+	void UnBind() const;
+	size_t GetSize() const;
+
+private:
+	unsigned int m_BufferID;
+	unsigned int m_TextureID;
+	size_t m_Size = 0;
+};
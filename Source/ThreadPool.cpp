@@ -0,0 +1,88 @@
+#include "ThreadPool.h"
+
+ThreadPool::ThreadPool(const unsigned int& ThreadCount)
+{
+	unsigned int count = ThreadCount;
+	if (count == 0)
+		count = std::max(std::thread::hardware_concurrency(), 1u);
+
+	for (unsigned int i = 1; i < count; i++)						//The dispatching thread works as thread 0
+		m_Workers.emplace_back(&ThreadPool::WorkerLoop, this, i);
+}
+
+ThreadPool::~ThreadPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		m_Stopping = true;
+	}
+
+	m_WorkReady.notify_all();
+
+	for (std::thread& worker : m_Workers)
+		worker.join();
+}
+
+void ThreadPool::Dispatch(const size_t& JobCount, const std::function<void(const size_t& Job, const unsigned int& Thread)>& Task)
+{
+	if (JobCount == 0)
+		return;
+
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		m_Task = &Task;
+		m_JobCount = JobCount;
+		m_NextJob = 0;
+		m_ActiveWorkers = m_Workers.size();
+		m_Generation++;
+	}
+
+	m_WorkReady.notify_all();
+	RunJobs(0);
+
+	std::unique_lock<std::mutex> lock(m_Mutex);
+	m_WorkDone.wait(lock, [this]() { return m_ActiveWorkers == 0; });
+	m_Task = nullptr;
+}
+
+unsigned int ThreadPool::GetThreadCount() const
+{
+	return m_Workers.size() + 1;
+}
+
+void ThreadPool::WorkerLoop(const unsigned int& ThreadIndex)
+{
+	unsigned long long SeenGeneration = 0;
+
+	while (true)
+	{
+		{
+			std::unique_lock<std::mutex> lock(m_Mutex);
+			m_WorkReady.wait(lock, [&]() { return m_Stopping || m_Generation != SeenGeneration; });
+
+			if (m_Stopping)
+				return;
+
+			SeenGeneration = m_Generation;
+		}
+
+		RunJobs(ThreadIndex);
+
+		{
+			std::lock_guard<std::mutex> lock(m_Mutex);
+			m_ActiveWorkers--;
+		}
+
+		m_WorkDone.notify_one();
+	}
+}
+
+void ThreadPool::RunJobs(const unsigned int& ThreadIndex)
+{
+	size_t job = m_NextJob.fetch_add(1);
+	while (job < m_JobCount)
+	{
+		(*m_Task)(job, ThreadIndex);
+		job = m_NextJob.fetch_add(1);
+	}
+}
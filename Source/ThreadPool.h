@@ -0,0 +1,36 @@
+#pragma once
+
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <functional>
+#include <algorithm>
+
+class ThreadPool
+{
+public:
+	ThreadPool(const unsigned int& ThreadCount = 0);
+	~ThreadPool();
+
+	void Dispatch(const size_t& JobCount, const std::function<void(const size_t& Job, const unsigned int& Thread)>& Task);
+	unsigned int GetThreadCount() const;
+
+private:
+	void WorkerLoop(const unsigned int& ThreadIndex);
+	void RunJobs(const unsigned int& ThreadIndex);
+
+private:
+	std::vector<std::thread> m_Workers;
+	std::mutex m_Mutex;
+	std::condition_variable m_WorkReady;
+	std::condition_variable m_WorkDone;
+
+	const std::function<void(const size_t&, const unsigned int&)>* m_Task = nullptr;
+	size_t m_JobCount = 0;
+	std::atomic<size_t> m_NextJob = 0;
+	unsigned int m_ActiveWorkers = 0;
+	unsigned long long m_Generation = 0;
+	bool m_Stopping = false;
+};
@@ -0,0 +1,183 @@
+#include "TileScheduler.h"
+
+#include <algorithm>
+#include <cmath>
+
+TileScheduler::TileScheduler(const int& TileSize)
+	:m_TileSize(TileSize)
+{
+}
+
+void TileScheduler::Resize(const int& FramebufferWidth, const int& FramebufferHeight)
+{
+	m_FramebufferWidth = FramebufferWidth;
+	m_FramebufferHeight = FramebufferHeight;
+	m_Tiles.clear();
+
+	for (int y = 0; y < m_FramebufferHeight; y += m_TileSize)
+	{
+		for (int x = 0; x < m_FramebufferWidth; x += m_TileSize)
+		{
+			Tile tile;
+			tile.x = x;
+			tile.y = y;
+			tile.Width = std::min(m_TileSize, m_FramebufferWidth - x);
+			tile.Height = std::min(m_TileSize, m_FramebufferHeight - y);
+			m_Tiles.push_back(tile);
+		}
+	}
+
+	const float CenterX = m_FramebufferWidth / 2.0f;
+	const float CenterY = m_FramebufferHeight / 2.0f;
+	auto DistanceToCenter = [&](const Tile& tile)
+	{
+		float dx = tile.x + tile.Width / 2.0f - CenterX;
+		float dy = tile.y + tile.Height / 2.0f - CenterY;
+		return dx * dx + dy * dy;
+	};
+
+	std::stable_sort(m_Tiles.begin(), m_Tiles.end(), [&](const Tile& a, const Tile& b) { return DistanceToCenter(a) < DistanceToCenter(b); });
+}
+
+void TileScheduler::SetTileSize(const int& TileSize)
+{
+	m_TileSize = std::max(TileSize, 1);
+	Resize(m_FramebufferWidth, m_FramebufferHeight);
+}
+
+int TileScheduler::GetTileSize() const
+{
+	return m_TileSize;
+}
+
+void TileScheduler::Run(ThreadPool& pool, const std::function<void(Tile& tile, const unsigned int& thread)>& Task)
+{
+	const unsigned int ThreadCount = pool.GetThreadCount();
+
+	if (m_Queues.size() != ThreadCount)
+	{
+		m_Queues.clear();
+		for (unsigned int i = 0; i < ThreadCount; i++)
+			m_Queues.push_back(std::make_unique<WorkQueue>());
+	}
+
+	size_t queued = 0;
+	for (size_t i = 0; i < m_Tiles.size(); i++)							//Round robin keeps the center tiles at the front of every queue
+	{
+		if (!Converged(m_Tiles[i]))
+			m_Queues[queued++ % ThreadCount]->Tiles.push_back(i);
+	}
+
+	m_CompletedTiles = 0;
+	m_PassTiles = queued;
+
+	pool.Dispatch(ThreadCount, [&](const size_t&, const unsigned int& thread)
+	{
+		size_t index;
+		while (PopOwn(thread, index) || Steal(thread, index))
+		{
+			Tile& tile = m_Tiles[index];
+			Task(tile, thread);
+			tile.Samples++;
+			m_CompletedTiles++;
+		}
+	});
+}
+
+void TileScheduler::ResetSamples()
+{
+	for (Tile& tile : m_Tiles)
+	{
+		tile.Samples = 0;
+		tile.Error = 1.0f;
+	}
+}
+
+//Tiles sampled MinSamples times with an error below threshold stop being run, 0 runs every tile
+void TileScheduler::SetNoiseThreshold(const float& threshold, const unsigned int& MinSamples)
+{
+	m_NoiseThreshold = threshold;
+	m_MinSamples = MinSamples;
+}
+
+bool TileScheduler::Converged(const Tile& tile) const
+{
+	return m_NoiseThreshold > 0.0f && tile.Samples >= m_MinSamples && tile.Error < m_NoiseThreshold;
+}
+
+//Fraction of the pixels the next pass samples
+float TileScheduler::ActivePixels() const
+{
+	size_t active = 0;
+	for (const Tile& tile : m_Tiles)
+	{
+		if (!Converged(tile))
+			active += (size_t)tile.Width * tile.Height;
+	}
+
+	return (float)active / (float)std::max((size_t)m_FramebufferWidth * m_FramebufferHeight, (size_t)1);
+}
+
+//RMS over every pixel, tiles weighted by their area
+float TileScheduler::RelativeError() const
+{
+	double sum = 0.0;
+	for (const Tile& tile : m_Tiles)
+		sum += (double)tile.Error * tile.Error * tile.Width * tile.Height;
+
+	return (float)std::sqrt(sum / (double)std::max((size_t)m_FramebufferWidth * m_FramebufferHeight, (size_t)1));
+}
+
+const std::vector<Tile>& TileScheduler::GetTiles() const
+{
+	return m_Tiles;
+}
+
+//Fraction of the tiles queued for the pass that are done, for watching a pass from another thread
+float TileScheduler::PassProgress() const
+{
+	const size_t tiles = m_PassTiles;
+	if (tiles == 0)
+		return 1.0f;
+
+	return (float)m_CompletedTiles / (float)tiles;
+}
+
+size_t TileScheduler::StolenTiles() const
+{
+	return m_StolenTiles;
+}
+
+bool TileScheduler::PopOwn(const unsigned int& thread, size_t& tile)
+{
+	WorkQueue& queue = *m_Queues[thread];
+	std::lock_guard<std::mutex> lock(queue.Mutex);
+
+	if (queue.Tiles.empty())
+		return false;
+
+	tile = queue.Tiles.front();
+	queue.Tiles.pop_front();
+	return true;
+}
+
+bool TileScheduler::Steal(const unsigned int& thread, size_t& tile)
+{
+	const size_t QueueCount = m_Queues.size();
+
+	for (size_t offset = 1; offset < QueueCount; offset++)
+	{
+		WorkQueue& victim = *m_Queues[(thread + offset) % QueueCount];
+		std::lock_guard<std::mutex> lock(victim.Mutex);
+
+		if (victim.Tiles.empty())
+			continue;
+
+		tile = victim.Tiles.back();									//Steal from the far end, the owner keeps working near the center
+		victim.Tiles.pop_back();
+		m_StolenTiles++;
+		return true;
+	}
+
+	return false;
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <vector>
+#include <deque>
+#include <mutex>
+#include <atomic>
+#include <memory>
+#include <functional>
+
+#include "ThreadPool.h"
+
+struct Tile
+{
+	int x = 0;
+	int y = 0;
+	int Width = 0;
+	int Height = 0;
+	unsigned int Samples = 0;
+	float Error = 1.0f;															//RMS relative error of its pixels, set by the task
+};
+
+//Splits the framebuffer into tiles ordered from the center outward and hands them out through
+//per thread deques, idle threads steal from the back of the others so expensive regions don't stall a pass.
+//Converged tiles are left out of the passes
+class TileScheduler
+{
+public:
+	TileScheduler(const int& TileSize = 32);
+
+	void Resize(const int& FramebufferWidth, const int& FramebufferHeight);
+	void SetTileSize(const int& TileSize);
+	int GetTileSize() const;
+
+	void Run(ThreadPool& pool, const std::function<void(Tile& tile, const unsigned int& thread)>& Task);
+	void ResetSamples();
+	void SetNoiseThreshold(const float& threshold, const unsigned int& MinSamples);
+	bool Converged(const Tile& tile) const;
+	float ActivePixels() const;
+	float RelativeError() const;
+
+	const std::vector<Tile>& GetTiles() const;
+	float PassProgress() const;
+	size_t StolenTiles() const;
+
+private:
+	struct WorkQueue
+	{
+		std::mutex Mutex;
+		std::deque<size_t> Tiles;
+	};
+
+	bool PopOwn(const unsigned int& thread, size_t& tile);
+	bool Steal(const unsigned int& thread, size_t& tile);
+
+private:
+	int m_TileSize;
+	int m_FramebufferWidth = 0;
+	int m_FramebufferHeight = 0;
+	float m_NoiseThreshold = 0.0f;
+	unsigned int m_MinSamples = 0;
+
+	std::vector<Tile> m_Tiles;
+	std::vector<std::unique_ptr<WorkQueue>> m_Queues;
+	std::atomic<size_t> m_PassTiles = 0;										//Queued for the pass running, the converged ones are left out
+	std::atomic<size_t> m_CompletedTiles = 0;
+	std::atomic<size_t> m_StolenTiles = 0;
+};
@@ -0,0 +1,61 @@
+#include "TimerQuery.h"
+
+TimerQuery::TimerQuery()
+{
+	glGenQueries(Count, m_Queries);
+}
+
+TimerQuery::~TimerQuery()
+{
+	glDeleteQueries(Count, m_Queries);
+}
+
+//label travels with the query to Result, the work it timed for instance
+bool TimerQuery::Begin(const int& label)
+{
+	if (m_Running || m_Begun - m_Read == Count)
+		return false;
+
+	const unsigned int slot = m_Begun % Count;
+	m_Labels[slot] = label;
+	glBeginQuery(GL_TIME_ELAPSED, m_Queries[slot]);
+	m_Running = true;
+	return true;
+}
+
+void TimerQuery::End()
+{
+	if (!m_Running)
+		return;
+
+	glEndQuery(GL_TIME_ELAPSED);
+	m_Running = false;
+	m_Begun++;
+}
+
+//Oldest result not read yet, false while there is none or it's still being measured
+bool TimerQuery::Result(double& milliseconds, int& label)
+{
+	if (m_Read == m_Begun)
+		return false;
+
+	const unsigned int slot = m_Read % Count;
+	int available = 0;
+	glGetQueryObjectiv(m_Queries[slot], GL_QUERY_RESULT_AVAILABLE, &available);
+	if (!available)
+		return false;
+
+	GLuint64 nanoseconds = 0;
+	glGetQueryObjectui64v(m_Queries[slot], GL_QUERY_RESULT, &nanoseconds);
+	milliseconds = (double)nanoseconds / 1e6;
+	label = m_Labels[slot];
+	m_Read++;
+	return true;
+}
+
+//Forgets the results still pending, for when they no longer describe the work to come
+void TimerQuery::Discard()
+{
+	End();
+	m_Read = m_Begun;
+}
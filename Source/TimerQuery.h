@@ -0,0 +1,28 @@
+#pragma once
+
+#include <GL/glew.h>
+
+//GL_TIME_ELAPSED queries kept in a ring so the GPU time of a pass is picked up a few passes later, once it's
+//available, instead of waiting on it. Only one query runs at a time, a pass begun while the ring is full of unread
+//results goes untimed
+class TimerQuery
+{
+public:
+	TimerQuery();
+	~TimerQuery();
+
+	bool Begin(const int& label = 0);
+	void End();
+	bool Result(double& milliseconds, int& label);
+	void Discard();
+
+public:
+	static const int Count = 4;
+
+private:
+	unsigned int m_Queries[Count];
+	int m_Labels[Count] = {};
+	unsigned int m_Begun = 0;
+	unsigned int m_Read = 0;
+	bool m_Running = false;
+};
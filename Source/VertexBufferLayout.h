@@ -1,7 +1,6 @@
 #pragma once
 
 #include<GL/glew.h>
-#include<GLFW/glfw3.h>
 #include<print>
 #include<vector>
 
@@ -30,27 +29,28 @@ public:
 		std::println("Unmatched Type");
 	}
 
-	template<>
-	void Push<float>(unsigned int count)
-	{
-		m_LayoutArray.push_back({ GL_FLOAT, count, GL_FALSE });
-		m_Stride += sizeof(float) * count;
-	}
+	const std::vector<VertexAttribute>& GetAttributeArray() const;
+	const unsigned int& GetStride() const;
+};
 
-	template<>
-	void Push<int>(unsigned int count)
-	{
-		m_LayoutArray.push_back({ GL_INT, count, GL_FALSE });
-		m_Stride += sizeof(int) * count;
-	}
+//Explicit specializations at namespace scope, GCC and Clang don't take them inside the class
+template<>
+inline void VertexBufferLayout::Push<float>(unsigned int count)
+{
+	m_LayoutArray.push_back({ GL_FLOAT, count, GL_FALSE });
+	m_Stride += sizeof(float) * count;
+}
 
-	template<>
-	void Push<char>(unsigned int count)
-	{
-		m_LayoutArray.push_back({ GL_BYTE, count, GL_TRUE });
-		m_Stride += sizeof(char) * count;
-	}
+template<>
+inline void VertexBufferLayout::Push<int>(unsigned int count)
+{
+	m_LayoutArray.push_back({ GL_INT, count, GL_FALSE });
+	m_Stride += sizeof(int) * count;
+}
 
-	const std::vector<VertexAttribute>& GetAttributeArray() const;
-	const unsigned int& GetStride() const;
-};
\ No newline at end of file
+template<>
+inline void VertexBufferLayout::Push<char>(unsigned int count)
+{
+	m_LayoutArray.push_back({ GL_BYTE, count, GL_TRUE });
+	m_Stride += sizeof(char) * count;
+}
\ No newline at end of file
@@ -0,0 +1,293 @@
+#include "Wavefront.h"
+
+namespace CPU
+{
+	const std::vector<glm::vec3>& Wavefront::Trace(const Tile& tile, const Uniforms& uniforms, const uint32_t& sample)
+	{
+		m_Colors.assign((size_t)tile.Width * tile.Height, glm::vec3(0.0f));
+		if (uniforms.WriteAOVs)
+			m_FirstHits.assign((size_t)tile.Width * tile.Height, FirstHit());
+
+		Generate(tile, uniforms, sample);
+
+		//Paths still alive after max_depth bounces keep only the sun light gathered so far, same as the megakernel
+		for (int depth = 0; depth < uniforms.max_depth && !m_Active.empty(); depth++)
+		{
+			Extend(uniforms);
+			Classify(uniforms);
+
+			ShadeMiss(uniforms);
+			MarchBlackHole(uniforms);
+
+			SortQueue(m_Diffuse, uniforms);
+			ShadeDiffuse(uniforms, depth);
+
+			SortQueue(m_Glass, uniforms);
+			ShadeGlass(uniforms, depth);
+		}
+
+		return m_Colors;
+	}
+
+	uint64_t Wavefront::ExtendedRays() const
+	{
+		return m_ExtendedRays;
+	}
+
+	const std::vector<FirstHit>& Wavefront::FirstHits() const
+	{
+		return m_FirstHits;
+	}
+
+	void Wavefront::Generate(const Tile& tile, const Uniforms& uniforms, const uint32_t& sample)
+	{
+		const size_t count = (size_t)tile.Width * tile.Height;
+		m_OriginX.resize(count);
+		m_OriginY.resize(count);
+		m_OriginZ.resize(count);
+		m_DirX.resize(count);
+		m_DirY.resize(count);
+		m_DirZ.resize(count);
+		m_ColorR.resize(count);
+		m_ColorG.resize(count);
+		m_ColorB.resize(count);
+		m_HitT.resize(count);
+		m_ScatterPdf.resize(count);
+		m_HitSlot.resize(count);
+		m_Pixel.resize(count);
+		m_Samplers.clear();
+		m_BHInfo.resize(count);
+
+		m_Active.clear();
+		for (int y = 0; y < tile.Height; y++)
+		{
+			for (int x = 0; x < tile.Width; x++)
+			{
+				const uint32_t path = (uint32_t)m_Active.size();
+				m_Samplers.emplace_back(uniforms.Sampling, uniforms.CropX + tile.x + x, uniforms.CropY + tile.y + y, sample);
+				const Ray ray = GetRay(SensorPosition(tile.x + x, tile.y + y, uniforms), uniforms, m_Samplers[path]);
+
+				StoreRay(path, ray);
+				m_Pixel[path] = (uint32_t)y * tile.Width + x;
+
+				if (uniforms.RenderBlackHole)
+					StartBlackHole(ray, uniforms, m_BHInfo[path]);
+
+				m_Active.push_back(path);
+			}
+		}
+	}
+
+	void Wavefront::Extend(const Uniforms& uniforms)
+	{
+		const bool UseBVH = !uniforms.BVH.Empty();
+		for (const uint32_t& path : m_Active)
+		{
+			const glm::vec3 origin = glm::vec3(m_OriginX[path], m_OriginY[path], m_OriginZ[path]);
+			const glm::vec3 dir = glm::vec3(m_DirX[path], m_DirY[path], m_DirZ[path]);
+
+			float t = -1.0f;
+			m_HitSlot[path] = UseBVH ? uniforms.BVH.ClosestHit(origin, dir, t) : SphereIntersect::ClosestHit(uniforms.Spheres, origin, dir, t);
+			m_HitT[path] = t;
+		}
+
+		m_ExtendedRays += m_Active.size();
+	}
+
+	//Emissive hits end here, everything else goes to the queue of the stage that handles it. Colors accumulate since
+	//next event estimation adds light at every Lambertian vertex
+	void Wavefront::Classify(const Uniforms& uniforms)
+	{
+		m_Diffuse.clear();
+		m_Glass.clear();
+		m_BlackHole.clear();
+		m_Miss.clear();
+
+		const float MarchDistance = 2.0f * uniforms.StepSize;
+		for (const uint32_t& path : m_Active)
+		{
+			if (uniforms.RenderBlackHole && m_HitT[path] > MarchDistance && !m_BHInfo[path].Escaped)
+			{
+				m_BlackHole.push_back(path);
+				continue;
+			}
+
+			if (m_HitSlot[path] < 0)
+			{
+				m_Miss.push_back(path);
+				continue;
+			}
+
+			const Material& material = uniforms.MaterialList[uniforms.Spheres.MaterialIndex(m_HitSlot[path])];
+			if (uniforms.WriteAOVs && m_FirstHits[m_Pixel[path]].MatIndex < 0)
+				RecordSurface(m_FirstHits[m_Pixel[path]], LoadRay(path), LoadHit(path, uniforms), uniforms);
+
+			if (material.Emission != 0.0f)
+				m_Colors[m_Pixel[path]] += glm::vec3(m_ColorR[path], m_ColorG[path], m_ColorB[path]) * material.Albedo * material.Emission * EmissionWeight(LoadRay(path), LoadHit(path, uniforms), uniforms);
+
+			else if (material.Type == GlassType)
+				m_Glass.push_back(path);
+
+			else
+				m_Diffuse.push_back(path);
+		}
+
+		m_Active.clear();
+	}
+
+	//Counting sort on material index and direction octant, stable so equal keys keep their pixel order
+	void Wavefront::SortQueue(std::vector<uint32_t>& queue, const Uniforms& uniforms)
+	{
+		if (queue.size() < 2)
+			return;
+
+		m_SortKeys.resize(queue.size());
+		m_SortOffsets.assign(uniforms.MaterialList.size() * 8 + 1, 0);
+		for (size_t i = 0; i < queue.size(); i++)
+		{
+			const uint32_t path = queue[i];
+			const uint32_t octant = (m_DirX[path] < 0.0f ? 1 : 0) | (m_DirY[path] < 0.0f ? 2 : 0) | (m_DirZ[path] < 0.0f ? 4 : 0);
+			m_SortKeys[i] = (uint32_t)uniforms.Spheres.MaterialIndex(m_HitSlot[path]) * 8 + octant;
+			m_SortOffsets[m_SortKeys[i] + 1]++;
+		}
+
+		for (size_t key = 1; key < m_SortOffsets.size(); key++)
+			m_SortOffsets[key] += m_SortOffsets[key - 1];
+
+		m_SortScratch.resize(queue.size());
+		for (size_t i = 0; i < queue.size(); i++)
+			m_SortScratch[m_SortOffsets[m_SortKeys[i]]++] = queue[i];
+
+		queue.swap(m_SortScratch);
+	}
+
+	void Wavefront::ShadeDiffuse(const Uniforms& uniforms, const int& depth)
+	{
+		for (const uint32_t& path : m_Diffuse)
+		{
+			Sampler& sampler = m_Samplers[path];
+			sampler.StartBounce(depth);
+
+			Ray ray = LoadRay(path);
+			const HitRecord record = LoadHit(path, uniforms);
+			const Material& material = uniforms.MaterialList[record.HitSphere.MatIndex];
+
+			Diffuse diffuse;
+			diffuse.Albedo = material.Albedo;
+			diffuse.Roughness = material.Roughness;
+			diffuse.Emission = material.Emission;
+			Scatter(diffuse, ray, record, sampler);
+			m_Colors[m_Pixel[path]] += DirectLight(ray, record, diffuse, uniforms, sampler);
+
+			if (uniforms.RenderBlackHole)
+				ComputeBlackHoleInfo(ray, m_BHInfo[path]);
+
+			if (depth + 1 >= uniforms.RouletteDepth && !Survives(ray, sampler))
+				continue;
+
+			StoreRay(path, ray);
+			m_Active.push_back(path);
+		}
+	}
+
+	void Wavefront::ShadeGlass(const Uniforms& uniforms, const int& depth)
+	{
+		for (const uint32_t& path : m_Glass)
+		{
+			Sampler& sampler = m_Samplers[path];
+			sampler.StartBounce(depth);
+
+			Ray ray = LoadRay(path);
+			const HitRecord record = LoadHit(path, uniforms);
+			const Material& material = uniforms.MaterialList[record.HitSphere.MatIndex];
+
+			Glass glass;
+			glass.Albedo = material.Albedo;
+			glass.IOR = material.IOR;
+			Scatter(glass, ray, record, sampler);
+			ray.ScatterPdf = 0.0f;
+
+			if (uniforms.RenderBlackHole)
+				ComputeBlackHoleInfo(ray, m_BHInfo[path]);
+
+			if (depth + 1 >= uniforms.RouletteDepth && !Survives(ray, sampler))
+				continue;
+
+			StoreRay(path, ray);
+			m_Active.push_back(path);
+		}
+	}
+
+	void Wavefront::MarchBlackHole(const Uniforms& uniforms)
+	{
+		for (const uint32_t& path : m_BlackHole)
+		{
+			Ray ray = LoadRay(path);
+			ray.ScatterPdf = 0.0f;
+			BlackHoleInfo& BHInfo = m_BHInfo[path];
+
+			bool captured;
+			if (BHInfo.Deflect && BHInfo.r > BHInfo.Influence.Radius)
+				captured = DeflectRay(ray, BHInfo, uniforms.Deflection, m_HitT[path]);
+
+			else
+				captured = BHInfo.Captured || UpdateRay(ray, BHInfo, 0.5f * m_HitT[path]);
+
+			if (captured)
+				continue;
+
+			StoreRay(path, ray);
+			m_Active.push_back(path);
+		}
+	}
+
+	void Wavefront::ShadeMiss(const Uniforms& uniforms)
+	{
+		for (const uint32_t& path : m_Miss)
+		{
+			const Ray ray = LoadRay(path);
+			if (uniforms.WriteAOVs && m_FirstHits[m_Pixel[path]].MatIndex < 0)
+				RecordSky(m_FirstHits[m_Pixel[path]], ray, uniforms);
+
+			m_Colors[m_Pixel[path]] += WorldColor(ray.RayDir, uniforms, SunWeight(ray, uniforms)) * ray.RayColor;
+		}
+	}
+
+	Ray Wavefront::LoadRay(const uint32_t& path) const
+	{
+		Ray ray;
+		ray.RayOrigin = glm::vec3(m_OriginX[path], m_OriginY[path], m_OriginZ[path]);
+		ray.RayDir = glm::vec3(m_DirX[path], m_DirY[path], m_DirZ[path]);
+		ray.RayColor = glm::vec3(m_ColorR[path], m_ColorG[path], m_ColorB[path]);
+		ray.ScatterPdf = m_ScatterPdf[path];
+		return ray;
+	}
+
+	void Wavefront::StoreRay(const uint32_t& path, const Ray& ray)
+	{
+		m_OriginX[path] = ray.RayOrigin.x;
+		m_OriginY[path] = ray.RayOrigin.y;
+		m_OriginZ[path] = ray.RayOrigin.z;
+		m_DirX[path] = ray.RayDir.x;
+		m_DirY[path] = ray.RayDir.y;
+		m_DirZ[path] = ray.RayDir.z;
+		m_ColorR[path] = ray.RayColor.x;
+		m_ColorG[path] = ray.RayColor.y;
+		m_ColorB[path] = ray.RayColor.z;
+		m_ScatterPdf[path] = ray.ScatterPdf;
+	}
+
+	HitRecord Wavefront::LoadHit(const uint32_t& path, const Uniforms& uniforms) const
+	{
+		const int slot = m_HitSlot[path];
+
+		HitRecord record;
+		record.Hit = true;
+		record.t = m_HitT[path];
+		record.HitSphere.Position = uniforms.Spheres.Position(slot);
+		record.HitSphere.Radius = uniforms.Spheres.Radius(slot);
+		record.HitSphere.MatIndex = uniforms.Spheres.MaterialIndex(slot);
+		record.Slot = slot;
+		return record;
+	}
+}
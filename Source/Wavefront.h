@@ -0,0 +1,67 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+
+#include <glm.hpp>
+
+#include "CPU Ray Tracer.h"
+
+namespace CPU
+{
+	//Stream execution of TraceRay. All paths of a tile live in one SoA pool and advance a bounce at a time through
+	//generate, extend, then the shade diffuse, shade glass, black hole march and miss queues. The shading queues are
+	//sorted by material and direction octant, survivors are compacted back into the active queue for the next extend
+	class Wavefront
+	{
+	public:
+		const std::vector<glm::vec3>& Trace(const Tile& tile, const Uniforms& uniforms, const uint32_t& sample);
+		uint64_t ExtendedRays() const;
+		const std::vector<FirstHit>& FirstHits() const;
+
+	private:
+		void Generate(const Tile& tile, const Uniforms& uniforms, const uint32_t& sample);
+		void Extend(const Uniforms& uniforms);
+		void Classify(const Uniforms& uniforms);
+		void SortQueue(std::vector<uint32_t>& queue, const Uniforms& uniforms);
+		void ShadeDiffuse(const Uniforms& uniforms, const int& depth);
+		void ShadeGlass(const Uniforms& uniforms, const int& depth);
+		void MarchBlackHole(const Uniforms& uniforms);
+		void ShadeMiss(const Uniforms& uniforms);
+
+		Ray LoadRay(const uint32_t& path) const;
+		void StoreRay(const uint32_t& path, const Ray& ray);
+		HitRecord LoadHit(const uint32_t& path, const Uniforms& uniforms) const;
+
+	private:
+		AlignedVector<float> m_OriginX;
+		AlignedVector<float> m_OriginY;
+		AlignedVector<float> m_OriginZ;
+		AlignedVector<float> m_DirX;
+		AlignedVector<float> m_DirY;
+		AlignedVector<float> m_DirZ;
+		AlignedVector<float> m_ColorR;
+		AlignedVector<float> m_ColorG;
+		AlignedVector<float> m_ColorB;
+		AlignedVector<float> m_ScatterPdf;
+		AlignedVector<float> m_HitT;
+		std::vector<int> m_HitSlot;
+		std::vector<uint32_t> m_Pixel;
+		std::vector<Sampler> m_Samplers;
+		std::vector<BlackHoleInfo> m_BHInfo;										//Only touched by the march and after a scatter
+
+		std::vector<uint32_t> m_Active;
+		std::vector<uint32_t> m_Diffuse;
+		std::vector<uint32_t> m_Glass;
+		std::vector<uint32_t> m_BlackHole;
+		std::vector<uint32_t> m_Miss;
+
+		std::vector<uint32_t> m_SortKeys;
+		std::vector<uint32_t> m_SortOffsets;
+		std::vector<uint32_t> m_SortScratch;
+
+		std::vector<glm::vec3> m_Colors;										//Radiance of each tile pixel, row major within the tile
+		std::vector<FirstHit> m_FirstHits;										//Same layout, only filled in when uniforms.WriteAOVs is set
+		uint64_t m_ExtendedRays = 0;
+	};
+}
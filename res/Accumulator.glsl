@@ -16,15 +16,77 @@ void main()
 #version 330 core
 
 uniform sampler2D CurrentSampleImage;
+uniform sampler2D CurrentMoments;
 uniform sampler2D Accumulated;
-uniform float CurrentSample;
+uniform sampler2D AccumulatedMoments;
+
+const bool WriteAOVs = false;
+uniform sampler2D CurrentAlbedo;
+uniform sampler2D CurrentNormal;
+uniform sampler2D CurrentIds;
+uniform sampler2D AccumulatedAlbedo;
+uniform sampler2D AccumulatedNormal;
+uniform sampler2D AccumulatedIds;
 
 in vec2 f_TexCoords;
 
-out vec4 FragmentColor;
+layout(location = 0) out vec4 FragmentColor;
+layout(location = 1) out vec4 Moments;
+layout(location = 2) out vec4 Albedo;
+layout(location = 3) out vec4 NormalDepth;
+layout(location = 4) out vec4 Ids;
+
+//Albedo, normal and depth are summed like the color, so the normals of their mean come out shorter than 1 where the
+//samples disagree. The ids are those of the first sample, an average of them wouldn't name anything
+void AccumulateAOVs(float n, bool traced)
+{
+	vec4 albedo = texture(AccumulatedAlbedo, f_TexCoords);
+	vec4 normal = texture(AccumulatedNormal, f_TexCoords);
+	vec4 ids = texture(AccumulatedIds, f_TexCoords);
+
+	if(traced)
+	{
+		albedo += texture(CurrentAlbedo, f_TexCoords);
+		normal += texture(CurrentNormal, f_TexCoords);
+		ids = n == 0.0 ? texture(CurrentIds, f_TexCoords) : ids;
+	}
+
+	Albedo = albedo;
+	NormalDepth = normal;
+	Ids = ids;
+}
 
+//Reads the last pass from one set of textures and writes the next set, RayTracer swaps them after every pass. The
+//color holds the sum of the samples and of their path lengths, Moments the sum of their squared luminance, the samples
+//taken, the squared relative error of the mean and whether the pixel was traced this pass. A pass adds the sums of
+//however many samples Ray Trace.frag took, none in converged tiles
 void main()
 {
-	FragmentColor = texture(CurrentSampleImage, f_TexCoords) + CurrentSample * texture(Accumulated, f_TexCoords);
-	FragmentColor = FragmentColor / (CurrentSample + 1.0);
+	vec4 current = texture(CurrentSampleImage, f_TexCoords);
+	vec4 pass = texture(CurrentMoments, f_TexCoords);
+	vec4 accumulated = texture(Accumulated, f_TexCoords);
+	vec4 moments = texture(AccumulatedMoments, f_TexCoords);
+
+	if(pass.y == 0.0)
+	{
+		FragmentColor = accumulated;
+		Moments = vec4(moments.xyz, 0.0);
+
+		if(WriteAOVs)
+			AccumulateAOVs(moments.y, false);
+		return;
+	}
+
+	const vec3 Luminance = vec3(0.2126, 0.7152, 0.0722);
+	float n = moments.y + pass.y;
+	FragmentColor = accumulated + current;
+
+	float mean = dot(FragmentColor.rgb, Luminance) / n;
+	float SquareSum = moments.x + pass.x;
+	float variance = max(SquareSum / n - mean * mean, 0.0) / max(n - 1.0, 1.0);
+	float error = n > 1.0 ? variance / ((mean + 0.1) * (mean + 0.1)) : 1.0;
+	Moments = vec4(SquareSum, n, error, 1.0);
+
+	if(WriteAOVs)
+		AccumulateAOVs(moments.y, true);
 }
@@ -24,12 +24,33 @@ void main()
 #version 330 core
 
 uniform sampler2D Image;
+uniform vec2 RenderResolution;
 in vec2 f_TexCoords;
 
 out vec4 FragmentColor;
 
+//The image is drawn nearest so its pixels stay sharp under zoom, but one rendered below the resolution, see
+//Navigation.h, is filtered bilinearly up to it
+vec4 Upscaled(vec2 TexCoords)
+{
+	ivec2 size = textureSize(Image, 0);
+	vec2 position = TexCoords * vec2(size) - 0.5;
+	ivec2 corner = ivec2(floor(position));
+	vec2 weight = position - floor(position);
+
+	vec4 bottom = mix(texelFetch(Image, clamp(corner, ivec2(0), size - 1), 0), texelFetch(Image, clamp(corner + ivec2(1, 0), ivec2(0), size - 1), 0), weight.x);
+	vec4 top = mix(texelFetch(Image, clamp(corner + ivec2(0, 1), ivec2(0), size - 1), 0), texelFetch(Image, clamp(corner + ivec2(1, 1), ivec2(0), size - 1), 0), weight.x);
+	return mix(bottom, top, weight.y);
+}
+
 void main()
 {
+	if(float(textureSize(Image, 0).x) < RenderResolution.x)
+	{
+		FragmentColor = Upscaled(f_TexCoords);
+		return;
+	}
+
 	vec4 colorOut = texture(Image, f_TexCoords);
 	FragmentColor = colorOut;
 }
@@ -16,8 +16,13 @@ void main()
 #version 330 core
 
 uniform sampler2D Image;
+uniform sampler2D Moments;										//Samples of each pixel in y, the image and the AOVs are sums over them
 uniform float exposure;
 uniform float gamma;
+uniform int DisplayedAOV;											//AOV in the order of AOV.h, 0 shows the image itself
+uniform sampler2D AOVAlbedo;
+uniform sampler2D AOVNormal;
+uniform sampler2D AOVIds;
 in vec2 f_TexCoords;
 
 out vec4 FragmentColor;
@@ -31,11 +36,42 @@ vec4 ToneMapper(in vec4 color)
 	return color;
 }
 
+vec3 IdColor(float id)
+{
+	if(id < 0.0)
+		return vec3(0.0);
+
+	return fract(sin(vec3(id + 1.0) * vec3(12.9898, 78.233, 37.719)) * 43758.5453);
+}
+
+vec3 ShowAOV(int aov)
+{
+	vec4 ids = texture(AOVIds, f_TexCoords);
+	float n = max(texture(Moments, f_TexCoords).y, 1.0);
+	if(aov == 1)
+		return pow(texture(AOVAlbedo, f_TexCoords).rgb / n, vec3(1.0/gamma));
+
+	vec4 normal = texture(AOVNormal, f_TexCoords);
+	if(aov == 2)
+		return dot(normal.xyz, normal.xyz) > 0.0 ? 0.5 * normalize(normal.xyz) + 0.5 : vec3(0.0);
+
+	if(aov == 3)
+		return ids.y < 0.0 ? vec3(0.0) : vec3(1.0 / (1.0 + 0.2 * normal.w / n));
+
+	return IdColor(aov == 4 ? ids.x : ids.y);
+}
+
 void main()
 {
-	vec4 colorOut = texture(Image, f_TexCoords);
+	if(DisplayedAOV != 0)
+	{
+		FragmentColor = vec4(ShowAOV(DisplayedAOV), 1.0);
+		return;
+	}
+
+	vec4 colorOut = vec4(texture(Image, f_TexCoords).rgb / max(texture(Moments, f_TexCoords).y, 1.0), 1.0);
 	colorOut *= vec4(vec3(exposure/10.0), 1.0);
 	colorOut = ToneMapper(colorOut);
 	colorOut = pow(colorOut, vec4(1.0/gamma));
-	FragmentColor = colorOut;
+	FragmentColor = vec4(colorOut.rgb, 1.0);
 }
@@ -4,10 +4,34 @@
 
 in vec3 positions;
 
-out vec4 FragmentColor;
+layout(location = 0) out vec4 FragmentColor;						//Sum of the samples of the pass, then of their path lengths
+layout(location = 1) out vec4 PassMoments;						//Sum of their squared luminance, then how many were taken
+layout(location = 2) out vec4 AOVAlbedo;							//Sums like the color, the sample count in w
+layout(location = 3) out vec4 AOVNormal;							//Normal, then depth in w
+layout(location = 4) out vec4 AOVIds;								//Material index, then sphere slot, of the first sample
 
+//RMS relative error of the pixels of the tile, read off the mip level covering it
+bool TileConverged(ivec2 pixel)
+{
+	if(NoiseThreshold <= 0.0)
+		return false;
+
+	ivec2 tile = min(pixel >> AdaptiveTileLevel, textureSize(PixelMoments, AdaptiveTileLevel) - 1);
+	vec4 moments = texelFetch(PixelMoments, tile, AdaptiveTileLevel);
+	return moments.y >= float(AdaptiveMinSamples) && sqrt(moments.z) < NoiseThreshold;
+}
+
+//Traces SamplesPerPass samples of the pixel, with consecutive sample indices from CurrentSample, so a pass of several
+//draws the same samples as that many passes of one and Accumulator.glsl only sees their sums
 void main()
 {
+	if(TileConverged(ivec2(gl_FragCoord.xy)))
+	{
+		FragmentColor = vec4(0.0);
+		PassMoments = vec4(0.0);										//No samples, Accumulator.glsl keeps the pixel as it is
+		return;
+	}
+
 	vec3 pixel_Position = positions;
 
 	Sphere Spheres[ModelCount];
@@ -18,11 +42,39 @@ void main()
 		Spheres[i].Position = View * Spheres[i].Position;
 	}
 
-	Ray TracingRay;
-	TracingRay.RayOrigin = pixel_Position;
-	TracingRay.RayColor = vec3(1.0, 1.0, 1.0);
+	const vec3 Luminance = vec3(0.2126, 0.7152, 0.0722);
+	vec4 ColorSum = vec4(0.0);
+	float SquareSum = 0.0;
+	vec3 AlbedoSum = vec3(0.0);
+	vec4 NormalDepthSum = vec4(0.0);
+	FirstHit first = NoHit();
+
+	for(int s = 0; s < SamplesPerPass; s++)
+	{
+		Ray TracingRay;
+		TracingRay.RayOrigin = pixel_Position;
+		TracingRay.RayColor = vec3(1.0, 1.0, 1.0);
+
+		int PathLength = 0;
+		FirstHit aov = NoHit();
+		vec3 color = TraceRay(TracingRay, Spheres, max_depth, StartSampler(ivec2(gl_FragCoord.xy), uint(CurrentSample + s)), PathLength, aov);
+		float luminance = dot(color, Luminance);
+		ColorSum += vec4(color, float(PathLength));					//Alpha carries the path lengths for RayTracer::AveragePathLength
+		SquareSum += luminance * luminance;
+
+		AlbedoSum += aov.Albedo;
+		NormalDepthSum += vec4(aov.Normal, aov.Depth);
+		if(s == 0)
+			first = aov;
+	}
+
+	FragmentColor = ColorSum;
+	PassMoments = vec4(SquareSum, float(SamplesPerPass), 0.0, 0.0);
 
-	vec3 color = TraceRay(TracingRay, Spheres, max_depth, float(CurrentSample));
-	vec4 colorOut = vec4(color, 1.0);
-	FragmentColor = colorOut;
-}
\ No newline at end of file
+	if(WriteAOVs)
+	{
+		AOVAlbedo = vec4(AlbedoSum, float(SamplesPerPass));
+		AOVNormal = NormalDepthSum;
+		AOVIds = vec4(float(first.MatIndex), float(first.Slot), 0.0, 1.0);
+	}
+}
@@ -1,7 +1,7 @@
 //!#version 400
 #include "Model.glsl"
 #include "Uniforms.glsl"
-#include "PRNG.glsl"
+#include "Sampler.glsl"
 
 in vec3 WorldX;
 in vec3 WorldY;
@@ -14,6 +14,7 @@ struct Ray
 	vec3 RayOrigin;
 	vec3 RayDir;
 	vec3 RayColor;
+	float ScatterPdf;										//Density the last bounce drew RayDir with, 0 when light sampling couldn't have
 };
 
 struct HitRecord
@@ -21,65 +22,80 @@ struct HitRecord
 	bool Hit;
 	float t;
 	Sphere HitSphere;
+	int Slot;
 };
 
+//First surface a camera path meets, or the sky for paths that miss everything. Both ids stay -1 on a miss
+struct FirstHit
+{
+	vec3 Albedo;
+	vec3 Normal;											//World space
+	float Depth;											//Along the view axis
+	int MatIndex;
+	int Slot;
+};
+
+//Photon state in the orbital plane of the hole, Velocity is d(Radial)/d(lambda) and h = |Radial x Velocity| is conserved
 struct BlackHoleInfo
 {
 	vec3 BlackHolePos;
 	float SchwarzschildRadius;
 	float PSphereRadius;
+	float CriticalImpact;
 	vec3 Radial;
 	float r;
-	vec3 UnitRadial;
-	vec3 Omega;
-	vec3 UnitAngular;
-	float rVel;
-	float k;
-	float PhiVel;
-	float rAcc;
+	vec3 Velocity;
+	float h;
 	bool Escaped;
+	bool Captured;
 	float dt;
+	float ClearRadius;
+	bool Deflect;
 	Sphere Influence;
 };
 
-void WorldColor(in vec3 direction, out vec4 color)
+const float GeodesicGrowth = 2.0;							//Extra step length per photon sphere radius of distance from it
+const float EscapeBend = 1e-3;								//Bending left below which an outgoing photon is sent straight
+const float RouletteSurvival = 0.95;							//Cap on the chance a path survives roulette, so clear glass can't keep it going
+const float SunCone = 6.0;									//Sun radii out to which the disk is evaluated and sampled, past it adds < 1e-12
+
+vec3 SunCameraDirection()
 {
-	direction = normalize(direction);
-	vec3 SunPos = normalize(cos(SunAltitude) * sin(SunAzimuthal) * WorldX + sin(SunAltitude) * WorldY + cos(SunAltitude) * cos(SunAzimuthal) * WorldZ);
-	vec4 SunColor = vec4(1.0, 1.0, 0.6, 1.0);
-	SunColor *= vec4(vec3(SunIntensity), 1.0);
+	return SunDirection.x * WorldX + SunDirection.y * WorldY + SunDirection.z * WorldZ;
+}
 
-	vec3 SunHaloPos = SunPos;
-	vec4 SunHaloColor = vec4(1.0, 1.0, 0.2, 1.0);
-	SunHaloColor *= vec4(vec3(2.0), 1.0);
-	float SunHaloRadius = 0.9;								//Should be in [0, 1], it is the cos of the angular radius
+//Sun disk at distance = 1 - cos of the angle to the sun
+vec3 SunRadiance(float distance)
+{
+	float t = exp(-1.0 * distance * distance / (SunRadius * SunRadius));
+	return vec3(1.0, 1.0, 0.6) * SunIntensity * sin(1.57 * t);
+}
 
-	float theta = dot(direction, WorldY);
-	float theta2 = dot(direction, SunHaloPos);
-	float theta3 = dot(direction, SunPos);
+//Solid angle density SampleSun draws directions with, a half normal in distance cut off at SunCone radii
+float SunPdf(float distance)
+{
+	if(distance >= SunCone * SunRadius)
+		return 0.0;
 
-	if(theta < 0.0)
-	{
-		float expVal = exp(-10.0 * theta * theta);
-		color = vec4(0.8 * expVal, 0.8 * expVal, expVal, 1.0);
-	}
+	const float pi = 3.1415926535;
+	return exp(-1.0 * distance * distance / (SunRadius * SunRadius)) / (pi * sqrt(pi) * SunRadius);
+}
 
-	else
-	{
-		theta = cos(theta);
-		float R = (theta - 0.2) * SkyVariation + 0.8 * (1.0 - SkyVariation);
-		float G = R;
-		float B = theta * SkyVariation + 1.0 - SkyVariation;
-		color = vec4(R, G, B, 1.0);
-	}
-	
-	color *= vec4(vec3(10.0), 1.0);
-	float t = exp(-1.0 * (theta2 - 1.0) * (theta2 - 1.0)/ (SunHaloRadius * SunHaloRadius));
-	SunHaloColor = (SunHaloColor) * sin(1.57 * t);
-	color += SunHaloColor;
+//DiskWeight scales the disk down for rays that could also have been drawn by SampleSun
+void WorldColor(in vec3 direction, in float DiskWeight, out vec4 color)
+{
+	direction = normalize(direction);
+	vec3 SunPos = SunCameraDirection();
+	float SunCosine = dot(direction, SunPos);
+
+	//Texel centers sit on the table samples, the first at -1 and the last at 1
+	float size = float(textureSize(SkyTexture, 0).x);
+	vec2 uv = ((0.5 * vec2(dot(direction, WorldY), SunCosine) + 0.5) * (size - 1.0) + 0.5) / size;
+	color = vec4(texture(SkyTexture, uv).rgb, 1.0);
 
-	t = exp(-1.0 * (theta3 - 1.0) * (theta3 - 1.0)/ (SunRadius * SunRadius));
-	color = (SunColor) * sin(1.57 * t) + color;
+	float distance = 1.0 - SunCosine;
+	if(distance < SunCone * SunRadius)
+		color.rgb += DiskWeight * SunRadiance(distance);
 }
 
 HitRecord HitPoint(in Ray ray, in Sphere sphere)
@@ -138,11 +154,189 @@ HitRecord HitPoint(in Ray ray, in Sphere sphere)
 	return record;
 }
 
+bool HitBox(in vec3 BoxMin, in vec3 BoxMax, in vec3 origin, in vec3 InvDir, in float t, out float entry)
+{
+	vec3 t0 = (BoxMin - origin) * InvDir;
+	vec3 t1 = (BoxMax - origin) * InvDir;
+	vec3 tNear = min(t0, t1);
+	vec3 tFar = max(t0, t1);
+
+	entry = max(max(tNear.x, tNear.y), max(tNear.z, 0.0));
+	float exit = min(min(tFar.x, tFar.y), min(tFar.z, t));
+	return entry <= exit * 1.00000024;
+}
+
+//The BVH is built over world space spheres, so the camera space ray is moved back into world space for the walk
+HitRecord HitPointBVH(Ray ray)
+{
+	HitRecord record;
+	record.Hit = false;
+	record.t = 99999.999;
+	record.Slot = -1;
+
+	mat3 CameraToWorld = transpose(View);
+	Ray WorldRay;
+	WorldRay.RayOrigin = CameraToWorld * ray.RayOrigin + CameraPos;
+	WorldRay.RayDir = CameraToWorld * ray.RayDir;
+	vec3 InvDir = 1.0 / WorldRay.RayDir;
+
+	float entry;
+	if(!HitBox(uintBitsToFloat(texelFetch(BVHNodes, 0).xyz), uintBitsToFloat(texelFetch(BVHNodes, 1).xyz), WorldRay.RayOrigin, InvDir, record.t, entry))
+		return record;
+
+	int stack[BVHStackSize];
+	int StackPointer = 0;
+	int current = 0;
+	int HitIndex = -1;
+
+	while(true)
+	{
+		int offset = int(texelFetch(BVHNodes, 2 * current).w);
+		int count = int(texelFetch(BVHNodes, 2 * current + 1).w);
+
+		if(count > 0)
+		{
+			for(int i = offset; i < offset + count; i++)
+			{
+				vec4 data = uintBitsToFloat(texelFetch(BVHSpheres, 2 * i));
+				Sphere sphere;
+				sphere.Position = data.xyz;
+				sphere.Radius = data.w;
+				HitRecord temp = HitPoint(WorldRay, sphere);
+
+				if(0.0 < temp.t && temp.t < record.t)
+				{
+					record.Hit = true;
+					record.t = temp.t;
+					HitIndex = i;
+				}
+			}
+		}
+
+		else
+		{
+			int first = current + 1;
+			int second = offset;
+
+			float FirstEntry, SecondEntry;
+			bool HitFirst = HitBox(uintBitsToFloat(texelFetch(BVHNodes, 2 * first).xyz), uintBitsToFloat(texelFetch(BVHNodes, 2 * first + 1).xyz), WorldRay.RayOrigin, InvDir, record.t, FirstEntry);
+			bool HitSecond = HitBox(uintBitsToFloat(texelFetch(BVHNodes, 2 * second).xyz), uintBitsToFloat(texelFetch(BVHNodes, 2 * second + 1).xyz), WorldRay.RayOrigin, InvDir, record.t, SecondEntry);
+
+			if(HitFirst && HitSecond)
+			{
+				if(SecondEntry < FirstEntry)
+				{
+					int temp = first;
+					first = second;
+					second = temp;
+				}
+
+				stack[StackPointer] = second;
+				StackPointer++;
+				current = first;
+				continue;
+			}
+
+			if(HitFirst || HitSecond)
+			{
+				current = HitFirst ? first : second;
+				continue;
+			}
+		}
+
+		if(StackPointer == 0)
+			break;
+
+		StackPointer--;
+		current = stack[StackPointer];
+	}
+
+	if(record.Hit)
+	{
+		vec4 data = uintBitsToFloat(texelFetch(BVHSpheres, 2 * HitIndex));
+		record.HitSphere.Position = View * (data.xyz - CameraPos);
+		record.HitSphere.Radius = data.w;
+		record.HitSphere.MatIndex = int(texelFetch(BVHSpheres, 2 * HitIndex + 1).x);
+		record.Slot = int(texelFetch(BVHSpheres, 2 * HitIndex + 1).y);
+	}
+
+	return record;
+}
+
+//Same walk as HitPointBVH without the ordering, it only has to find some sphere in the way closer than MaxT
+bool AnyHitBVH(Ray ray, float MaxT)
+{
+	mat3 CameraToWorld = transpose(View);
+	Ray WorldRay;
+	WorldRay.RayOrigin = CameraToWorld * ray.RayOrigin + CameraPos;
+	WorldRay.RayDir = CameraToWorld * ray.RayDir;
+	vec3 InvDir = 1.0 / WorldRay.RayDir;
+
+	int stack[BVHStackSize];
+	int StackPointer = 1;
+	stack[0] = 0;
+
+	while(StackPointer > 0)
+	{
+		StackPointer--;
+		int current = stack[StackPointer];
+
+		float entry;
+		if(!HitBox(uintBitsToFloat(texelFetch(BVHNodes, 2 * current).xyz), uintBitsToFloat(texelFetch(BVHNodes, 2 * current + 1).xyz), WorldRay.RayOrigin, InvDir, MaxT, entry))
+			continue;
+
+		int offset = int(texelFetch(BVHNodes, 2 * current).w);
+		int count = int(texelFetch(BVHNodes, 2 * current + 1).w);
+
+		if(count > 0)
+		{
+			for(int i = offset; i < offset + count; i++)
+			{
+				vec4 data = uintBitsToFloat(texelFetch(BVHSpheres, 2 * i));
+				Sphere sphere;
+				sphere.Position = data.xyz;
+				sphere.Radius = data.w;
+
+				float t = HitPoint(WorldRay, sphere).t;
+				if(0.0 < t && t < MaxT)
+					return true;
+			}
+
+			continue;
+		}
+
+		stack[StackPointer] = offset;
+		stack[StackPointer + 1] = current + 1;
+		StackPointer += 2;
+	}
+
+	return false;
+}
+
+bool AnyHit(Ray ray, Sphere Models[ModelCount], float MaxT)
+{
+	if(UseBVH)
+		return AnyHitBVH(ray, MaxT);
+
+	for(int i = 0; i < ModelCount; i++)
+	{
+		float t = HitPoint(ray, Models[i]).t;
+		if(0.0 < t && t < MaxT)
+			return true;
+	}
+
+	return false;
+}
+
 HitRecord HitPoint(Ray ray, Sphere Models[ModelCount])
 {
+	if(UseBVH)
+		return HitPointBVH(ray);
+
 	HitRecord record;
 	record.Hit = false;
 	record.t = 99999.999;
+	record.Slot = -1;
 
 	for(int i = 0; i < ModelCount; i++)
 	{
@@ -154,13 +348,14 @@ HitRecord HitPoint(Ray ray, Sphere Models[ModelCount])
 			record.Hit = true;
 			record.HitSphere = sphere;
 			record.t = temp.t;
+			record.Slot = i;
 		}
 	}
 
 	return record;
 }
 
-void Scatter(Diffuse diffuse, inout Ray ray, HitRecord record, in float seed)
+void Scatter(Diffuse diffuse, inout Ray ray, HitRecord record, in Sampler sampler)
 {
 	ray.RayOrigin = ray.RayOrigin + record.t * ray.RayDir;				//RayOrigin = Intersection
 
@@ -170,7 +365,7 @@ void Scatter(Diffuse diffuse, inout Ray ray, HitRecord record, in float seed)
 	if(dot(normal, ray.RayDir) > 0.0)
 		normal = -normal;
 
-	vec3 randVec = pcg3dSphere(ray.RayDir + seed + 1.0);
+	vec3 randVec = PointOnSphere(Sample2D(sampler, ScatterDimension));
 
 	randVec += normal;
 
@@ -190,7 +385,7 @@ float reflectance(float cosine, float IOR)
 	return r0 + (1.0 - r0) * pow(1.0 - cosine, 5.0);
 }
 
-void Scatter(Glass glass, inout Ray ray, HitRecord record, in float seed)
+void Scatter(Glass glass, inout Ray ray, HitRecord record, in Sampler sampler)
 {
 	ray.RayOrigin = ray.RayOrigin + record.t * ray.RayDir;				//RayOrigin = Intersection
 
@@ -208,7 +403,7 @@ void Scatter(Glass glass, inout Ray ray, HitRecord record, in float seed)
 	float cos_theta = min(dot(-ray.RayDir, normal), 1.0);
 	float sin_theta = sqrt(1.0 - cos_theta * cos_theta);
 
-	if(IOR * sin_theta > 1.0 || reflectance(cos_theta, IOR) > pcg3d(ray.RayDir + seed).x)
+	if(IOR * sin_theta > 1.0 || reflectance(cos_theta, IOR) > Sample1D(sampler, ScatterDimension))
 		ray.RayDir = reflect(ray.RayDir, normal);
 	
 	else
@@ -218,8 +413,257 @@ void Scatter(Glass glass, inout Ray ray, HitRecord record, in float seed)
 	ray.RayColor *= glass.Albedo;
 }
 
-void UpdateRay(inout Ray ray, HitRecord record, in float seed)
+//Same test as the Escaped of ComputeBlackHoleInfo, see CPU::StaysStraight
+bool StaysStraight(Ray ray)
+{
+	if(!RenderBlackHole)
+		return true;
+
+	Sphere influence;
+	influence.Position = View * (BlackHolePosition - CameraPos);
+	influence.Radius = MaxInfluenceRadius;
+	return length(ray.RayOrigin - influence.Position) > influence.Radius && !HitPoint(ray, influence).Hit;
+}
+
+float PowerHeuristic(float pdf, float OtherPdf)
+{
+	return pdf * pdf / (pdf * pdf + OtherPdf * OtherPdf);
+}
+
+bool SamplesSun()
+{
+	return SunIntensity > 0.0 && SunRadius > 0.0;
+}
+
+//1 - cos of the half angle a sphere subtends, written so far away lights keep their precision
+float ConeOneMinusCos(float distance2, float radius)
+{
+	float sin2 = radius * radius / distance2;
+	return sin2 / (1.0 + sqrt(max(1.0 - sin2, 0.0)));
+}
+
+//See LightTree::Importance, the tree is in world space so point is moved back there first
+float LightImportance(int node, vec3 point)
+{
+	uvec4 first = texelFetch(LightTreeNodes, 2 * node);
+	vec3 Min = uintBitsToFloat(first.xyz);
+	vec3 Max = uintBitsToFloat(texelFetch(LightTreeNodes, 2 * node + 1).xyz);
+	vec3 extent = Max - Min;
+	vec3 offset = 0.5 * (Min + Max) - point;
+	return uintBitsToFloat(first.w) / max(max(dot(offset, offset), 0.25 * dot(extent, extent)), 1.175494e-38);
+}
+
+float LeftProbability(int node, int child, vec3 point)
+{
+	float left = LightImportance(node + 1, point);
+	float right = LightImportance(child, point);
+	return left + right > 0.0 ? left / (left + right) : 0.5;
+}
+
+//Walks the light tree down from the root, see LightTree::Sample
+int PickLight(vec3 point, float u, out float PickPdf)
+{
+	const uint LeafBit = 0x80000000u;
+	vec3 WorldPoint = transpose(View) * point + CameraPos;
+
+	PickPdf = 1.0;
+	int node = 0;
+	uint child = texelFetch(LightTreeNodes, 1).w;
+	while((child & LeafBit) == 0u)
+	{
+		float left = LeftProbability(node, int(child), WorldPoint);
+		if(u < left)
+		{
+			u = u / left;
+			PickPdf *= left;
+			node++;
+		}
+
+		else
+		{
+			u = (u - left) / (1.0 - left);
+			PickPdf *= 1.0 - left;
+			node = int(child);
+		}
+
+		u = min(u, 0.99999994);
+		child = texelFetch(LightTreeNodes, 2 * node + 1).w;
+	}
+
+	return int(child & ~LeafBit);
+}
+
+//Probability PickLight picks the light at leaf with from point, see LightTree::Pdf
+float PickPdf(vec3 point, int leaf)
+{
+	vec3 WorldPoint = transpose(View) * point + CameraPos;
+
+	float pdf = 1.0;
+	int node = 0;
+	while(node != leaf)
+	{
+		int child = int(texelFetch(LightTreeNodes, 2 * node + 1).w);
+		float left = LeftProbability(node, child, WorldPoint);
+		if(leaf < child)
+		{
+			pdf *= left;
+			node++;
+		}
+
+		else
+		{
+			pdf *= 1.0 - left;
+			node = child;
+		}
+	}
+
+	return pdf;
+}
+
+//Solid angle density SampleLights draws ray.RayDir with toward light, the pick then a uniform direction in its cone
+float LightPdf(Ray ray, Sphere light, float PickPdf)
+{
+	vec3 axis = light.Position - ray.RayOrigin;
+	float distance2 = dot(axis, axis);
+	if(distance2 <= light.Radius * light.Radius || !StaysStraight(ray))
+		return 0.0;
+
+	const float pi = 3.1415926535;
+	return PickPdf / (2.0 * pi * ConeOneMinusCos(distance2, light.Radius));
+}
+
+//MIS weight of the sun disk for a ray leaving the sky, ScatterPdf is 0 unless the last bounce could have sampled it
+float SunWeight(Ray ray)
 {
+	if(ray.ScatterPdf <= 0.0 || !SamplesSun())
+		return 1.0;
+
+	float LightPdf = SunPdf(1.0 - dot(normalize(ray.RayDir), SunCameraDirection()));
+	return LightPdf > 0.0 ? PowerHeuristic(ray.ScatterPdf, LightPdf) : 1.0;
+}
+
+//MIS weight of an emissive sphere the scattered ray ran into, ray.RayOrigin is still the vertex it left from
+float EmissionWeight(Ray ray, HitRecord record)
+{
+	if(ray.ScatterPdf <= 0.0 || LightCount == 0)
+		return 1.0;
+
+	int leaf = texelFetch(LightLeaves, record.Slot).x;
+	if(leaf < 0)
+		return 1.0;
+
+	float pdf = LightPdf(ray, record.HitSphere, PickPdf(ray.RayOrigin, leaf));
+	return pdf > 0.0 ? PowerHeuristic(ray.ScatterPdf, pdf) : 1.0;
+}
+
+//Next event estimation toward the sun, see CPU::SampleSun
+vec3 SampleSun(Ray ray, vec3 normal, Sphere Models[ModelCount], in Sampler sampler)
+{
+	const float pi = 3.1415926535;
+	vec3 SunPos = SunCameraDirection();
+
+	vec2 disk = Sample2D(sampler, SunDimension);
+	float distance = SunRadius * sqrt(-log(1.0 - disk.x)) * abs(cos(2.0 * pi * Sample1D(sampler, SunAngleDimension)));
+	if(!(distance < SunCone * SunRadius))
+		return vec3(0.0);
+
+	vec3 tangent = normalize(cross(abs(dot(SunPos, WorldY)) < 0.999 ? WorldY : WorldX, SunPos));
+	vec3 bitangent = cross(SunPos, tangent);
+	float CosTheta = 1.0 - distance;
+	float SinTheta = sqrt(max(1.0 - CosTheta * CosTheta, 0.0));
+	float azimuthal = 2.0 * pi * disk.y;
+
+	Ray shadow;
+	shadow.RayOrigin = ray.RayOrigin;
+	shadow.RayDir = CosTheta * SunPos + SinTheta * (cos(azimuthal) * tangent + sin(azimuthal) * bitangent);
+
+	float cosine = dot(normal, shadow.RayDir);
+	if(cosine <= 0.0 || !StaysStraight(shadow) || AnyHit(shadow, Models, 99999.999))
+		return vec3(0.0);
+
+	float LightPdf = SunPdf(distance);
+	float BSDFPdf = cosine / pi;
+	return ray.RayColor * SunRadiance(distance) * (BSDFPdf / LightPdf * PowerHeuristic(LightPdf, BSDFPdf));
+}
+
+//Next event estimation toward one emissive sphere picked through the light tree, see CPU::SampleLights
+vec3 SampleLights(Ray ray, vec3 normal, Sphere Models[ModelCount], in Sampler sampler)
+{
+	const float pi = 3.1415926535;
+	float pick;
+	int index = PickLight(ray.RayOrigin, Sample1D(sampler, LightPickDimension), pick);
+	if(pick <= 0.0)
+		return vec3(0.0);
+
+	vec4 data = uintBitsToFloat(texelFetch(LightSpheres, 2 * index));
+	Sphere light;
+	light.Position = View * (data.xyz - CameraPos);
+	light.Radius = data.w;
+	light.MatIndex = int(texelFetch(LightSpheres, 2 * index + 1).x);
+
+	vec3 axis = light.Position - ray.RayOrigin;
+	float distance2 = dot(axis, axis);
+	if(distance2 <= light.Radius * light.Radius)
+		return vec3(0.0);
+
+	vec3 direction = axis / sqrt(distance2);
+	vec3 tangent = normalize(cross(abs(dot(direction, WorldY)) < 0.999 ? WorldY : WorldX, direction));
+	vec3 bitangent = cross(direction, tangent);
+	vec2 cone = Sample2D(sampler, LightConeDimension);
+	float OneMinusCos = cone.y * ConeOneMinusCos(distance2, light.Radius);
+	float CosTheta = 1.0 - OneMinusCos;
+	float SinTheta = sqrt(max(OneMinusCos * (2.0 - OneMinusCos), 0.0));
+	float azimuthal = 2.0 * pi * cone.x;
+
+	Ray shadow;
+	shadow.RayOrigin = ray.RayOrigin;
+	shadow.RayDir = CosTheta * direction + SinTheta * (cos(azimuthal) * tangent + sin(azimuthal) * bitangent);
+
+	float cosine = dot(normal, shadow.RayDir);
+	if(cosine <= 0.0)
+		return vec3(0.0);
+
+	HitRecord record = HitPoint(shadow, light);
+	if(!record.Hit || record.t <= 0.0 || AnyHit(shadow, Models, record.t - 0.001))
+		return vec3(0.0);
+
+	float pdf = LightPdf(shadow, light, pick);
+	if(pdf <= 0.0)
+		return vec3(0.0);
+
+	Material material = MaterialList[light.MatIndex];
+	float BSDFPdf = cosine / pi;
+	return ray.RayColor * material.Albedo * material.Emission * (BSDFPdf / pdf * PowerHeuristic(pdf, BSDFPdf));
+}
+
+//Only the fully rough lobe is Lambertian, see CPU::DirectLight
+vec3 DirectLight(inout Ray ray, HitRecord record, Diffuse diffuse, Sphere Models[ModelCount], in Sampler sampler)
+{
+	ray.ScatterPdf = 0.0;
+	if(diffuse.Roughness != 1.0)
+		return vec3(0.0);
+
+	const float pi = 3.1415926535;
+	vec3 normal = normalize(ray.RayOrigin - record.HitSphere.Position);
+	if(dot(normal, ray.RayDir) < 0.0)
+		normal = -normal;
+
+	ray.ScatterPdf = max(dot(normal, ray.RayDir), 0.0) / pi;
+
+	vec3 light = vec3(0.0);
+	if(SamplesSun())
+		light += SampleSun(ray, normal, Models, sampler);
+
+	if(LightCount > 0)
+		light += SampleLights(ray, normal, Models, sampler);
+
+	return light;
+}
+
+//Returns the light gathered by next event estimation at this vertex
+vec3 UpdateRay(inout Ray ray, HitRecord record, Sphere Models[ModelCount], in Sampler sampler)
+{
+
 	Material material = MaterialList[record.HitSphere.MatIndex];
 	switch(material.Type)
 	{
@@ -229,8 +673,8 @@ void UpdateRay(inout Ray ray, HitRecord record, in float seed)
 			diffuse.Albedo = material.Albedo;
 			diffuse.Roughness = material.Roughness;
 			diffuse.Emission = material.Emission;
-			Scatter(diffuse, ray, record, seed);
-			break;
+			Scatter(diffuse, ray, record, sampler);
+			return DirectLight(ray, record, diffuse, Models, sampler);
 		}
 
 		case GlassType:
@@ -238,40 +682,128 @@ void UpdateRay(inout Ray ray, HitRecord record, in float seed)
 			Glass glass;
 			glass.Albedo = material.Albedo;
 			glass.IOR = material.IOR;
-			Scatter(glass, ray, record, seed);
+			Scatter(glass, ray, record, sampler);
 			break;
 		}
 	}
+
+	ray.ScatterPdf = 0.0;
+	return vec3(0.0);
 }
 
-bool UpdateRay(inout Ray ray, inout BlackHoleInfo BHInfo)
+//Schwarzschild null geodesics written as a central force in flat space, r'' = h^2 (r - 1.5 Rs) / r^4 along the radial direction
+vec3 GeodesicAcceleration(vec3 Radial, float h2, float SchwarzschildRadius)
 {
-	BHInfo.UnitAngular = normalize(cross(BHInfo.Omega, BHInfo.Radial));
-	BHInfo.Radial += ray.RayDir * BHInfo.dt;
+	float r2 = dot(Radial, Radial);
+	return -1.5 * SchwarzschildRadius * h2 / (r2 * r2 * sqrt(r2)) * Radial;
+}
+
+//StepSize is the step on the photon sphere, where paths are unstable. It grows with the distance from there
+//but is capped so the direction turns by at most the angle one StepSize subtends on the photon sphere
+float GeodesicStep(BlackHoleInfo BHInfo, vec3 acceleration, float speed)
+{
+	float step = BHInfo.dt * (1.0 + GeodesicGrowth * abs(BHInfo.r - BHInfo.PSphereRadius) / BHInfo.PSphereRadius);
+	float TurnLimit = BHInfo.dt / BHInfo.PSphereRadius * speed * speed / max(length(acceleration), 1e-20);
+	return max(min(step, TurnLimit), 0.25 * BHInfo.dt) / speed;
+}
+
+//Distance of the asymptote from the hole, 0 for photons that never get out to infinity
+float ImpactParameter(BlackHoleInfo BHInfo)
+{
+	float VelocityInf2 = dot(BHInfo.Velocity, BHInfo.Velocity) - BHInfo.SchwarzschildRadius * BHInfo.h * BHInfo.h / (BHInfo.r * BHInfo.r * BHInfo.r);
+	return VelocityInf2 > 0.0 ? BHInfo.h / sqrt(VelocityInf2) : 0.0;
+}
+
+//Falling in under the critical impact parameter through a region no sphere reaches into always ends in the hole,
+//going out past the photon sphere r only grows, so the march stops once the bending left, at most Rs b / r^2, is negligible
+void ClassifyGeodesic(inout BlackHoleInfo BHInfo)
+{
+	float rVel = dot(BHInfo.Velocity, BHInfo.Radial);
+	float b = ImpactParameter(BHInfo);
+
+	if(rVel < 0.0)
+	{
+		BHInfo.Captured = BHInfo.r < BHInfo.PSphereRadius || (b < BHInfo.CriticalImpact && BHInfo.r <= BHInfo.ClearRadius);
+		return;
+	}
+
+	BHInfo.Escaped = BHInfo.r > BHInfo.Influence.Radius || (BHInfo.r > 2.0 * BHInfo.PSphereRadius && BHInfo.SchwarzschildRadius * b / (BHInfo.r * BHInfo.r) < EscapeBend);
+}
+
+//Adaptive velocity Verlet step, exact on h since the force is central. MaxStep keeps it short of the next sphere
+bool UpdateRay(inout Ray ray, inout BlackHoleInfo BHInfo, float MaxStep)
+{
+	float h2 = BHInfo.h * BHInfo.h;
+	float speed = length(BHInfo.Velocity);
+	vec3 acceleration = GeodesicAcceleration(BHInfo.Radial, h2, BHInfo.SchwarzschildRadius);
+	float dt = min(GeodesicStep(BHInfo, acceleration, speed), MaxStep / speed);
+
+	BHInfo.Velocity += 0.5 * dt * acceleration;
+	BHInfo.Radial += dt * BHInfo.Velocity;
+	BHInfo.Velocity += 0.5 * dt * GeodesicAcceleration(BHInfo.Radial, h2, BHInfo.SchwarzschildRadius);
 	BHInfo.r = length(BHInfo.Radial);
-	BHInfo.UnitRadial = BHInfo.Radial / BHInfo.r;
 
-	BHInfo.rVel = (BHInfo.rAcc * BHInfo.dt + BHInfo.rVel);
-	BHInfo.PhiVel = BHInfo.k / (BHInfo.r * BHInfo.r);
-	ray.RayDir = BHInfo.rVel * BHInfo.UnitRadial + BHInfo.r * BHInfo.PhiVel * BHInfo.UnitAngular;
-	ray.RayDir = normalize(ray.RayDir);
+	ray.RayDir = normalize(BHInfo.Velocity);
 	ray.RayOrigin = BHInfo.Radial + BHInfo.BlackHolePos;
-	BHInfo.rAcc = (BHInfo.r - BHInfo.PSphereRadius) * BHInfo.PhiVel * BHInfo.PhiVel;
 
-	if(BHInfo.r < BHInfo.PSphereRadius && BHInfo.rVel < 0.0)
+	ClassifyGeodesic(BHInfo);
+	return BHInfo.Captured;
+}
+
+//Linear in t, returns false for photons that are captured
+bool SweptAngle(float h, out float angle)
+{
+	angle = 0.0;
+	if(h < DeflectionCriticalH || DeflectionCriticalH >= MaxInfluenceRadius)
+		return false;
+
+	float t = sqrt(clamp((h - DeflectionCriticalH) / (MaxInfluenceRadius - DeflectionCriticalH), 0.0, 1.0));
+	float position = t * float(DeflectionSize - 1);
+	int index = min(int(position), DeflectionSize - 2);
+
+	angle = mix(texelFetch(DeflectionAngles, index).r, texelFetch(DeflectionAngles, index + 1).r, position - float(index));
+	return true;
+}
+
+//Moves a photon from outside the influence sphere straight to where it leaves it again, turned in its orbital plane by
+//the tabulated angle. Leaving, it has the speed and angle to the radial it came in with, mirrored. HitT keeps spheres
+//in front of the influence sphere in the way
+bool DeflectRay(inout Ray ray, inout BlackHoleInfo BHInfo, float HitT)
+{
+	BHInfo.Escaped = true;
+
+	float radius = BHInfo.Influence.Radius;
+	float along = -dot(BHInfo.Radial, ray.RayDir);
+	float discriminant = along * along - (BHInfo.r * BHInfo.r - radius * radius);
+	if(along <= 0.0 || discriminant <= 0.0 || HitT < along - sqrt(discriminant))
+		return false;
+
+	float angle;
+	if(!SweptAngle(BHInfo.h, angle))
+	{
+		BHInfo.Captured = true;
 		return true;
+	}
+
+	vec3 EntryRadial = normalize(BHInfo.Radial + (along - sqrt(discriminant)) * ray.RayDir);
+	vec3 EntryTangent = normalize(ray.RayDir - dot(ray.RayDir, EntryRadial) * EntryRadial);
+	vec3 ExitRadial = cos(angle) * EntryRadial + sin(angle) * EntryTangent;
+	vec3 ExitTangent = cos(angle) * EntryTangent - sin(angle) * EntryRadial;
 
-	BHInfo.Escaped = (BHInfo.rVel > 0.0) && (BHInfo.r > BHInfo.Influence.Radius);
+	float SinEntry = min(BHInfo.h / radius, 1.0);
+	ray.RayOrigin = BHInfo.BlackHolePos + radius * ExitRadial;
+	ray.RayDir = sqrt(1.0 - SinEntry * SinEntry) * ExitRadial + SinEntry * ExitTangent;
 	return false;
 }
 
-Ray GetRay(vec3 PixelPos, float seed)
+Ray GetRay(vec3 PixelPos, Sampler sampler)
 {
 	Ray ray;
 	ray.RayOrigin = PixelPos;
 	ray.RayColor = vec3(1.0);
+	ray.ScatterPdf = 0.0;
 
-	vec3 RayOffset = 2.0 * vec3(pcg3d(ray.RayOrigin + seed).xy, 0.0) - 1.0;			//[Improve]: Make native square sampling
+	vec3 RayOffset = vec3(2.0 * Sample2D(sampler, PixelDimension) - 1.0, 0.0);
 	float OffsetWidth = Sensor_Size / float(FramebufferWidth);
 	float OffsetHeight =  (Sensor_Size / AspectRatio) / float(FramebufferHeight);
 	RayOffset *= vec3(OffsetWidth, OffsetHeight, 0.0);
@@ -283,7 +815,7 @@ Ray GetRay(vec3 PixelPos, float seed)
 	FocusPoint /= LensFocalLength - Focal_Length;
 
 	float DiskRadius = Focal_Length / (2.0 * F_Stop);
-	vec3 DiskPoint = DiskRadius * pcg3dDisk(ray.RayOrigin + seed + 1.0) + vec3(0.0, 0.0, -Focal_Length);
+	vec3 DiskPoint = DiskRadius * PointOnDisk(Sample2D(sampler, LensDimension)) + vec3(0.0, 0.0, -Focal_Length);
 
 	ray.RayOrigin = DiskPoint;
 	ray.RayDir = normalize(FocusPoint - ray.RayOrigin);
@@ -296,24 +828,55 @@ void ComputeBlackHoleInfo(Ray ray, inout BlackHoleInfo BHInfo)
 {
 	BHInfo.Radial = ray.RayOrigin - BHInfo.BlackHolePos;
 	BHInfo.r = length(BHInfo.Radial);
-	BHInfo.UnitRadial = BHInfo.Radial / BHInfo.r;
+	BHInfo.Captured = false;
 
 	HitRecord record = HitPoint(ray, BHInfo.Influence);
 	BHInfo.Escaped = !record.Hit && (BHInfo.r > BHInfo.Influence.Radius);
 	if(BHInfo.Escaped)
 		return;
 
-	BHInfo.Omega = cross(BHInfo.Radial, ray.RayDir);
-	BHInfo.rVel = dot(ray.RayDir, BHInfo.UnitRadial);
-	BHInfo.k = BHInfo.r * length(ray.RayDir - BHInfo.rVel * BHInfo.UnitRadial);
-	BHInfo.PhiVel = BHInfo.k / (BHInfo.r * BHInfo.r);
-	BHInfo.rAcc = (BHInfo.r - BHInfo.PSphereRadius) * BHInfo.PhiVel;
-	BHInfo.UnitAngular = normalize(cross(BHInfo.Omega, BHInfo.Radial));
+	BHInfo.Velocity = ray.RayDir;
+	BHInfo.h = length(cross(BHInfo.Radial, ray.RayDir));
+	ClassifyGeodesic(BHInfo);
+}
+
+//Russian roulette on the throughput, survivors are scaled up by the chance they had so the estimate stays unbiased
+bool Survives(inout Ray ray, in Sampler sampler)
+{
+	float chance = min(max(ray.RayColor.x, max(ray.RayColor.y, ray.RayColor.z)), RouletteSurvival);
+	if(Sample1D(sampler, RouletteDimension) >= chance)
+		return false;
+
+	ray.RayColor /= chance;
+	return true;
+}
+
+//Adds the segments traced, black hole march steps included, to PathLength
+FirstHit NoHit()
+{
+	FirstHit aov;
+	aov.Albedo = vec3(0.0);
+	aov.Normal = vec3(0.0);
+	aov.Depth = 0.0;
+	aov.MatIndex = -1;
+	aov.Slot = -1;
+	return aov;
+}
+
+void RecordSurface(inout FirstHit aov, Ray ray, HitRecord record, Material material)
+{
+	vec3 point = ray.RayOrigin + record.t * ray.RayDir;
+	aov.Albedo = material.Albedo;
+	aov.Normal = transpose(View) * normalize(point - record.HitSphere.Position);
+	aov.Depth = -point.z;
+	aov.MatIndex = record.HitSphere.MatIndex;
+	aov.Slot = record.Slot;
 }
 
-vec3 TraceRay(in Ray ray, in Sphere Models[ModelCount], in int max_depth, in float seed)
+//aov is only filled in when WriteAOVs is set, otherwise it is left as it came in
+vec3 TraceRay(in Ray ray, in Sphere Models[ModelCount], in int max_depth, in Sampler sampler, inout int PathLength, inout FirstHit aov)
 {
-	ray = GetRay(ray.RayOrigin, seed);
+	ray = GetRay(ray.RayOrigin, sampler);
 
 	BlackHoleInfo BHInfo;
 	if(RenderBlackHole)
@@ -323,7 +886,10 @@ vec3 TraceRay(in Ray ray, in Sphere Models[ModelCount], in int max_depth, in flo
 		BHInfo.BlackHolePos = View * BHInfo.BlackHolePos;
 		BHInfo.SchwarzschildRadius = SchwarzsRadius;
 		BHInfo.PSphereRadius = BHInfo.SchwarzschildRadius * 3.0 / 2.0;
+		BHInfo.CriticalImpact = BHInfo.PSphereRadius * sqrt(3.0);
 		BHInfo.dt = StepSize;
+		BHInfo.ClearRadius = BlackHoleClearRadius;
+		BHInfo.Deflect = UseDeflection;
 
 		BHInfo.Influence.Position = BHInfo.BlackHolePos;
 		BHInfo.Influence.Radius = MaxInfluenceRadius;
@@ -331,38 +897,57 @@ vec3 TraceRay(in Ray ray, in Sphere Models[ModelCount], in int max_depth, in flo
 		ComputeBlackHoleInfo(ray, BHInfo);
 	}
 
+	vec3 light = vec3(0.0);
 	for(int depth = 0; depth < max_depth; depth++)
 	{
+		StartBounce(sampler, depth);
+		PathLength++;
 		HitRecord record = HitPoint(ray, Models);
 
 		if(record.t > 2.0 * BHInfo.dt && !BHInfo.Escaped && RenderBlackHole)
 		{
-			if(UpdateRay(ray, BHInfo))
-				return vec3(0.0);
+			ray.ScatterPdf = 0.0;
+			if(BHInfo.Deflect && BHInfo.r > BHInfo.Influence.Radius)
+			{
+				if(DeflectRay(ray, BHInfo, record.t))
+					return light;
+				continue;
+			}
+
+			if(BHInfo.Captured || UpdateRay(ray, BHInfo, 0.5 * record.t))
+				return light;
 			continue;
 		}
 
 		if(!record.Hit)
 		{
 			vec4 color;
-			WorldColor(ray.RayDir, color);
+			WorldColor(ray.RayDir, SunWeight(ray), color);
+			if(WriteAOVs && aov.MatIndex < 0)
+				aov.Albedo = min(color.rgb, vec3(1.0));
+
 			color *= vec4(ray.RayColor, 1.0);
-			return color.rgb;
+			return light + color.rgb;
 		}
 
 		Material material = MaterialList[record.HitSphere.MatIndex];
+		if(WriteAOVs && aov.MatIndex < 0)
+			RecordSurface(aov, ray, record, material);
 
 		if(material.Emission != 0.0)
 		{
-			ray.RayColor *= material.Albedo * material.Emission;
-			return ray.RayColor;
+			ray.RayColor *= material.Albedo * material.Emission * EmissionWeight(ray, record);
+			return light + ray.RayColor;
 		}
 
-		UpdateRay(ray, record, seed);
+		light += UpdateRay(ray, record, Models, sampler);
 
 		if(RenderBlackHole)
 			ComputeBlackHoleInfo(ray, BHInfo);
+
+		if(depth + 1 >= RouletteDepth && !Survives(ray, sampler))
+			return light;
 	}
 
-	return vec3(0.0);
+	return light;
 }
\ No newline at end of file
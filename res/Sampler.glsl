@@ -0,0 +1,148 @@
+//Bit for bit the same as Sampler.cpp, see Sampler.h
+const int RandomSampler = 0;
+const int SobolSampler = 1;
+const int BlueNoiseSampler = 2;
+const int SamplerType = 1;
+
+const uint PixelDimension = 0u;
+const uint LensDimension = 2u;
+const uint CameraDimensions = 4u;
+
+const uint ScatterDimension = 0u;
+const uint SunDimension = 2u;
+const uint SunAngleDimension = 4u;
+const uint LightPickDimension = 5u;
+const uint LightConeDimension = 6u;
+const uint RouletteDimension = 8u;
+const uint BounceDimensions = 10u;
+
+const int BlueNoiseBits = 6;
+
+struct Sampler
+{
+	ivec2 Pixel;
+	uint Seed;
+	uint Index;
+	uint ReversedIndex;
+	uint Base;
+};
+
+uint Hash(uint x)
+{
+	x ^= x >> 16u;
+	x *= 0x7FEB352Du;
+	x ^= x >> 15u;
+	x *= 0x846CA68Bu;
+	x ^= x >> 16u;
+	return x;
+}
+
+uint HashCombine(uint seed, uint value)
+{
+	return seed ^ (value + 0x9E3779B9u + (seed << 6u) + (seed >> 2u));
+}
+
+uint LaineKarras(uint x, uint seed)
+{
+	x += seed;
+	x ^= x * 0x6C50B47Cu;
+	x ^= x * 0xB82F1E52u;
+	x ^= x * 0xC7AFE638u;
+	x ^= x * 0x8D22F6E6u;
+	return x;
+}
+
+uint Pascal(uint x)
+{
+	x ^= (x & 0xAAAAAAAAu) >> 1u;
+	x ^= (x & 0xCCCCCCCCu) >> 2u;
+	x ^= (x & 0xF0F0F0F0u) >> 4u;
+	x ^= (x & 0xFF00FF00u) >> 8u;
+	x ^= (x & 0xFFFF0000u) >> 16u;
+	return x;
+}
+
+float ToUnit(uint x)
+{
+	return float(x >> 8u) * (1.0 / 16777216.0);
+}
+
+Sampler StartSampler(ivec2 pixel, uint SampleIndex)
+{
+	Sampler sampler;
+	sampler.Pixel = pixel;
+	sampler.Seed = SamplerType == BlueNoiseSampler ? 0x5EED5EEDu : HashCombine(Hash(uint(pixel.x)), uint(pixel.y));
+	sampler.Index = SampleIndex;
+	sampler.ReversedIndex = bitfieldReverse(SampleIndex);
+	sampler.Base = 0u;
+	return sampler;
+}
+
+void StartBounce(inout Sampler sampler, int depth)
+{
+	sampler.Base = CameraDimensions + uint(depth) * BounceDimensions;
+}
+
+uint Draw(Sampler sampler, uint pair, uint seed, uint index, uint component)
+{
+	if(SamplerType == RandomSampler)
+		return Hash(HashCombine(HashCombine(seed, component), sampler.Index));
+
+	uint value = bitfieldReverse(LaineKarras(component == 0u ? index : Pascal(index), HashCombine(seed, component)));
+
+	if(SamplerType == BlueNoiseSampler)
+	{
+		uint mask = (1u << uint(BlueNoiseBits)) - 1u;
+		uint offset = Hash(HashCombine(pair, component));
+		uint x = (uint(sampler.Pixel.x) + offset) & mask;
+		uint y = (uint(sampler.Pixel.y) + (offset >> 16u)) & mask;
+		value += texelFetch(BlueNoiseRanks, int((y << uint(BlueNoiseBits)) | x)).x << uint(32 - 2 * BlueNoiseBits);
+	}
+
+	return value;
+}
+
+//Both components of a pair share the shuffled index
+uint ShuffledIndex(Sampler sampler, uint seed)
+{
+	return SamplerType == RandomSampler ? 0u : bitfieldReverse(LaineKarras(sampler.ReversedIndex, seed));
+}
+
+float Sample1D(Sampler sampler, uint dimension)
+{
+	uint pair = (sampler.Base + dimension) >> 1u;
+	uint seed = HashCombine(sampler.Seed, pair);
+	return ToUnit(Draw(sampler, pair, seed, ShuffledIndex(sampler, seed), dimension & 1u));
+}
+
+vec2 Sample2D(Sampler sampler, uint dimension)
+{
+	uint pair = (sampler.Base + dimension) >> 1u;
+	uint seed = HashCombine(sampler.Seed, pair);
+	uint index = ShuffledIndex(sampler, seed);
+	return vec2(ToUnit(Draw(sampler, pair, seed, index, 0u)), ToUnit(Draw(sampler, pair, seed, index, 1u)));
+}
+
+//Radius linear in random.y, so the points crowd toward the middle rather than covering the disk evenly
+vec3 PointOnDisk(vec2 random)
+{
+	const float pi = 3.1415926535;
+	float theta = 2.0 * pi * random.x;
+	float r = random.y;
+
+	return vec3(r * cos(theta), r * sin(theta), 0.0);
+}
+
+vec3 PointOnSphere(vec2 random)
+{
+	const float pi = 3.1415926535;
+	float azimuthal = 2.0 * pi * random.x;
+	float A = 2.0 * random.y - 1.0;
+
+	float Z = -A;
+
+	A *= A;
+	A = sqrt(1.0 - A);
+
+	return vec3(A * cos(azimuthal), A * sin(azimuthal), Z);
+}
\ No newline at end of file
@@ -5,7 +5,9 @@ uniform float Focus_Dist;
 uniform float F_Stop;
 
 uniform int CurrentSample;
+uniform int SamplesPerPass;
 uniform int max_depth;
+uniform int RouletteDepth;
 uniform int FramebufferWidth;
 uniform int FramebufferHeight;
 uniform float AspectRatio;
@@ -15,13 +17,39 @@ uniform Sphere SphereList[ModelCount];
 const int MaterialCount = 1;
 uniform Material MaterialList[MaterialCount];
 
+const bool UseBVH = false;
+const int BVHStackSize = 64;
+uniform usamplerBuffer BVHNodes;								//Two texels per node, Min bits + Offset then Max bits + Count
+uniform usamplerBuffer BVHSpheres;								//Two texels per leaf entry, Position + Radius bits then MatIndex
+
 uniform vec3 BlackHolePosition;
 uniform float SchwarzsRadius;
 uniform float MaxInfluenceRadius;
 uniform float StepSize;
+uniform float BlackHoleClearRadius;							//Distance from the hole to the nearest sphere surface
+uniform bool UseDeflection;									//No sphere reaches into the influence sphere, so photons entering it use the table
+uniform samplerBuffer DeflectionAngles;						//Swept angle at t = sqrt((h - hc) / (R - hc)), see DeflectionTable.h
+uniform int DeflectionSize;
+uniform float DeflectionCriticalH;
 
 uniform float SunRadius;										//Should be in [0, 1], it is the cos of the angular radius
 uniform float SunIntensity;
 uniform float SunAltitude;
 uniform float SunAzimuthal;
-uniform float SkyVariation;
\ No newline at end of file
+uniform float SkyVariation;
+uniform vec3 SunDirection;									//World space, baked into SkyTexture along with the altitude, azimuthal and variation
+uniform sampler2D SkyTexture;									//Sky and halo over height and sun cosine, see SkyTable.h
+
+uniform usamplerBuffer LightSpheres;							//Emissive spheres in world space, packed like BVHSpheres, see LightList.h
+uniform int LightCount;
+uniform usamplerBuffer LightTreeNodes;							//Two texels per node, Min bits + Power bits then Max bits + Child, see LightTree.h
+uniform isamplerBuffer LightLeaves;								//Light tree leaf of every sphere slot, -1 for the ones that don't emit
+
+uniform usamplerBuffer BlueNoiseRanks;							//Rank of every pixel of the 64 x 64 mask, see Sampler.h
+
+const int AdaptiveTileLevel = 4;								//Tiles of 16 x 16 pixels
+const int AdaptiveMinSamples = 16;
+uniform sampler2D PixelMoments;								//Accumulated moments, see Accumulator.glsl, mip mapped so a level averages whole tiles
+uniform float NoiseThreshold;									//Relative error converged tiles stop at, 0 traces every pixel
+
+const bool WriteAOVs = false;									//First hit albedo, normal, depth and ids to the extra attachments, see Ray Trace.frag
\ No newline at end of file